@@ -0,0 +1,496 @@
+#ifndef EC_ASYNC_LOG_H
+#define EC_ASYNC_LOG_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "ec_sample.h"
+#include "ec_spsc_ring.h"
+#include "ec_binlog.h"
+#include "ec_csv.h"
+#include "ec_gorilla.h"
+#include "ec_wal.h"
+#include "ec_log_index.h"
+#include "ec_ingest_compress.h"
+#include "ec_rollup.h"
+#include "ec_log_segment.h"
+#include "ec_log_manifest.h"
+#include "ec_log_rotate.h"
+
+// ===========================
+// ASYNCHRONOUS LOG WRITER
+// ===========================
+// The acquisition loop pushes fixed-size SampleRecords into a lock-free
+// SPSC ring and returns immediately. A dedicated writer thread drains the
+// ring in batches and formats them, so a stalled filesystem (e.g. /mnt/c
+// under WSL) only grows the queue instead of delaying the next Modbus
+// read. If the ring is full the record is dropped and counted rather than
+// blocking acquisition.
+//
+// When drained records reach the OS and the disk is set by the
+// DurabilityPolicy below.
+//
+// Per drained sample the writer thread, in order:
+//   1. updates the 1 min / 1 h rollup tiers (every sample, ec_rollup.h)
+//   2. runs the optional ingest compressor (ec_ingest_compress.h)
+//   3. indexes and appends the samples it keeps (LOG.idx, ec_log_index.h),
+//      first rotating the segment if the RotationPolicy says it is full
+//      (ec_log_rotate.h)
+//
+// request_reopen() (SIGHUP) makes the writer thread finish the files at
+// the log path and open whatever is there now, so an external logrotate
+// can move the log away without restarting the logger.
+
+enum LogFormat {
+    LOG_FORMAT_CSV = 0,       // Text CSV (ec_data_log.csv)
+    LOG_FORMAT_BINARY = 1,    // Columnar binary log (ec_data_log.ecb)
+    LOG_FORMAT_GORILLA = 2,   // Compressed time-series log (ec_data_log.ecg)
+    LOG_FORMAT_WAL = 3        // Crash-safe write-ahead log (ec_data_log.ecw)
+};
+
+const size_t LOG_RING_CAPACITY = 4096;    // Records (~1 hour at 1 Hz)
+const size_t LOG_BATCH_MAX = 256;         // Records per ring drain
+const int LOG_WRITER_IDLE_MS = 100;       // Writer wake-up period when idle
+
+// ===========================
+// DURABILITY POLICY
+// ===========================
+// flush = write() buffered rows to the OS (survives a process crash)
+// sync  = fdatasync() (survives power loss / OS crash)
+//
+// A flush happens when either flush limit is reached, a sync when either
+// sync limit is reached (a sync always flushes first). 0 disables a limit.
+// The default matches the original logger: every row reaches the OS
+// immediately, nothing is ever fsynced.
+struct DurabilityPolicy {
+    uint32_t flush_every_records = 1;   // Group commit size
+    uint32_t flush_interval_ms = 0;     // Max time a record may sit in user space
+    uint32_t sync_every_records = 0;    // fdatasync after this many records
+    uint32_t sync_interval_ms = 0;      // fdatasync at least this often (if dirty)
+};
+
+struct LogWriterStats {
+    uint64_t pushed = 0;         // Records accepted into the ring
+    uint64_t dropped = 0;        // Records lost to ring overflow
+    uint64_t written = 0;        // Records handed to the sink
+    uint64_t flushes = 0;        // write() group commits
+    uint64_t syncs = 0;          // fdatasync() calls
+    uint64_t write_errors = 0;   // Failed flushes/syncs
+    uint64_t compressed = 0;     // Samples dropped by ingest compression
+    uint64_t rotations = 0;      // Segments closed by the rotation policy
+    uint64_t reopens = 0;        // Files reopened on request (SIGHUP)
+    size_t depth = 0;            // Records currently queued
+    size_t max_depth = 0;        // High-water mark of the queue
+};
+
+class AsyncLogWriter {
+public:
+    AsyncLogWriter() {}
+    ~AsyncLogWriter() { stop(); }
+    AsyncLogWriter(const AsyncLogWriter &) = delete;
+    AsyncLogWriter &operator=(const AsyncLogWriter &) = delete;
+
+    bool open(LogFormat format, const std::string &path, bool with_index = true,
+              bool with_rollups = true) {
+        format_ = format;
+        path_ = path;
+        with_index_ = with_index;
+        with_rollups_ = with_rollups;
+        bool ok = open_segment();
+        if (ok && with_rollups) rollups_.open(path);
+        return ok;
+    }
+
+    // CSV Timestamp column precision (binary formats always keep nanoseconds).
+    // Call before start().
+    void set_timestamp_precision(TimestampPrecision precision) {
+        csv_.set_timestamp_precision(precision);
+    }
+
+    // Segment rotation (ec_log_rotate.h). Call before start().
+    void set_rotation(const RotationPolicy &rotation) {
+        rotation_ = rotation;
+    }
+
+    void start(const DurabilityPolicy &policy,
+               const IngestCompressionConfig &compression = IngestCompressionConfig()) {
+        policy_ = policy;
+        compressor_.configure(compression);
+        if (rotation_.enabled()) {
+            manifest_.open(path_);
+            if (rotation_.compress) segment_compressor_.start(&manifest_);
+        }
+        running_ = true;
+        thread_ = std::thread(&AsyncLogWriter::run, this);
+    }
+
+    // Producer thread only (the pipeline's sink stage). Never blocks,
+    // never allocates.
+    bool push(const SampleRecord &rec) {
+        if (!ring_.try_push(rec)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        pushed_.fetch_add(1, std::memory_order_relaxed);
+        size_t depth = ring_.size();
+        if (depth > max_depth_.load(std::memory_order_relaxed)) {
+            max_depth_.store(depth, std::memory_order_relaxed);
+        }
+        wake_.notify_one();
+        return true;
+    }
+
+    // Any thread: close and reopen the log files before the next write
+    void request_reopen() {
+        reopen_.store(true, std::memory_order_relaxed);
+        wake_.notify_one();
+    }
+
+    // Drain everything still queued, flush, sync if the policy syncs at all,
+    // and close the sink
+    void stop() {
+        if (!thread_.joinable()) return;
+        running_ = false;
+        wake_.notify_one();
+        thread_.join();
+        segment_compressor_.stop();
+        csv_.close();
+        binary_.close();
+        gorilla_.close();
+        wal_.close();
+        index_.close();
+        rollups_.close();
+    }
+
+    LogWriterStats stats() const {
+        LogWriterStats s;
+        s.pushed = pushed_.load(std::memory_order_relaxed);
+        s.dropped = dropped_.load(std::memory_order_relaxed);
+        s.written = written_.load(std::memory_order_relaxed);
+        s.flushes = flushes_.load(std::memory_order_relaxed);
+        s.syncs = syncs_.load(std::memory_order_relaxed);
+        s.write_errors = write_errors_.load(std::memory_order_relaxed);
+        s.compressed = compressed_.load(std::memory_order_relaxed);
+        s.rotations = rotations_.load(std::memory_order_relaxed);
+        s.reopens = reopens_.load(std::memory_order_relaxed);
+        s.depth = ring_.size();
+        s.max_depth = max_depth_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    SpscRing<SampleRecord, LOG_RING_CAPACITY> ring_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+
+    DurabilityPolicy policy_;
+    LogFormat format_ = LOG_FORMAT_CSV;
+    std::string path_;
+    bool with_index_ = true;
+    bool with_rollups_ = true;
+    CsvLogWriter csv_;
+    BinaryLogWriter binary_;
+    GorillaLogWriter gorilla_;
+    WalLogWriter wal_;
+    LogIndexWriter index_;
+    RollupSet rollups_;
+    IngestCompressor compressor_;
+    RotationPolicy rotation_;
+    SegmentManifest manifest_;
+    SegmentCompressor segment_compressor_;
+    SampleRecord batch_[LOG_BATCH_MAX];
+
+    // Writer-thread state
+    uint32_t unflushed_ = 0;             // Records buffered in user space
+    uint32_t unsynced_ = 0;              // Records flushed but not fdatasync'ed
+    Clock::time_point first_unflushed_;
+    Clock::time_point last_sync_;
+    SegmentStats segment_;               // Active segment, for the manifest
+    bool segment_has_records_ = false;
+    int64_t rotate_at_ns_ = 0;           // Hour/day boundary (0 = not yet known)
+
+    std::atomic<uint64_t> pushed_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> written_{0};
+    std::atomic<uint64_t> flushes_{0};
+    std::atomic<uint64_t> syncs_{0};
+    std::atomic<uint64_t> write_errors_{0};
+    std::atomic<uint64_t> compressed_{0};
+    std::atomic<uint64_t> rotations_{0};
+    std::atomic<uint64_t> reopens_{0};
+    std::atomic<bool> reopen_{false};
+    std::atomic<size_t> max_depth_{0};
+
+    // Open the sink and index at path_, resuming an existing segment
+    bool open_segment() {
+        bool ok;
+        switch (format_) {
+            case LOG_FORMAT_BINARY:
+                ok = binary_.open(path_);
+                segment_has_records_ = binary_.has_records();
+                break;
+            case LOG_FORMAT_GORILLA:
+                ok = gorilla_.open(path_);
+                segment_has_records_ = gorilla_.has_records();
+                break;
+            case LOG_FORMAT_WAL:
+                ok = wal_.open(path_);
+                segment_has_records_ = wal_.has_records();
+                break;
+            default:
+                ok = csv_.open(path_);
+                segment_has_records_ = csv_.has_rows();
+                break;
+        }
+        if (ok && with_index_) {
+            uint64_t offset;
+            uint32_t skip;
+            next_position(&offset, &skip);
+            index_.open(log_index_path(path_), format_, segment_has_records_, offset, skip);
+        }
+
+        // Ranges of the records already there come from the index, if any
+        segment_ = SegmentStats();
+        rotate_at_ns_ = 0;
+        if (ok && segment_has_records_) {
+            std::vector<LogIndexEntry> entries;
+            if (with_index_ && log_index_load(log_index_path(path_), format_, entries)) {
+                segment_.seed(entries);
+            }
+            if (segment_.records == 0) segment_.ranges_known = false;
+        }
+        return ok;
+    }
+
+    void run() {
+        last_sync_ = Clock::now();
+        while (true) {
+            if (reopen_.exchange(false, std::memory_order_relaxed)) reopen();
+            size_t n = ring_.pop_batch(batch_, LOG_BATCH_MAX);
+            if (n > 0) stage(n);
+
+            Clock::time_point now = Clock::now();
+            if (sync_due(now)) {
+                flush();
+                sync(now);
+            } else if (flush_due(now)) {
+                flush();
+            }
+
+            if (n > 0) continue;
+            if (!running_.load()) break;   // Ring drained and stop requested
+
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            wake_.wait_for(lock, next_deadline(now));
+        }
+
+        // Final drain: release the sample the compressor holds back and never
+        // leave accepted records in user space
+        SampleRecord kept[2];
+        size_t n_kept = compressor_.finish(kept);
+        for (size_t i = 0; i < n_kept; i++) append(kept[i]);
+        unflushed_ += n_kept;
+        flush();
+        if (policy_.sync_every_records || policy_.sync_interval_ms) sync(Clock::now());
+    }
+
+    void stage(size_t n) {
+        if (unflushed_ == 0) first_unflushed_ = Clock::now();
+        SampleRecord kept[2];
+        uint64_t dropped = 0;
+        for (size_t i = 0; i < n; i++) {
+            rollups_.add(batch_[i], batch_[i].standard_ec);
+            size_t n_kept = compressor_.process(batch_[i], kept);
+            if (n_kept == 0) dropped++;
+            for (size_t k = 0; k < n_kept; k++) append(kept[k]);
+        }
+        unflushed_ += n;
+        if (dropped) compressed_.fetch_add(dropped, std::memory_order_relaxed);
+    }
+
+    void append(const SampleRecord &rec) {
+        if (rotation_.enabled()) {
+            if (segment_has_records_ && rotation_due(rec)) rotate();
+            if (rotation_.interval != ROTATE_NEVER && rotate_at_ns_ == 0) {
+                int64_t first = segment_.records ? segment_.first_ns : rec.timestamp_ns;
+                rotate_at_ns_ = rotation_boundary_ns(first, rotation_.interval);
+            }
+            segment_.add(rec);
+            segment_has_records_ = true;
+        }
+        if (index_.is_open()) {
+            uint64_t offset;
+            uint32_t skip;
+            next_position(&offset, &skip);
+            index_.add(rec, offset, skip);
+        }
+        switch (format_) {
+            case LOG_FORMAT_BINARY:  binary_.append(rec); break;
+            case LOG_FORMAT_GORILLA: gorilla_.append(rec); break;
+            case LOG_FORMAT_WAL:     wal_.append(rec); break;
+            default:                 csv_.append(rec); break;
+        }
+        written_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void next_position(uint64_t *offset, uint32_t *skip) {
+        switch (format_) {
+            case LOG_FORMAT_BINARY:  binary_.next_position(offset, skip); break;
+            case LOG_FORMAT_GORILLA: gorilla_.next_position(offset, skip); break;
+            case LOG_FORMAT_WAL:     wal_.next_position(offset, skip); break;
+            default:                 csv_.next_position(offset, skip); break;
+        }
+    }
+
+    bool rotation_due(const SampleRecord &rec) {
+        if (rotation_.max_bytes) {
+            uint64_t offset;
+            uint32_t skip;
+            next_position(&offset, &skip);
+            if (offset >= rotation_.max_bytes) return true;
+        }
+        return rotate_at_ns_ && rec.timestamp_ns >= rotate_at_ns_;
+    }
+
+    // Close the active segment, rename it aside under the local time of its
+    // first record, list it in the manifest, queue it for compression and
+    // start an empty segment under path_
+    void rotate() {
+        flush_outputs();
+        sync_outputs();
+        unsynced_ = 0;
+        close_segment();
+
+        time_t first = segment_.records ? static_cast<time_t>(segment_.first_ns / 1000000000LL)
+                                        : time(nullptr);
+        std::string closed = log_free_segment_path(path_, first);
+        if (log_rename_segment(path_, closed)) {
+            ManifestEntry entry;
+            entry.segment = log_path_base(closed);
+            entry.stats = segment_;
+            manifest_.add(entry);
+            if (rotation_.compress && SegmentCompressor::compressible(closed)) {
+                segment_compressor_.enqueue(closed);
+            }
+            rotations_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            write_errors_.fetch_add(1, std::memory_order_relaxed);
+        }
+        // On a failed rename this resumes the same file
+        if (!open_segment()) write_errors_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Finish the files at path_ and open what is there now: a new file if
+    // they were moved away, the same ones (resumed) if not
+    void reopen() {
+        flush();
+        sync(Clock::now());
+        close_segment();
+        if (with_rollups_) {
+            rollups_.close();
+            rollups_.open(path_);
+        }
+        if (!open_segment()) write_errors_.fetch_add(1, std::memory_order_relaxed);
+        reopens_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void close_segment() {
+        switch (format_) {
+            case LOG_FORMAT_BINARY:  binary_.close(); break;
+            case LOG_FORMAT_GORILLA: gorilla_.close(); break;
+            case LOG_FORMAT_WAL:     wal_.close(); break;
+            default:                 csv_.close(); break;
+        }
+        index_.close();
+    }
+
+    bool flush_due(Clock::time_point now) const {
+        if (unflushed_ == 0) return false;
+        if (policy_.flush_every_records && unflushed_ >= policy_.flush_every_records) return true;
+        if (policy_.flush_interval_ms &&
+            now - first_unflushed_ >= std::chrono::milliseconds(policy_.flush_interval_ms)) return true;
+        // No limits configured at all: behave like flush-every-record
+        return !policy_.flush_every_records && !policy_.flush_interval_ms;
+    }
+
+    bool sync_due(Clock::time_point now) const {
+        uint32_t dirty = unsynced_ + unflushed_;
+        if (dirty == 0) return false;
+        if (policy_.sync_every_records && dirty >= policy_.sync_every_records) return true;
+        if (policy_.sync_interval_ms &&
+            now - last_sync_ >= std::chrono::milliseconds(policy_.sync_interval_ms)) return true;
+        return false;
+    }
+
+    void flush() {
+        if (unflushed_ == 0) return;
+        flush_outputs();
+        flushes_.fetch_add(1, std::memory_order_relaxed);
+        unsynced_ += unflushed_;
+        unflushed_ = 0;
+    }
+
+    void sync(Clock::time_point now) {
+        last_sync_ = now;
+        if (unsynced_ == 0) return;
+        sync_outputs();
+        syncs_.fetch_add(1, std::memory_order_relaxed);
+        unsynced_ = 0;
+    }
+
+    void flush_outputs() {
+        bool ok;
+        switch (format_) {
+            case LOG_FORMAT_BINARY:  ok = binary_.flush(); break;
+            case LOG_FORMAT_GORILLA: ok = gorilla_.flush(); break;
+            case LOG_FORMAT_WAL:     ok = wal_.flush(); break;
+            default:                 ok = csv_.flush(); break;
+        }
+        if (ok) ok = index_.flush();   // Index only after the data it points to
+        if (!rollups_.flush()) ok = false;
+        if (!ok) write_errors_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // A rotated segment is complete on disk before it is renamed
+    void sync_outputs() {
+        bool ok;
+        switch (format_) {
+            case LOG_FORMAT_BINARY:  ok = binary_.sync(); break;
+            case LOG_FORMAT_GORILLA: ok = gorilla_.sync(); break;
+            case LOG_FORMAT_WAL:     ok = wal_.sync(); break;
+            default:                 ok = csv_.sync(); break;
+        }
+        if (ok) ok = index_.sync();
+        if (!rollups_.sync()) ok = false;
+        if (!ok) write_errors_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Sleep until new records arrive or the nearest time-based limit expires
+    std::chrono::milliseconds next_deadline(Clock::time_point now) const {
+        Clock::duration wait = std::chrono::milliseconds(LOG_WRITER_IDLE_MS);
+        if (unflushed_ && policy_.flush_interval_ms) {
+            Clock::duration left = first_unflushed_ +
+                std::chrono::milliseconds(policy_.flush_interval_ms) - now;
+            if (left < wait) wait = left;
+        }
+        if ((unflushed_ || unsynced_) && policy_.sync_interval_ms) {
+            Clock::duration left = last_sync_ +
+                std::chrono::milliseconds(policy_.sync_interval_ms) - now;
+            if (left < wait) wait = left;
+        }
+        if (wait < Clock::duration::zero()) wait = Clock::duration::zero();
+        return std::chrono::duration_cast<std::chrono::milliseconds>(wait) +
+               std::chrono::milliseconds(1);
+    }
+};
+
+#endif // EC_ASYNC_LOG_H
@@ -0,0 +1,582 @@
+#ifndef EC_BINLOG_H
+#define EC_BINLOG_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "ec_sample.h"
+#include "ec_crc32.h"
+#include "ec_log_segment.h"
+
+// ===========================
+// BINARY COLUMNAR LOG FORMAT (.ecb)
+// ===========================
+// Layout (native little-endian):
+//
+//   [File header: 64 bytes][Column table: 4 bytes x N][pad to header_size]
+//   [Block 0][Block 1] ... [Block n-1]
+//
+// Every block has the same size, so block i lives at
+//   header_size + i * block_size
+// and the whole file can be mmap'ed and indexed without parsing.
+//
+// Inside a block the records are stored column by column:
+//
+//   [Block header: 16 bytes][timestamp_ns x cap][temp x cap] ... [flags x cap]
+//
+// so scanning one channel touches only that channel's bytes.
+// The temp / raw_ec / sensor_ec columns hold the decoded floats, which are
+// bit-identical to the ABCD register pairs (see sample_float_to_regs()).
+//
+// Appending: the last block may be partially filled. The writer keeps it in
+// memory, writes new column bytes first and the block's record count last,
+// so a reader never sees a count that covers unwritten data.
+//
+// Integrity (version 2): every record carries a CRC-32 of its other column
+// values. If the OS lost part of the tail in a crash, the writer detects it
+// on the next open by re-checking only the last block, and truncates the
+// block's count back to the last intact record.
+
+const char BINLOG_MAGIC[8] = {'E', 'C', 'B', 'L', 'O', 'G', '\r', '\n'};
+const uint32_t BINLOG_VERSION = 2;           // 1 = no CRC column
+const uint32_t BINLOG_BLOCK_CAPACITY = 1024;      // Records per block
+const uint32_t BINLOG_BLOCK_MAGIC = 0x4B4C4245;   // "EBLK"
+
+enum BinlogColumnId : uint16_t {
+    BINLOG_COL_TIMESTAMP_NS = 1,   // int64
+    BINLOG_COL_TEMP         = 2,   // float (Registers 60-61)
+    BINLOG_COL_RAW_EC       = 3,   // float (Registers 45-46)
+    BINLOG_COL_SENSOR_EC    = 4,   // float (Registers 41-42)
+    BINLOG_COL_SMART_EC     = 5,   // float
+    BINLOG_COL_K            = 6,   // float
+    BINLOG_COL_FLAGS        = 7,   // uint32
+    BINLOG_COL_CRC32        = 8    // uint32, CRC-32 of columns 1-7 (version 2+)
+};
+
+struct BinlogColumnDesc {
+    uint16_t id;
+    uint16_t width;    // Bytes per value
+};
+
+// Columns written by this version, in on-disk order
+const BinlogColumnDesc BINLOG_COLUMNS[] = {
+    {BINLOG_COL_TIMESTAMP_NS, 8},
+    {BINLOG_COL_TEMP,         4},
+    {BINLOG_COL_RAW_EC,       4},
+    {BINLOG_COL_SENSOR_EC,    4},
+    {BINLOG_COL_SMART_EC,     4},
+    {BINLOG_COL_K,            4},
+    {BINLOG_COL_FLAGS,        4},
+    {BINLOG_COL_CRC32,        4},
+};
+const uint32_t BINLOG_COLUMN_COUNT = sizeof(BINLOG_COLUMNS) / sizeof(BINLOG_COLUMNS[0]);
+
+struct BinlogFileHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t header_size;      // Bytes before block 0
+    uint32_t block_capacity;   // Records per block
+    uint32_t block_size;       // Bytes per block
+    uint32_t column_count;
+    uint32_t reserved0;
+    int64_t  created_ns;
+    uint8_t  reserved[24];
+};
+static_assert(sizeof(BinlogFileHeader) == 64, "BinlogFileHeader must be 64 bytes");
+
+struct BinlogBlockHeader {
+    uint32_t magic;
+    uint32_t count;                // Valid records in this block
+    int64_t  first_timestamp_ns;
+};
+static_assert(sizeof(BinlogBlockHeader) == 16, "BinlogBlockHeader must be 16 bytes");
+
+// ===========================
+// LAYOUT HELPERS
+// ===========================
+inline uint32_t binlog_header_size(uint32_t column_count) {
+    uint32_t raw = sizeof(BinlogFileHeader) + column_count * sizeof(BinlogColumnDesc);
+    return (raw + 63) & ~63u;
+}
+
+inline uint32_t binlog_block_size(const BinlogColumnDesc *columns, uint32_t column_count,
+                                  uint32_t capacity) {
+    uint32_t size = sizeof(BinlogBlockHeader);
+    for (uint32_t c = 0; c < column_count; c++) {
+        size += columns[c].width * capacity;
+    }
+    return (size + 63) & ~63u;
+}
+
+// Byte offset of a column area inside a block, or 0 if the column is absent
+inline uint32_t binlog_column_offset(const BinlogColumnDesc *columns, uint32_t column_count,
+                                     uint32_t capacity, uint16_t id) {
+    uint32_t offset = sizeof(BinlogBlockHeader);
+    for (uint32_t c = 0; c < column_count; c++) {
+        if (columns[c].id == id) return offset;
+        offset += columns[c].width * capacity;
+    }
+    return 0;
+}
+
+// CRC of one record's column values, in column order
+inline uint32_t binlog_record_crc(int64_t timestamp_ns, float temp, float raw_ec, float sensor_ec,
+                                  float smart_ec, float k, uint32_t flags) {
+    uint8_t buf[32];
+    memcpy(buf, &timestamp_ns, 8);
+    memcpy(buf + 8, &temp, 4);
+    memcpy(buf + 12, &raw_ec, 4);
+    memcpy(buf + 16, &sensor_ec, 4);
+    memcpy(buf + 20, &smart_ec, 4);
+    memcpy(buf + 24, &k, 4);
+    memcpy(buf + 28, &flags, 4);
+    return crc32_compute(buf, sizeof(buf));
+}
+
+inline int64_t binlog_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// ===========================
+// BINARY LOG WRITER
+// ===========================
+class BinaryLogWriter {
+public:
+    BinaryLogWriter() {}
+    ~BinaryLogWriter() { close(); }
+    BinaryLogWriter(const BinaryLogWriter &) = delete;
+    BinaryLogWriter &operator=(const BinaryLogWriter &) = delete;
+
+    // Open for append; creates the file with a fresh header if needed. A
+    // file of another version or layout is archived and a new one started.
+    bool open(const std::string &path) {
+        close();
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd_ == -1) {
+            std::cerr << "❌ Cannot open binary log " << path << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+
+        header_size_ = binlog_header_size(BINLOG_COLUMN_COUNT);
+        block_size_ = binlog_block_size(BINLOG_COLUMNS, BINLOG_COLUMN_COUNT, BINLOG_BLOCK_CAPACITY);
+        block_.assign(block_size_, 0);
+
+        struct stat st;
+        fstat(fd_, &st);
+
+        if (st.st_size == 0) {
+            if (!write_file_header()) return fail(path);
+            start_block(0);
+            return true;
+        }
+
+        if (!header_matches()) {
+            // Never mix layouts in one file: an older version (ec_log_tool
+            // still reads it) or another layout is kept aside
+            ::close(fd_);
+            fd_ = -1;
+            if (log_archive_segment(path, "binary log of another version or layout").empty()) return false;
+            fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+            if (fd_ == -1) {
+                std::cerr << "❌ Cannot open binary log " << path << ": " << strerror(errno) << std::endl;
+                return false;
+            }
+            if (!write_file_header()) return fail(path);
+            start_block(0);
+            return true;
+        }
+
+        // Resume the last block if it still has room
+        uint64_t data_bytes = st.st_size > header_size_ ? st.st_size - header_size_ : 0;
+        uint32_t blocks = static_cast<uint32_t>((data_bytes + block_size_ - 1) / block_size_);
+        if (blocks == 0) {
+            start_block(0);
+            return true;
+        }
+
+        uint32_t last = blocks - 1;
+        std::vector<uint8_t> buf(block_size_, 0);
+        ssize_t n = pread(fd_, buf.data(), block_size_, block_offset(last));
+        BinlogBlockHeader bh;
+        memcpy(&bh, buf.data(), sizeof(bh));
+
+        if (n < static_cast<ssize_t>(sizeof(bh)) || bh.magic != BINLOG_BLOCK_MAGIC) {
+            // Block was allocated but never committed: reuse it
+            start_block(last);
+        } else if (bh.count >= BINLOG_BLOCK_CAPACITY) {
+            start_block(blocks);
+        } else {
+            block_.swap(buf);
+            block_index_ = last;
+            count_ = valid_prefix(bh.count);
+            flushed_ = count_;
+            if (count_ < bh.count) {
+                torn_records_ = bh.count - count_;
+                std::cerr << "⚠️  " << path << ": dropped " << torn_records_
+                          << " torn record(s) at the tail" << std::endl;
+                BinlogBlockHeader *hdr = reinterpret_cast<BinlogBlockHeader *>(block_.data());
+                hdr->count = count_;
+                if (!write_all(block_.data(), sizeof(BinlogBlockHeader), block_offset(last))) {
+                    return fail(path);
+                }
+            }
+        }
+        return true;
+    }
+
+    bool append(const SampleRecord &rec) {
+        if (fd_ == -1) return false;
+        if (count_ == BINLOG_BLOCK_CAPACITY) {
+            if (!flush()) return false;
+            start_block(block_index_ + 1);
+        }
+
+        put(BINLOG_COL_TIMESTAMP_NS, &rec.timestamp_ns);
+        put(BINLOG_COL_TEMP, &rec.temp);
+        put(BINLOG_COL_RAW_EC, &rec.raw_ec);
+        put(BINLOG_COL_SENSOR_EC, &rec.sensor_ec);
+        put(BINLOG_COL_SMART_EC, &rec.smart_ec);
+        put(BINLOG_COL_K, &rec.k);
+        put(BINLOG_COL_FLAGS, &rec.flags);
+        uint32_t crc = binlog_record_crc(rec.timestamp_ns, rec.temp, rec.raw_ec, rec.sensor_ec,
+                                         rec.smart_ec, rec.k, rec.flags);
+        put(BINLOG_COL_CRC32, &crc);
+
+        if (count_ == 0) {
+            BinlogBlockHeader *bh = reinterpret_cast<BinlogBlockHeader *>(block_.data());
+            bh->first_timestamp_ns = rec.timestamp_ns;
+        }
+        count_++;
+        records_written_++;
+        return true;
+    }
+
+    // Write pending column bytes, then commit the block's record count
+    bool flush() {
+        if (fd_ == -1 || flushed_ == count_) return fd_ != -1;
+
+        off_t base = block_offset(block_index_);
+        for (uint32_t c = 0; c < BINLOG_COLUMN_COUNT; c++) {
+            const BinlogColumnDesc &col = BINLOG_COLUMNS[c];
+            uint32_t area = binlog_column_offset(BINLOG_COLUMNS, BINLOG_COLUMN_COUNT,
+                                                 BINLOG_BLOCK_CAPACITY, col.id);
+            uint32_t from = area + flushed_ * col.width;
+            uint32_t len = (count_ - flushed_) * col.width;
+            if (!write_all(block_.data() + from, len, base + from)) return false;
+        }
+
+        BinlogBlockHeader *bh = reinterpret_cast<BinlogBlockHeader *>(block_.data());
+        bh->count = count_;
+        if (!write_all(block_.data(), sizeof(BinlogBlockHeader), base)) return false;
+
+        flushed_ = count_;
+        return true;
+    }
+
+    // Make everything flushed so far durable (data only, not mtime)
+    bool sync() {
+        if (fd_ == -1) return false;
+        if (fdatasync(fd_) == -1) {
+            std::cerr << "❌ Binary log fdatasync failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (fd_ == -1) return;
+        flush();
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+    bool is_open() const { return fd_ != -1; }
+    uint64_t records_written() const { return records_written_; }
+    uint32_t torn_records() const { return torn_records_; }
+
+    bool has_records() const { return block_index_ > 0 || count_ > 0; }
+
+    // Where the next append() lands: block file offset + index in the block
+    void next_position(uint64_t *offset, uint32_t *skip) const {
+        bool full = (count_ == BINLOG_BLOCK_CAPACITY);
+        *offset = block_offset(full ? block_index_ + 1 : block_index_);
+        *skip = full ? 0 : count_;
+    }
+
+private:
+    int fd_ = -1;
+    uint32_t header_size_ = 0;
+    uint32_t block_size_ = 0;
+    uint32_t block_index_ = 0;     // Block currently being filled
+    uint32_t count_ = 0;           // Records in the current block
+    uint32_t flushed_ = 0;         // Records of the current block already on disk
+    uint64_t records_written_ = 0;
+    uint32_t torn_records_ = 0;    // Records discarded by tail recovery on open
+    std::vector<uint8_t> block_;
+
+    template <typename T>
+    T get(uint16_t id, uint32_t index) const {
+        T value;
+        uint32_t area = binlog_column_offset(BINLOG_COLUMNS, BINLOG_COLUMN_COUNT,
+                                             BINLOG_BLOCK_CAPACITY, id);
+        memcpy(&value, block_.data() + area + index * sizeof(T), sizeof(T));
+        return value;
+    }
+
+    // Number of leading records in the loaded block whose CRC matches
+    uint32_t valid_prefix(uint32_t count) const {
+        if (count > BINLOG_BLOCK_CAPACITY) count = BINLOG_BLOCK_CAPACITY;
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t crc = binlog_record_crc(get<int64_t>(BINLOG_COL_TIMESTAMP_NS, i),
+                                             get<float>(BINLOG_COL_TEMP, i),
+                                             get<float>(BINLOG_COL_RAW_EC, i),
+                                             get<float>(BINLOG_COL_SENSOR_EC, i),
+                                             get<float>(BINLOG_COL_SMART_EC, i),
+                                             get<float>(BINLOG_COL_K, i),
+                                             get<uint32_t>(BINLOG_COL_FLAGS, i));
+            if (crc != get<uint32_t>(BINLOG_COL_CRC32, i)) return i;
+        }
+        return count;
+    }
+
+    off_t block_offset(uint32_t index) const {
+        return static_cast<off_t>(header_size_) + static_cast<off_t>(index) * block_size_;
+    }
+
+    void put(uint16_t id, const void *value) {
+        for (uint32_t c = 0; c < BINLOG_COLUMN_COUNT; c++) {
+            if (BINLOG_COLUMNS[c].id != id) continue;
+            uint32_t area = binlog_column_offset(BINLOG_COLUMNS, BINLOG_COLUMN_COUNT,
+                                                 BINLOG_BLOCK_CAPACITY, id);
+            memcpy(block_.data() + area + count_ * BINLOG_COLUMNS[c].width, value,
+                   BINLOG_COLUMNS[c].width);
+            return;
+        }
+    }
+
+    // Reserve a full-size block so mmap readers never touch past EOF
+    void start_block(uint32_t index) {
+        block_index_ = index;
+        count_ = 0;
+        flushed_ = 0;
+        std::fill(block_.begin(), block_.end(), 0);
+        BinlogBlockHeader *bh = reinterpret_cast<BinlogBlockHeader *>(block_.data());
+        bh->magic = BINLOG_BLOCK_MAGIC;
+        if (ftruncate(fd_, block_offset(index + 1)) == -1) {
+            std::cerr << "⚠️  Could not extend binary log: " << strerror(errno) << std::endl;
+        }
+    }
+
+    bool write_file_header() {
+        std::vector<uint8_t> buf(header_size_, 0);
+        BinlogFileHeader fh;
+        memset(&fh, 0, sizeof(fh));
+        memcpy(fh.magic, BINLOG_MAGIC, sizeof(fh.magic));
+        fh.version = BINLOG_VERSION;
+        fh.header_size = header_size_;
+        fh.block_capacity = BINLOG_BLOCK_CAPACITY;
+        fh.block_size = block_size_;
+        fh.column_count = BINLOG_COLUMN_COUNT;
+        fh.created_ns = binlog_now_ns();
+        memcpy(buf.data(), &fh, sizeof(fh));
+        memcpy(buf.data() + sizeof(fh), BINLOG_COLUMNS, sizeof(BINLOG_COLUMNS));
+        return write_all(buf.data(), buf.size(), 0);
+    }
+
+    // False for a truncated header or one of another version / layout
+    bool header_matches() {
+        std::vector<uint8_t> buf(header_size_, 0);
+        if (pread(fd_, buf.data(), buf.size(), 0) != static_cast<ssize_t>(buf.size())) return false;
+        BinlogFileHeader fh;
+        memcpy(&fh, buf.data(), sizeof(fh));
+        if (memcmp(fh.magic, BINLOG_MAGIC, sizeof(fh.magic)) != 0 ||
+            fh.version != BINLOG_VERSION ||
+            fh.header_size != header_size_ ||
+            fh.block_capacity != BINLOG_BLOCK_CAPACITY ||
+            fh.block_size != block_size_ ||
+            fh.column_count != BINLOG_COLUMN_COUNT ||
+            memcmp(buf.data() + sizeof(fh), BINLOG_COLUMNS, sizeof(BINLOG_COLUMNS)) != 0) {
+            return false;
+        }
+        return true;
+    }
+
+    bool write_all(const uint8_t *data, size_t len, off_t offset) {
+        while (len > 0) {
+            ssize_t n = pwrite(fd_, data, len, offset);
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                std::cerr << "❌ Binary log write failed: " << strerror(errno) << std::endl;
+                return false;
+            }
+            data += n;
+            len -= n;
+            offset += n;
+        }
+        return true;
+    }
+
+    bool fail(const std::string &path) {
+        (void)path;
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+};
+
+// ===========================
+// BINARY LOG READER (mmap)
+// ===========================
+// Zero-copy view of one block. Column pointers point straight into the
+// mapping; absent columns are NULL.
+struct BinlogBlockView {
+    uint32_t count = 0;
+    const int64_t  *timestamp_ns = nullptr;
+    const float    *temp = nullptr;
+    const float    *raw_ec = nullptr;
+    const float    *sensor_ec = nullptr;
+    const float    *smart_ec = nullptr;
+    const float    *k = nullptr;
+    const uint32_t *flags = nullptr;
+    const uint32_t *crc32 = nullptr;    // NULL for version 1 files
+
+    // False if the stored CRC does not match (torn or corrupted record)
+    bool record_valid(uint32_t i) const {
+        if (!crc32) return true;
+        return crc32[i] == binlog_record_crc(timestamp_ns ? timestamp_ns[i] : 0,
+                                             temp ? temp[i] : 0.0f,
+                                             raw_ec ? raw_ec[i] : 0.0f,
+                                             sensor_ec ? sensor_ec[i] : 0.0f,
+                                             smart_ec ? smart_ec[i] : 0.0f,
+                                             k ? k[i] : 0.0f,
+                                             flags ? flags[i] : 0u);
+    }
+
+    SampleRecord record(uint32_t i) const {
+        SampleRecord rec;
+        memset(&rec, 0, sizeof(rec));
+        if (timestamp_ns) rec.timestamp_ns = timestamp_ns[i];
+        if (temp) rec.temp = temp[i];
+        if (raw_ec) rec.raw_ec = raw_ec[i];
+        if (sensor_ec) rec.sensor_ec = sensor_ec[i];
+        if (smart_ec) rec.smart_ec = smart_ec[i];
+        if (k) rec.k = k[i];
+        if (flags) rec.flags = flags[i];
+        sample_float_to_regs(rec.temp, rec.reg_temp);
+        sample_float_to_regs(rec.raw_ec, rec.reg_raw_ec);
+        sample_float_to_regs(rec.sensor_ec, rec.reg_sensor_ec);
+        return rec;
+    }
+};
+
+class BinaryLogReader {
+public:
+    BinaryLogReader() {}
+    ~BinaryLogReader() { close(); }
+    BinaryLogReader(const BinaryLogReader &) = delete;
+    BinaryLogReader &operator=(const BinaryLogReader &) = delete;
+
+    bool open(const std::string &path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd == -1) {
+            std::cerr << "❌ Cannot open " << path << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        struct stat st;
+        fstat(fd, &st);
+        size_ = st.st_size;
+        if (size_ < sizeof(BinlogFileHeader)) {
+            std::cerr << "❌ " << path << ": too small to be a binary log" << std::endl;
+            ::close(fd);
+            return false;
+        }
+        void *map = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (map == MAP_FAILED) {
+            std::cerr << "❌ mmap failed for " << path << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        data_ = static_cast<const uint8_t *>(map);
+        madvise(map, size_, MADV_SEQUENTIAL);
+
+        memcpy(&header_, data_, sizeof(header_));
+        if (memcmp(header_.magic, BINLOG_MAGIC, sizeof(header_.magic)) != 0 ||
+            header_.version == 0 || header_.version > BINLOG_VERSION ||
+            header_.header_size > size_ ||
+            sizeof(BinlogFileHeader) + header_.column_count * sizeof(BinlogColumnDesc) > header_.header_size ||
+            header_.block_size == 0) {
+            std::cerr << "❌ " << path << ": not a supported binary log" << std::endl;
+            close();
+            return false;
+        }
+        columns_.resize(header_.column_count);
+        memcpy(columns_.data(), data_ + sizeof(BinlogFileHeader),
+               header_.column_count * sizeof(BinlogColumnDesc));
+        block_count_ = (size_ - header_.header_size) / header_.block_size;
+        return true;
+    }
+
+    void close() {
+        if (data_) munmap(const_cast<uint8_t *>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+        block_count_ = 0;
+    }
+
+    const BinlogFileHeader &header() const { return header_; }
+    size_t block_count() const { return block_count_; }
+
+    BinlogBlockView block(size_t index) const {
+        BinlogBlockView view;
+        const uint8_t *base = data_ + header_.header_size + index * header_.block_size;
+        BinlogBlockHeader bh;
+        memcpy(&bh, base, sizeof(bh));
+        if (bh.magic != BINLOG_BLOCK_MAGIC) return view;
+
+        view.count = bh.count < header_.block_capacity ? bh.count : header_.block_capacity;
+        view.timestamp_ns = column<int64_t>(base, BINLOG_COL_TIMESTAMP_NS);
+        view.temp = column<float>(base, BINLOG_COL_TEMP);
+        view.raw_ec = column<float>(base, BINLOG_COL_RAW_EC);
+        view.sensor_ec = column<float>(base, BINLOG_COL_SENSOR_EC);
+        view.smart_ec = column<float>(base, BINLOG_COL_SMART_EC);
+        view.k = column<float>(base, BINLOG_COL_K);
+        view.flags = column<uint32_t>(base, BINLOG_COL_FLAGS);
+        view.crc32 = column<uint32_t>(base, BINLOG_COL_CRC32);
+        return view;
+    }
+
+    uint64_t record_count() const {
+        uint64_t total = 0;
+        for (size_t b = 0; b < block_count_; b++) total += block(b).count;
+        return total;
+    }
+
+private:
+    const uint8_t *data_ = nullptr;
+    size_t size_ = 0;
+    size_t block_count_ = 0;
+    BinlogFileHeader header_;
+    std::vector<BinlogColumnDesc> columns_;
+
+    template <typename T>
+    const T *column(const uint8_t *base, uint16_t id) const {
+        uint32_t offset = binlog_column_offset(columns_.data(), header_.column_count,
+                                               header_.block_capacity, id);
+        return offset ? reinterpret_cast<const T *>(base + offset) : nullptr;
+    }
+};
+
+#endif // EC_BINLOG_H
@@ -0,0 +1,584 @@
+#ifndef EC_CHART_H
+#define EC_CHART_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ec_sample.h"
+
+// ===========================
+// CHARTS WITHOUT PYTHON (SVG)
+// ===========================
+// ec_log_tool plot draws the two plot_data.py charts (EC and deviation vs
+// temperature, coefficient vs temperature) straight from a log of any
+// size, in one streaming pass and bounded memory:
+//
+//   1. Every sample goes into a fixed temperature bin (CHART_BIN_C wide)
+//      that keeps count, sum, min and max per series. This replaces
+//      plot_data.py's sort by temperature: bins are already in x order,
+//      and accumulators from several threads simply merge.
+//   2. The per-bin means form one x-ordered series per curve, which
+//      largest-triangle-three-buckets (LTTB) reduces to a few thousand
+//      points while keeping its visible shape (peaks and steps survive,
+//      unlike plain decimation).
+//   3. The bins' min/max are drawn as a light band behind each curve, so
+//      the spread of the raw data stays visible. The y axis follows the
+//      curves, not the band: a single garbage reading (a 2000 mS/cm spike)
+//      then only clips the band instead of flattening the whole chart.
+//
+// Output is SVG: no raster or font library needed, opens in any browser.
+
+const double CHART_TEMP_LO = -50.0;          // Bin range (°C); outside is counted, not drawn
+const double CHART_TEMP_HI = 150.0;
+const double CHART_BIN_C = 0.01;
+const size_t CHART_BIN_COUNT = 20000;        // (HI - LO) / BIN
+const size_t CHART_DEFAULT_POINTS = 1500;    // LTTB target per curve
+const size_t CHART_BAND_COLUMNS = 600;       // Min/max band resolution
+const double CHART_STANDARD_EC = 12.88;
+
+enum ChartSeries {
+    CHART_SENSOR_EC = 0,
+    CHART_SMART_EC = 1,
+    CHART_DEVIATION = 2,     // Sensor - Smart
+    CHART_K_PERCENT = 3,     // Coefficient used, % (only where the log knows it)
+    CHART_SERIES_COUNT = 4
+};
+
+struct ChartPoint {
+    double x, y;
+};
+
+// Sum / sum of squares of the distance from CHART_STANDARD_EC (keeps the
+// variance well-conditioned over tens of millions of samples)
+struct ChartChannelStats {
+    uint64_t n = 0;
+    double sum = 0, sum_sq = 0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+
+    void add(double v) {
+        double d = v - CHART_STANDARD_EC;
+        n++;
+        sum += d;
+        sum_sq += d * d;
+        min = std::min(min, v);
+        max = std::max(max, v);
+    }
+
+    void merge(const ChartChannelStats &o) {
+        n += o.n;
+        sum += o.sum;
+        sum_sq += o.sum_sq;
+        min = std::min(min, o.min);
+        max = std::max(max, o.max);
+    }
+
+    double mean() const { return n ? CHART_STANDARD_EC + sum / n : 0; }
+    double rmse() const { return n ? std::sqrt(sum_sq / n) : 0; }
+    double stddev() const {   // Sample standard deviation, like pandas
+        if (n < 2) return 0;
+        double var = (sum_sq - sum * sum / n) / (n - 1);
+        return var > 0 ? std::sqrt(var) : 0;
+    }
+};
+
+class ChartAccumulator {
+public:
+    ChartAccumulator() : bins_(CHART_BIN_COUNT) {}
+
+    void add(const SampleRecord &rec) {
+        double t = rec.temp;
+        if (!(t >= CHART_TEMP_LO && t < CHART_TEMP_HI)) {
+            out_of_range_++;
+            return;
+        }
+        Bin &b = bins_[static_cast<size_t>((t - CHART_TEMP_LO) / CHART_BIN_C)];
+        b.count++;
+        b.temp_sum += t;
+        b.v[CHART_SENSOR_EC].add(rec.sensor_ec);
+        b.v[CHART_SMART_EC].add(rec.smart_ec);
+        double deviation = static_cast<double>(rec.sensor_ec) - rec.smart_ec;
+        b.v[CHART_DEVIATION].add(deviation);
+        if (rec.k != 0) b.v[CHART_K_PERCENT].add(rec.k * 100.0);
+
+        sensor_.add(rec.sensor_ec);
+        smart_.add(rec.smart_ec);
+        deviation_sum_ += deviation;
+        samples_++;
+    }
+
+    void merge(const ChartAccumulator &o) {
+        for (size_t i = 0; i < CHART_BIN_COUNT; i++) {
+            const Bin &src = o.bins_[i];
+            if (src.count == 0) continue;
+            Bin &b = bins_[i];
+            b.count += src.count;
+            b.temp_sum += src.temp_sum;
+            for (int s = 0; s < CHART_SERIES_COUNT; s++) b.v[s].merge(src.v[s]);
+        }
+        sensor_.merge(o.sensor_);
+        smart_.merge(o.smart_);
+        deviation_sum_ += o.deviation_sum_;
+        samples_ += o.samples_;
+        out_of_range_ += o.out_of_range_;
+    }
+
+    uint64_t samples() const { return samples_; }
+    uint64_t out_of_range() const { return out_of_range_; }
+    const ChartChannelStats &sensor() const { return sensor_; }
+    const ChartChannelStats &smart() const { return smart_; }
+    double mean_deviation() const { return samples_ ? deviation_sum_ / samples_ : 0; }
+
+    // Per-bin mean of a series at the bin's mean temperature, in x order
+    std::vector<ChartPoint> means(ChartSeries s) const {
+        std::vector<ChartPoint> out;
+        for (const Bin &b : bins_) {
+            const BinSeries &v = b.v[s];
+            if (v.n) out.push_back(ChartPoint{b.temp_sum / b.count, v.sum / v.n});
+        }
+        return out;
+    }
+
+    // Min/max envelope of a series over `columns` equal slices of [x_lo, x_hi]
+    void envelope(ChartSeries s, double x_lo, double x_hi, size_t columns,
+                  std::vector<ChartPoint> &lo, std::vector<ChartPoint> &hi) const {
+        lo.clear();
+        hi.clear();
+        double width = (x_hi - x_lo) / columns;
+        size_t col = SIZE_MAX;
+        for (const Bin &b : bins_) {
+            const BinSeries &v = b.v[s];
+            if (!v.n) continue;
+            double x = b.temp_sum / b.count;
+            size_t c = width > 0 ? std::min(columns - 1, static_cast<size_t>((x - x_lo) / width)) : 0;
+            if (c != col || lo.empty()) {
+                double cx = width > 0 ? x_lo + (c + 0.5) * width : x;
+                lo.push_back(ChartPoint{cx, v.min});
+                hi.push_back(ChartPoint{cx, v.max});
+                col = c;
+            } else {
+                lo.back().y = std::min(lo.back().y, static_cast<double>(v.min));
+                hi.back().y = std::max(hi.back().y, static_cast<double>(v.max));
+            }
+        }
+    }
+
+    // Temperature span with data
+    bool x_range(double *lo, double *hi) const {
+        size_t first = 0, last = CHART_BIN_COUNT;
+        while (first < CHART_BIN_COUNT && bins_[first].count == 0) first++;
+        while (last > first && bins_[last - 1].count == 0) last--;
+        if (first == last) return false;
+        *lo = bins_[first].temp_sum / bins_[first].count;
+        *hi = bins_[last - 1].temp_sum / bins_[last - 1].count;
+        return true;
+    }
+
+private:
+    struct BinSeries {
+        uint64_t n = 0;
+        double sum = 0;
+        float min = std::numeric_limits<float>::infinity();
+        float max = -std::numeric_limits<float>::infinity();
+
+        void add(double v) {
+            n++;
+            sum += v;
+            min = std::min(min, static_cast<float>(v));
+            max = std::max(max, static_cast<float>(v));
+        }
+
+        void merge(const BinSeries &o) {
+            n += o.n;
+            sum += o.sum;
+            min = std::min(min, o.min);
+            max = std::max(max, o.max);
+        }
+    };
+
+    struct Bin {
+        uint64_t count = 0;
+        double temp_sum = 0;
+        BinSeries v[CHART_SERIES_COUNT];
+    };
+
+    std::vector<Bin> bins_;
+    ChartChannelStats sensor_, smart_;
+    double deviation_sum_ = 0;
+    uint64_t samples_ = 0;
+    uint64_t out_of_range_ = 0;
+};
+
+// ===========================
+// LTTB DOWNSAMPLING
+// ===========================
+// Largest-triangle-three-buckets (Steinarsson, 2013): keeps the first and
+// last point and, from each of threshold - 2 equal buckets in between, the
+// point forming the largest triangle with the previously kept point and the
+// average of the next bucket. Input must be ordered by x.
+inline std::vector<ChartPoint> lttb_downsample(const std::vector<ChartPoint> &in, size_t threshold) {
+    size_t n = in.size();
+    if (threshold >= n || threshold < 3) return in;
+
+    std::vector<ChartPoint> out;
+    out.reserve(threshold);
+    out.push_back(in[0]);
+    double every = static_cast<double>(n - 2) / (threshold - 2);
+    size_t a = 0;
+    for (size_t i = 0; i < threshold - 2; i++) {
+        size_t avg_start = static_cast<size_t>((i + 1) * every) + 1;
+        size_t avg_end = std::min(static_cast<size_t>((i + 2) * every) + 1, n);
+        double avg_x = 0, avg_y = 0;
+        for (size_t j = avg_start; j < avg_end; j++) {
+            avg_x += in[j].x;
+            avg_y += in[j].y;
+        }
+        size_t avg_len = avg_end > avg_start ? avg_end - avg_start : 1;
+        if (avg_end <= avg_start) {
+            avg_x = in[n - 1].x;
+            avg_y = in[n - 1].y;
+        } else {
+            avg_x /= avg_len;
+            avg_y /= avg_len;
+        }
+
+        size_t range_start = static_cast<size_t>(i * every) + 1;
+        size_t range_end = static_cast<size_t>((i + 1) * every) + 1;
+        double best_area = -1;
+        size_t best = range_start;
+        for (size_t j = range_start; j < range_end && j < n - 1; j++) {
+            double area = std::fabs((in[a].x - avg_x) * (in[j].y - in[a].y) -
+                                    (in[a].x - in[j].x) * (avg_y - in[a].y));
+            if (area > best_area) {
+                best_area = area;
+                best = j;
+            }
+        }
+        out.push_back(in[best]);
+        a = best;
+    }
+    out.push_back(in[n - 1]);
+    return out;
+}
+
+// ===========================
+// SVG WRITER
+// ===========================
+inline std::string svg_escape(const std::string &text) {
+    std::string out;
+    for (char c : text) {
+        switch (c) {
+            case '&': out += "&amp;"; break;
+            case '<': out += "&lt;"; break;
+            case '>': out += "&gt;"; break;
+            case '"': out += "&quot;"; break;
+            default:  out += c;
+        }
+    }
+    return out;
+}
+
+// "1.0, 2.0, 5.0 x 10^k" step giving about `target` ticks over span
+inline double chart_tick_step(double span, int target) {
+    double raw = span / target;
+    double mag = std::pow(10.0, std::floor(std::log10(raw)));
+    double f = raw / mag;
+    return (f < 1.5 ? 1 : f < 3.5 ? 2 : f < 7.5 ? 5 : 10) * mag;
+}
+
+inline std::string chart_number(double v, int decimals) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.*f", decimals, std::fabs(v) < 1e-12 ? 0.0 : v);
+    return buf;
+}
+
+class SvgChart {
+public:
+    SvgChart(int width, int height) {
+        out_ << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" << width << "\" height=\"" << height
+             << "\" viewBox=\"0 0 " << width << " " << height << "\" font-family=\"DejaVu Sans, Arial, sans-serif\">\n"
+             << "<rect width=\"100%\" height=\"100%\" fill=\"white\"/>\n";
+        out_.setf(std::ios::fixed);
+        out_.precision(2);
+    }
+
+    // One plot panel: pixel box and data ranges
+    struct Axes {
+        double left, top, width, height;
+        double x_min, x_max, y_min, y_max;
+        double px(double x) const { return left + (x - x_min) / (x_max - x_min) * width; }
+        double py(double y) const { return top + height - (y - y_min) / (y_max - y_min) * height; }
+    };
+
+    void text(double x, double y, const std::string &s, int size, const char *anchor = "start",
+              bool bold = false, double rotate = 0) {
+        out_ << "<text x=\"" << x << "\" y=\"" << y << "\" font-size=\"" << size
+             << "\" text-anchor=\"" << anchor << "\"";
+        if (bold) out_ << " font-weight=\"bold\"";
+        if (rotate != 0) out_ << " transform=\"rotate(" << rotate << " " << x << " " << y << ")\"";
+        out_ << ">" << svg_escape(s) << "</text>\n";
+    }
+
+    // Everything until clip_end() is cut off at the panel's frame
+    void clip_begin(const Axes &ax) {
+        int id = ++clips_;
+        out_ << "<clipPath id=\"clip" << id << "\"><rect x=\"" << ax.left << "\" y=\"" << ax.top
+             << "\" width=\"" << ax.width << "\" height=\"" << ax.height << "\"/></clipPath>\n"
+             << "<g clip-path=\"url(#clip" << id << ")\">\n";
+    }
+
+    void clip_end() { out_ << "</g>\n"; }
+
+    void line(double x1, double y1, double x2, double y2, const char *color, double width,
+              double opacity = 1, const char *dash = nullptr) {
+        out_ << "<line x1=\"" << x1 << "\" y1=\"" << y1 << "\" x2=\"" << x2 << "\" y2=\"" << y2
+             << "\" stroke=\"" << color << "\" stroke-width=\"" << width << "\" stroke-opacity=\"" << opacity << "\"";
+        if (dash) out_ << " stroke-dasharray=\"" << dash << "\"";
+        out_ << "/>\n";
+    }
+
+    void rect(double x, double y, double w, double h, const char *fill, double opacity,
+              const char *stroke = "none") {
+        out_ << "<rect x=\"" << x << "\" y=\"" << y << "\" width=\"" << w << "\" height=\"" << h
+             << "\" rx=\"4\" fill=\"" << fill << "\" fill-opacity=\"" << opacity << "\" stroke=\"" << stroke << "\"/>\n";
+    }
+
+    void polyline(const Axes &ax, const std::vector<ChartPoint> &pts, const char *color, double width,
+                  double opacity) {
+        if (pts.empty()) return;
+        out_ << "<polyline fill=\"none\" stroke=\"" << color << "\" stroke-width=\"" << width
+             << "\" stroke-opacity=\"" << opacity << "\" stroke-linejoin=\"round\" points=\"";
+        for (const ChartPoint &p : pts) out_ << ax.px(p.x) << "," << ax.py(p.y) << " ";
+        out_ << "\"/>\n";
+    }
+
+    void markers(const Axes &ax, const std::vector<ChartPoint> &pts, const char *color, double r, double opacity) {
+        for (const ChartPoint &p : pts) {
+            out_ << "<circle cx=\"" << ax.px(p.x) << "\" cy=\"" << ax.py(p.y) << "\" r=\"" << r
+                 << "\" fill=\"" << color << "\" fill-opacity=\"" << opacity << "\"/>\n";
+        }
+    }
+
+    // Area between two curves sharing x (e.g. min/max band, or a curve and 0)
+    void band(const Axes &ax, const std::vector<ChartPoint> &lo, const std::vector<ChartPoint> &hi,
+              const char *color, double opacity) {
+        if (lo.empty() || lo.size() != hi.size()) return;
+        out_ << "<polygon fill=\"" << color << "\" fill-opacity=\"" << opacity << "\" stroke=\"none\" points=\"";
+        for (const ChartPoint &p : hi) out_ << ax.px(p.x) << "," << ax.py(p.y) << " ";
+        for (size_t i = lo.size(); i-- > 0;) out_ << ax.px(lo[i].x) << "," << ax.py(lo[i].y) << " ";
+        out_ << "\"/>\n";
+    }
+
+    void hline(const Axes &ax, double y, const char *color, double width, double opacity, const char *dash) {
+        if (y < ax.y_min || y > ax.y_max) return;
+        line(ax.left, ax.py(y), ax.left + ax.width, ax.py(y), color, width, opacity, dash);
+    }
+
+    void vline(const Axes &ax, double x, const char *color, double width, double opacity, const char *dash) {
+        if (x < ax.x_min || x > ax.x_max) return;
+        line(ax.px(x), ax.top, ax.px(x), ax.top + ax.height, color, width, opacity, dash);
+    }
+
+    // Frame, grid, ticks and labels
+    void axes(const Axes &ax, const std::string &title, const std::string &x_label, const std::string &y_label) {
+        double xs = chart_tick_step(ax.x_max - ax.x_min, 10);
+        double ys = chart_tick_step(ax.y_max - ax.y_min, 8);
+        int xd = std::max(0, -static_cast<int>(std::floor(std::log10(xs))));
+        int yd = std::max(0, -static_cast<int>(std::floor(std::log10(ys))));
+        for (double x = std::ceil(ax.x_min / xs) * xs; x <= ax.x_max + xs * 1e-9; x += xs) {
+            line(ax.px(x), ax.top, ax.px(x), ax.top + ax.height, "#000", 1, 0.12);
+            text(ax.px(x), ax.top + ax.height + 18, chart_number(x, xd), 12, "middle");
+        }
+        for (double y = std::ceil(ax.y_min / ys) * ys; y <= ax.y_max + ys * 1e-9; y += ys) {
+            line(ax.left, ax.py(y), ax.left + ax.width, ax.py(y), "#000", 1, 0.12);
+            text(ax.left - 8, ax.py(y) + 4, chart_number(y, yd), 12, "end");
+        }
+        out_ << "<rect x=\"" << ax.left << "\" y=\"" << ax.top << "\" width=\"" << ax.width << "\" height=\""
+             << ax.height << "\" fill=\"none\" stroke=\"#333\"/>\n";
+        text(ax.left + ax.width / 2, ax.top - 10, title, 15, "middle", true);
+        text(ax.left + ax.width / 2, ax.top + ax.height + 40, x_label, 13, "middle");
+        text(ax.left - 60, ax.top + ax.height / 2, y_label, 13, "middle", false, -90);
+    }
+
+    // Legend box in the top-right corner of ax: {color, dash or null, label}
+    struct LegendItem {
+        const char *color;
+        const char *dash;
+        std::string label;
+    };
+
+    void legend(const Axes &ax, const std::vector<LegendItem> &items) {
+        double w = 0;
+        for (const LegendItem &it : items) w = std::max(w, 7.0 * it.label.size());
+        w += 50;
+        double h = 20.0 * items.size() + 10;
+        double x = ax.left + ax.width - w - 10, y = ax.top + 10;
+        rect(x, y, w, h, "white", 0.85, "#ccc");
+        for (size_t i = 0; i < items.size(); i++) {
+            double ly = y + 18 + 20.0 * i;
+            line(x + 8, ly - 4, x + 36, ly - 4, items[i].color, 2.5, 0.8, items[i].dash);
+            text(x + 42, ly, items[i].label, 12);
+        }
+    }
+
+    // Multi-line note box in the top-left corner of ax
+    void note(const Axes &ax, const std::vector<std::string> &lines) {
+        double w = 0;
+        for (const std::string &l : lines) w = std::max(w, 7.2 * l.size());
+        rect(ax.left + 10, ax.top + 10, w + 16, 18.0 * lines.size() + 10, "wheat", 0.5);
+        for (size_t i = 0; i < lines.size(); i++) {
+            text(ax.left + 18, ax.top + 28 + 18.0 * i, lines[i], 12);
+        }
+    }
+
+    bool save(const std::string &path) {
+        out_ << "</svg>\n";
+        std::ofstream f(path, std::ios::binary);
+        f << out_.str();
+        f.close();
+        if (f.fail()) {
+            std::cerr << "❌ Cannot write " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    std::ostringstream out_;
+    int clips_ = 0;
+};
+
+// Widen [*lo, *hi] to cover pts
+inline void chart_extend_range(const std::vector<ChartPoint> &pts, double *lo, double *hi) {
+    for (const ChartPoint &p : pts) {
+        *lo = std::min(*lo, p.y);
+        *hi = std::max(*hi, p.y);
+    }
+}
+
+// Data range padded by 5% (and never empty)
+inline void chart_pad_range(double *lo, double *hi) {
+    double span = *hi - *lo;
+    if (!(span > 0)) span = std::max(1e-3, std::fabs(*lo) * 0.01);
+    *lo -= span * 0.05;
+    *hi += span * 0.05;
+}
+
+// ===========================
+// THE TWO CHARTS
+// ===========================
+// ec_comparison_chart.svg: EC vs temperature (sensor, smart, 12.88
+// reference, statistics box) above the deviation analysis, as in
+// plot_data.py's plot_comparison()
+inline bool render_comparison_chart(const ChartAccumulator &acc, size_t points, const std::string &path) {
+    double x_lo, x_hi;
+    if (!acc.x_range(&x_lo, &x_hi)) return false;
+    chart_pad_range(&x_lo, &x_hi);
+
+    SvgChart svg(1400, 1000);
+    svg.text(700, 34, "BOQU IOT-485-EC4A: Sensor Default vs Smart Algorithm Comparison", 20, "middle", true);
+
+    // Panel 1: EC vs temperature
+    std::vector<ChartPoint> sensor = lttb_downsample(acc.means(CHART_SENSOR_EC), points);
+    std::vector<ChartPoint> smart = lttb_downsample(acc.means(CHART_SMART_EC), points);
+    double y_lo = CHART_STANDARD_EC, y_hi = CHART_STANDARD_EC;
+    chart_extend_range(sensor, &y_lo, &y_hi);
+    chart_extend_range(smart, &y_lo, &y_hi);
+    chart_pad_range(&y_lo, &y_hi);
+    SvgChart::Axes top{100, 80, 1260, 360, x_lo, x_hi, y_lo, y_hi};
+    svg.axes(top, "Conductivity vs Temperature", "Temperature (°C)", "Conductivity (mS/cm)");
+
+    std::vector<ChartPoint> lo, hi;
+    svg.clip_begin(top);
+    acc.envelope(CHART_SENSOR_EC, x_lo, x_hi, CHART_BAND_COLUMNS, lo, hi);
+    svg.band(top, lo, hi, "red", 0.12);
+    acc.envelope(CHART_SMART_EC, x_lo, x_hi, CHART_BAND_COLUMNS, lo, hi);
+    svg.band(top, lo, hi, "green", 0.12);
+    svg.polyline(top, sensor, "red", 2, 0.7);
+    svg.polyline(top, smart, "green", 2, 0.7);
+    svg.clip_end();
+    svg.hline(top, CHART_STANDARD_EC, "blue", 1.5, 0.5, "8,5");
+    svg.legend(top, {{"red", nullptr, "Sensor Default (k=0.02 fixed)"},
+                     {"green", nullptr, "Smart Algorithm (Dynamic k)"},
+                     {"blue", "8,5", "Expected: 12.88 mS/cm @ 25°C"}});
+    svg.note(top, {"Sensor Std: " + chart_number(acc.sensor().stddev(), 4) + " mS/cm",
+                   "Smart Std:  " + chart_number(acc.smart().stddev(), 4) + " mS/cm",
+                   "Sensor RMSE: " + chart_number(acc.sensor().rmse(), 4) + " mS/cm",
+                   "Smart RMSE:  " + chart_number(acc.smart().rmse(), 4) + " mS/cm",
+                   "Samples: " + std::to_string(acc.samples())});
+
+    // Panel 2: deviation analysis
+    std::vector<ChartPoint> dev = lttb_downsample(acc.means(CHART_DEVIATION), points);
+    double mean_dev = acc.mean_deviation();
+    y_lo = y_hi = 0;
+    chart_extend_range(dev, &y_lo, &y_hi);
+    chart_pad_range(&y_lo, &y_hi);
+    SvgChart::Axes bottom{100, 560, 1260, 360, x_lo, x_hi, y_lo, y_hi};
+    svg.axes(bottom, "Algorithm Deviation Analysis", "Temperature (°C)", "Deviation (Sensor - Smart) [mS/cm]");
+
+    std::vector<ChartPoint> zero(dev);
+    for (ChartPoint &p : zero) p.y = 0;
+    svg.clip_begin(bottom);
+    svg.band(bottom, zero, dev, "#1f77b4", 0.3);
+    svg.polyline(bottom, dev, "blue", 2, 0.7);
+    svg.clip_end();
+    svg.hline(bottom, 0, "black", 1, 0.3, nullptr);
+    svg.hline(bottom, mean_dev, "red", 1.5, 0.7, "8,5");
+    svg.legend(bottom, {{"red", "8,5", "Mean Deviation: " + chart_number(mean_dev, 4) + " mS/cm"}});
+
+    return svg.save(path);
+}
+
+// coefficient_analysis.svg: k (%) vs temperature with the coefficient table's
+// zone boundaries, as in plot_data.py's plot_coefficient_analysis(). Each
+// zone is labelled with the mean k the log actually shows there.
+inline bool render_coefficient_chart(const ChartAccumulator &acc, size_t points, const std::string &path) {
+    std::vector<ChartPoint> k = acc.means(CHART_K_PERCENT);
+    if (k.empty()) {
+        std::cerr << "⚠️  No coefficient values in this log; skipping " << path << std::endl;
+        return true;
+    }
+    double x_lo = 0, x_hi = 0, y_lo, y_hi;
+    acc.x_range(&x_lo, &x_hi);
+    chart_pad_range(&x_lo, &x_hi);
+    y_lo = y_hi = k[0].y;
+    chart_extend_range(k, &y_lo, &y_hi);
+    chart_pad_range(&y_lo, &y_hi);
+    y_hi += (y_hi - y_lo) * 0.1;   // Room for the zone labels
+
+    SvgChart svg(1200, 600);
+    SvgChart::Axes ax{100, 60, 1060, 460, x_lo, x_hi, y_lo, y_hi};
+    svg.axes(ax, "Dynamic Temperature Coefficient Usage", "Temperature (°C)", "Coefficient k (%)");
+
+    const double zones[] = {-1e9, 5, 10, 15, 25, 30, 1e9};
+    const size_t zone_count = sizeof(zones) / sizeof(zones[0]) - 1;
+    for (size_t z = 1; z < zone_count; z++) svg.vline(ax, zones[z], "gray", 1, 0.4, "6,4");
+    for (size_t z = 0; z < zone_count; z++) {
+        double sum = 0;
+        size_t n = 0;
+        for (const ChartPoint &p : k) {
+            if (p.x > zones[z] && p.x <= zones[z + 1]) {
+                sum += p.y;
+                n++;
+            }
+        }
+        if (n == 0) continue;
+        double lo = std::max(zones[z], x_lo), hi = std::min(zones[z + 1], x_hi);
+        svg.text(ax.px((lo + hi) / 2), ax.top + 20, chart_number(sum / n, 2) + "%", 12, "middle");
+    }
+
+    std::vector<ChartPoint> shown = lttb_downsample(k, points);
+    svg.polyline(ax, shown, "purple", 2, 0.7);
+    svg.markers(ax, shown, "purple", 2.5, 0.7);
+    return svg.save(path);
+}
+
+#endif // EC_CHART_H
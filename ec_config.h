@@ -0,0 +1,324 @@
+#ifndef EC_CONFIG_H
+#define EC_CONFIG_H
+
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+#include "ec_sinks.h"
+#include "ec_timestamp.h"
+
+// ===========================
+// HOT-RELOADABLE CONFIGURATION
+// ===========================
+// The values an operator may want to change during a run without
+// restarting it: the dynamic-k tiers, the reference standard and
+// tolerance behind the PASS/FAIL verdict, the sampling period and extra
+// --sink outputs. They come from an optional file (--config), e.g.
+//
+//   standard = 12.88          # mS/cm reference solution
+//   tolerance = 0.10          # ± mS/cm for PASS
+//   poll_ms = 1000
+//   tier = 5 0.0180           # k up to and including 5 °C
+//   tier = 10 0.0184
+//   tier = above 0.0194       # k above the last tier
+//   sink = udp:192.168.1.20:5140
+//
+// Keys left out keep their built-in defaults (the values the logger has
+// always used); tier lines, if any, replace the whole table.
+//
+// Each version is an immutable LoggerConfig. ConfigStore publishes a new
+// one with a single atomic pointer store (RCU style); readers take the
+// pointer once per sample with an acquire load, so one sample is always
+// computed with one version and the hot path never locks or waits. Old
+// versions are retired but not freed: a reader may still be using one and
+// nothing tracks when it is done. A version is a few hundred bytes and a
+// new one only appears when someone saves the file, so they are kept
+// until exit.
+//
+// ConfigWatcher follows the file with inotify on its directory (editors
+// and config management usually replace the file by renaming a new one
+// over it). A file that fails to parse is reported and ignored: the
+// running version stays active.
+
+const double CONFIG_DEFAULT_STANDARD_EC = 12.88;   // mS/cm @ 25 °C
+const double CONFIG_DEFAULT_TOLERANCE = 0.10;      // ± mS/cm
+const int CONFIG_DEFAULT_POLL_MS = 1000;
+const int CONFIG_MIN_POLL_MS = 200;                // Three register reads must fit
+const int CONFIG_MAX_POLL_MS = 3600000;
+const double CONFIG_MAX_K = 0.1;                   // 10 %/°C; anything above is a typo
+const int CONFIG_SETTLE_MS = 200;                  // Quiet time after the last change before reading
+
+// k applies for temperatures up to and including max_temp
+struct KTier {
+    double max_temp;
+    double k;
+};
+
+struct LoggerConfig {
+    std::vector<KTier> tiers;    // Ascending max_temp
+    double k_above = 0;          // Above the last tier
+    double standard_ec = CONFIG_DEFAULT_STANDARD_EC;
+    double tolerance = CONFIG_DEFAULT_TOLERANCE;
+    int64_t period_ns = CONFIG_DEFAULT_POLL_MS * 1000000LL;
+    std::vector<SinkSpec> sinks; // In addition to the --sink outputs
+    uint32_t generation = 0;     // Set by ConfigStore; 1 = first version
+
+    double dynamic_k(double temp) const {
+        for (const KTier &tier : tiers) {
+            if (temp <= tier.max_temp) return tier.k;
+        }
+        return k_above;
+    }
+};
+
+// The coefficients from the calibration data
+inline LoggerConfig default_logger_config() {
+    LoggerConfig config;
+    config.tiers = {
+        {5.0, 0.0180},    // 1.80%
+        {10.0, 0.0184},   // 1.84%
+        {15.0, 0.0190},   // 1.90%
+        {25.0, 0.0190},   // 1.90% (flat range)
+        {30.0, 0.0192},   // 1.92%
+    };
+    config.k_above = 0.0194;   // 1.94%
+    return config;
+}
+
+// ===========================
+// CONFIG FILE PARSER
+// ===========================
+// KEY = VALUE per line; blank lines and '#' comments are ignored. Reports
+// every bad line and returns false if there was any; out is only
+// assigned on success.
+inline bool load_logger_config(const std::string &path, LoggerConfig &out) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "  Cannot open config file " << path << ": " << strerror(errno) << "\n";
+        return false;
+    }
+
+    LoggerConfig config = default_logger_config();
+    std::vector<KTier> tiers;
+    bool have_above = false;
+    bool ok = true;
+    std::string line;
+    int line_no = 0;
+    auto bad = [&](const std::string &what) {
+        std::cerr << "  " << path << ":" << line_no << ": " << what << "\n";
+        ok = false;
+    };
+
+    while (std::getline(in, line)) {
+        line_no++;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos) continue;
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            bad("expected KEY = VALUE");
+            continue;
+        }
+        std::string key = line.substr(first, eq - first);
+        key.erase(key.find_last_not_of(" \t") + 1);
+        std::string value = line.substr(eq + 1);
+        size_t v0 = value.find_first_not_of(" \t");
+        value = v0 == std::string::npos ? "" : value.substr(v0, value.find_last_not_of(" \t\r") + 1 - v0);
+
+        char *end = nullptr;
+        if (key == "standard" || key == "tolerance") {
+            double v = strtod(value.c_str(), &end);
+            if (end == value.c_str() || *end != '\0' || !(v > 0) || !std::isfinite(v)) {
+                bad(key + " must be a positive number");
+            } else if (key == "standard") {
+                config.standard_ec = v;
+            } else {
+                config.tolerance = v;
+            }
+        } else if (key == "poll_ms") {
+            long v = strtol(value.c_str(), &end, 10);
+            if (end == value.c_str() || *end != '\0' || v < CONFIG_MIN_POLL_MS || v > CONFIG_MAX_POLL_MS) {
+                bad("poll_ms must be " + std::to_string(CONFIG_MIN_POLL_MS) + ".." +
+                    std::to_string(CONFIG_MAX_POLL_MS));
+            } else {
+                config.period_ns = v * 1000000LL;
+            }
+        } else if (key == "tier") {
+            std::istringstream ss(value);
+            std::string temp_text, k_text, extra;
+            ss >> temp_text >> k_text >> extra;
+            double k = strtod(k_text.c_str(), &end);
+            if (k_text.empty() || *end != '\0' || !(k > 0) || k > CONFIG_MAX_K || !extra.empty()) {
+                bad("expected tier = MAX_TEMP K (or above K), 0 < K <= 0.1");
+                continue;
+            }
+            if (temp_text == "above") {
+                if (have_above) bad("second 'tier = above'");
+                config.k_above = k;
+                have_above = true;
+                continue;
+            }
+            double max_temp = strtod(temp_text.c_str(), &end);
+            if (temp_text.empty() || *end != '\0' || !std::isfinite(max_temp)) {
+                bad("tier temperature must be a number or 'above'");
+            } else if (!tiers.empty() && max_temp <= tiers.back().max_temp) {
+                bad("tiers must be in ascending temperature order");
+            } else {
+                tiers.push_back({max_temp, k});
+            }
+        } else if (key == "sink") {
+            SinkSpec spec;
+            if (!parse_sink_spec(value, spec)) bad("invalid sink");
+            else config.sinks.push_back(spec);
+        } else {
+            bad("unknown key '" + key + "' (standard, tolerance, poll_ms, tier, sink)");
+        }
+    }
+
+    if (!tiers.empty() || have_above) {
+        if (tiers.empty() || !have_above) {
+            std::cerr << "  " << path << ": a tier table needs at least one 'tier = TEMP K' and a 'tier = above K'\n";
+            ok = false;
+        }
+        config.tiers = tiers;
+    }
+    if (ok) out = config;
+    return ok;
+}
+
+// ===========================
+// VERSIONED CONFIG STORE
+// ===========================
+class ConfigStore {
+public:
+    ConfigStore() { publish(default_logger_config()); }
+    ConfigStore(const ConfigStore &) = delete;
+    ConfigStore &operator=(const ConfigStore &) = delete;
+
+    // Any thread, wait-free. The version stays valid for the store's
+    // lifetime; take it once per sample and use only that one.
+    const LoggerConfig *current() const { return current_.load(std::memory_order_acquire); }
+
+    // Makes config the active version; returns it
+    const LoggerConfig *publish(LoggerConfig config) {
+        std::lock_guard<std::mutex> lock(publish_mutex_);   // Publishers only
+        config.generation = static_cast<uint32_t>(versions_.size() + 1);
+        versions_.emplace_back(new LoggerConfig(std::move(config)));
+        const LoggerConfig *version = versions_.back().get();
+        current_.store(version, std::memory_order_release);
+        return version;
+    }
+
+private:
+    std::atomic<const LoggerConfig *> current_{nullptr};
+    std::mutex publish_mutex_;
+    std::vector<std::unique_ptr<const LoggerConfig>> versions_;   // Every version ever published
+};
+
+// ===========================
+// CONFIG FILE WATCHER
+// ===========================
+class ConfigWatcher {
+public:
+    // Runs on the watcher thread after each reload attempt: the new
+    // version, or nullptr if the file was rejected
+    typedef std::function<void(const LoggerConfig *)> ReloadFn;
+
+    ~ConfigWatcher() { stop(); }
+
+    bool start(const std::string &path, ConfigStore *store, ReloadFn on_reload) {
+        path_ = path;
+        store_ = store;
+        on_reload_ = on_reload;
+        size_t slash = path.rfind('/');
+        std::string dir = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+        name_ = slash == std::string::npos ? path : path.substr(slash + 1);
+
+        fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd_ == -1 || inotify_add_watch(fd_, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) == -1) {
+            std::cerr << "⚠️  Cannot watch " << path << " for changes: " << strerror(errno) << std::endl;
+            if (fd_ != -1) close(fd_);
+            fd_ = -1;
+            return false;
+        }
+        running_ = true;
+        thread_ = std::thread(&ConfigWatcher::run, this);
+        return true;
+    }
+
+    void stop() {
+        if (!thread_.joinable()) return;
+        running_ = false;
+        thread_.join();
+        close(fd_);
+        fd_ = -1;
+    }
+
+private:
+    std::string path_, name_;
+    ConfigStore *store_ = nullptr;
+    ReloadFn on_reload_;
+    int fd_ = -1;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    // True if the pending events include our file
+    bool drain_events() {
+        alignas(struct inotify_event) char buf[4096];
+        bool hit = false;
+        ssize_t n;
+        while ((n = read(fd_, buf, sizeof(buf))) > 0) {
+            for (char *p = buf; p < buf + n;) {
+                const struct inotify_event *ev = reinterpret_cast<const struct inotify_event *>(p);
+                if (ev->len > 0 && name_ == ev->name) hit = true;
+                p += sizeof(struct inotify_event) + ev->len;
+            }
+        }
+        return hit;
+    }
+
+    static int64_t mono_ns() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return timespec_to_ns(ts);
+    }
+
+    // Polls with a short timeout so stop() is noticed; a change is read
+    // once the file has been quiet for CONFIG_SETTLE_MS
+    void run() {
+        struct pollfd pfd = {fd_, POLLIN, 0};
+        int64_t reload_at = 0;   // 0 = nothing pending
+        while (running_) {
+            if (poll(&pfd, 1, 100) > 0 && drain_events()) {
+                reload_at = mono_ns() + CONFIG_SETTLE_MS * 1000000LL;
+            }
+            if (reload_at == 0 || mono_ns() < reload_at) continue;
+            reload_at = 0;
+
+            LoggerConfig config;
+            const LoggerConfig *version = nullptr;
+            if (load_logger_config(path_, config)) version = store_->publish(config);
+            if (on_reload_) on_reload_(version);
+        }
+    }
+};
+
+#endif // EC_CONFIG_H
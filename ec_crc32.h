@@ -0,0 +1,48 @@
+#ifndef EC_CRC32_H
+#define EC_CRC32_H
+
+#include <cstddef>
+#include <cstdint>
+
+// ===========================
+// CRC-32 (IEEE 802.3, reflected 0xEDB88320)
+// ===========================
+// Same polynomial as zlib / gzip, so values can be cross-checked with
+// Python's zlib.crc32(). The table is built once, on first use
+// (function-local static, so initialization is thread-safe).
+
+struct Crc32Table {
+    uint32_t entries[256];
+
+    Crc32Table() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int bit = 0; bit < 8; bit++) {
+                c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            }
+            entries[i] = c;
+        }
+    }
+};
+
+inline const uint32_t *crc32_table() {
+    static const Crc32Table table;
+    return table.entries;
+}
+
+// Continue a running CRC (pass 0 to start a new one)
+inline uint32_t crc32_update(uint32_t crc, const void *data, size_t len) {
+    const uint32_t *table = crc32_table();
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+inline uint32_t crc32_compute(const void *data, size_t len) {
+    return crc32_update(0, data, len);
+}
+
+#endif // EC_CRC32_H
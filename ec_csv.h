@@ -0,0 +1,325 @@
+#ifndef EC_CSV_H
+#define EC_CSV_H
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "ec_sample.h"
+#include "ec_timestamp.h"
+#include "ec_log_segment.h"
+
+// ===========================
+// CSV LOG LAYOUT (8 columns, hex-validated)
+// ===========================
+// Shared by smart_logger's CSV sink and ec_log_tool so both produce
+// byte-for-byte the same rows.
+const char CSV_LOG_HEADER[] =
+    "Timestamp,Temperature,Hex_Temp,Raw_EC,Hex_Raw_EC,Sensor_Default_EC,Smart_Calc_EC,Deviation\n";
+
+// "YYYY-MM-DD HH:MM:SS" in local time (for one-off messages; row writers
+// keep their own TimestampFormatter)
+inline std::string format_timestamp_ns(int64_t timestamp_ns) {
+    thread_local TimestampFormatter formatter;
+    return formatter.format(timestamp_ns);
+}
+
+// ===========================
+// ROW FORMATTING (no allocations)
+// ===========================
+// A row is built in a caller-provided char buffer: std::to_chars for the
+// numbers, a nibble table for the hex words, the cached TimestampFormatter
+// for the time. Column precision:
+//
+//   Timestamp                   TimestampFormatter precision (default: seconds)
+//   Temperature, Raw_EC,        6 significant digits, shortest of fixed/
+//   Sensor_Default_EC,          scientific, trailing zeros dropped (printf
+//   Smart_Calc_EC, Deviation    "%g"), the std::ostream default these logs
+//                               were always written with
+//   Hex_Temp, Hex_Raw_EC        8 uppercase hex digits, ABCD word order
+
+const int CSV_FLOAT_DIGITS = 6;
+const size_t CSV_ROW_MAX_CHARS = 256;     // Longest possible row is ~150 chars
+const char CSV_HEX_DIGITS[] = "0123456789ABCDEF";
+const double CSV_POW10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+
+// "%g" with 6 digits. Fast path for values with a float's 24-bit mantissa
+// (every column but Deviation, and Deviation almost always) in the fixed
+// notation range: |v| * 10^k for k <= 9 then needs at most 24 + 21 bits
+// and is exact in a double, so rounding it to 6 digits with nearbyint()
+// (ties to even) matches printf exactly. Everything else (NaN, inf,
+// scientific notation, wider mantissas) goes through std::to_chars.
+inline char *csv_put_float(char *p, char *end, double value) {
+    double mag = std::fabs(value);
+    if (mag == 0) {
+        if (std::signbit(value)) *p++ = '-';
+        *p++ = '0';
+        return p;
+    }
+    if (mag >= 1e-4 && mag < 1e6 && static_cast<double>(static_cast<float>(value)) == value) {
+        // Decimal exponent e such that 10^5 <= mag * 10^(5-e) < 10^6
+        int e = 5;
+        while (e > -4 && mag * CSV_POW10[5 - e] < 1e5) e--;
+        double digits = std::nearbyint(mag * CSV_POW10[5 - e]);
+        if (digits >= 1e5) {
+            if (digits == 1e6) {
+                digits = 1e5;
+                e++;
+            }
+            if (e < CSV_FLOAT_DIGITS) {
+                char d[CSV_FLOAT_DIGITS];
+                uint32_t m = static_cast<uint32_t>(digits);
+                for (int i = CSV_FLOAT_DIGITS - 1; i >= 0; i--) {
+                    d[i] = static_cast<char>('0' + m % 10);
+                    m /= 10;
+                }
+                int int_digits = e >= 0 ? e + 1 : 0;
+                int n = CSV_FLOAT_DIGITS;
+                while (n > int_digits && d[n - 1] == '0') n--;
+
+                if (value < 0) *p++ = '-';
+                if (e >= 0) {
+                    memcpy(p, d, int_digits);
+                    p += int_digits;
+                } else {
+                    *p++ = '0';
+                }
+                if (n > int_digits) {
+                    *p++ = '.';
+                    for (int z = e + 1; z < 0; z++) *p++ = '0';
+                    memcpy(p, d + int_digits, n - int_digits);
+                    p += n - int_digits;
+                }
+                return p;
+            }
+        }
+    }
+    return std::to_chars(p, end, value, std::chars_format::general, CSV_FLOAT_DIGITS).ptr;
+}
+
+// Two ABCD registers -> "41351A86" (exactly 8 chars, no NUL)
+inline char *csv_put_hex_regs(char *p, const uint16_t *regs) {
+    for (int w = 0; w < 2; w++) {
+        for (int shift = 12; shift >= 0; shift -= 4) {
+            *p++ = CSV_HEX_DIGITS[(regs[w] >> shift) & 0xF];
+        }
+    }
+    return p;
+}
+
+inline std::string regs_to_hex(const uint16_t *regs) {
+    char buf[8];
+    csv_put_hex_regs(buf, regs);
+    return std::string(buf, sizeof(buf));
+}
+
+// Writes one row including '\n' into buf (CSV_ROW_MAX_CHARS bytes) and
+// returns its length
+inline size_t format_sample_csv_row(char *buf, const SampleRecord &rec, TimestampFormatter &ts_format) {
+    char *end = buf + CSV_ROW_MAX_CHARS;
+    char *p = buf + ts_format.format(rec.timestamp_ns, buf);
+    double deviation = static_cast<double>(rec.sensor_ec) - rec.smart_ec;
+    *p++ = ',';
+    p = csv_put_float(p, end, rec.temp);
+    *p++ = ',';
+    p = csv_put_hex_regs(p, rec.reg_temp);
+    *p++ = ',';
+    p = csv_put_float(p, end, rec.raw_ec);
+    *p++ = ',';
+    p = csv_put_hex_regs(p, rec.reg_raw_ec);
+    *p++ = ',';
+    p = csv_put_float(p, end, rec.sensor_ec);
+    *p++ = ',';
+    p = csv_put_float(p, end, rec.smart_ec);
+    *p++ = ',';
+    p = csv_put_float(p, end, deviation);
+    *p++ = '\n';
+    return p - buf;
+}
+
+inline void write_sample_csv_row(std::ostream &out, const SampleRecord &rec,
+                                 TimestampFormatter &ts_format) {
+    char row[CSV_ROW_MAX_CHARS];
+    out.write(row, format_sample_csv_row(row, rec, ts_format));
+}
+
+// ===========================
+// CSV LOG WRITER
+// ===========================
+// Appends formatted rows to a user-space buffer; flush() hands the whole
+// buffer to the OS in one write() and sync() makes it durable. Uses a raw
+// file descriptor (not std::ofstream) so fdatasync() is available.
+//
+// Torn-tail recovery: a crash mid-write leaves a final line without its
+// '\n'. open() inspects only the last CSV_TAIL_SCAN_BYTES of the file and
+// truncates back to the last complete line before appending.
+
+const size_t CSV_TAIL_SCAN_BYTES = 64 * 1024;
+
+class CsvLogWriter {
+public:
+    CsvLogWriter() {}
+    ~CsvLogWriter() { close(); }
+    CsvLogWriter(const CsvLogWriter &) = delete;
+    CsvLogWriter &operator=(const CsvLogWriter &) = delete;
+
+    bool open(const std::string &path) {
+        close();
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+        if (fd_ == -1) {
+            std::cerr << "❌ Cannot open CSV log " << path << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+
+        off_t size = recover_tail(path);
+        if (size > 0 && !header_matches()) {
+            // Never mix column layouts in one file
+            ::close(fd_);
+            fd_ = -1;
+            if (log_archive_segment(path, "CSV header differs from this version's columns").empty()) {
+                return false;
+            }
+            fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+            if (fd_ == -1) {
+                std::cerr << "❌ Cannot open CSV log " << path << ": " << strerror(errno) << std::endl;
+                return false;
+            }
+            size = 0;
+        }
+        file_size_ = size;
+        if (size == 0) {
+            // Write header if new file (with hex validation columns)
+            pending_.assign(CSV_LOG_HEADER);
+            return flush();
+        }
+        return true;
+    }
+
+    // Formats straight into pending_, whose capacity is kept across
+    // flushes, so steady-state appends do not allocate
+    void append(const SampleRecord &rec) {
+        size_t used = pending_.size();
+        if (pending_.capacity() - used < CSV_ROW_MAX_CHARS) {
+            pending_.reserve(std::max(2 * pending_.capacity(), used + CSV_ROW_MAX_CHARS));
+        }
+        pending_.resize(used + CSV_ROW_MAX_CHARS);
+        pending_.resize(used + format_sample_csv_row(&pending_[used], rec, ts_format_));
+    }
+
+    // Fractional seconds in the Timestamp column (default: whole seconds)
+    void set_timestamp_precision(TimestampPrecision precision) {
+        ts_format_.set_precision(precision);
+    }
+
+    // One write() for everything appended since the last flush
+    bool flush() {
+        if (fd_ == -1) {
+            pending_.clear();   // No file (a reopen failed): drop, do not grow
+            return false;
+        }
+        const char *data = pending_.data();
+        size_t len = pending_.size();
+        bool ok = true;
+        while (len > 0) {
+            ssize_t n = ::write(fd_, data, len);
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                std::cerr << "❌ CSV log write failed: " << strerror(errno) << std::endl;
+                ok = false;
+                break;
+            }
+            data += n;
+            len -= n;
+            file_size_ += n;
+        }
+        pending_.clear();
+        return ok;
+    }
+
+    bool sync() {
+        if (fd_ == -1) return false;
+        if (fdatasync(fd_) == -1) {
+            std::cerr << "❌ CSV log fdatasync failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (fd_ == -1) return;
+        flush();
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+    bool is_open() const { return fd_ != -1; }
+    uint64_t torn_bytes() const { return torn_bytes_; }
+
+    bool has_rows() const { return file_size_ > sizeof(CSV_LOG_HEADER) - 1 || !pending_.empty(); }
+
+    // Byte offset where the next append()ed row will start (skip is always 0)
+    void next_position(uint64_t *offset, uint32_t *skip) const {
+        *offset = file_size_ + pending_.size();
+        *skip = 0;
+    }
+
+private:
+    int fd_ = -1;
+    uint64_t file_size_ = 0;        // Bytes already handed to the OS
+    uint64_t torn_bytes_ = 0;       // Bytes discarded by tail recovery on open
+    std::string pending_;           // Rows not yet handed to the OS
+    TimestampFormatter ts_format_;
+
+    bool header_matches() {
+        char head[sizeof(CSV_LOG_HEADER) - 1];
+        return pread(fd_, head, sizeof(head), 0) == static_cast<ssize_t>(sizeof(head)) &&
+               memcmp(head, CSV_LOG_HEADER, sizeof(head)) == 0;
+    }
+
+    // Returns the file size after recovery
+    off_t recover_tail(const std::string &path) {
+        struct stat st;
+        fstat(fd_, &st);
+        off_t size = st.st_size;
+        if (size == 0) return 0;
+
+        size_t window = size < static_cast<off_t>(CSV_TAIL_SCAN_BYTES)
+                            ? static_cast<size_t>(size) : CSV_TAIL_SCAN_BYTES;
+        std::string tail(window, '\0');
+        off_t start = size - window;
+        if (pread(fd_, &tail[0], window, start) != static_cast<ssize_t>(window)) return size;
+        if (tail[window - 1] == '\n') return size;
+
+        size_t last_nl = tail.rfind('\n');
+        off_t keep;
+        if (last_nl != std::string::npos) {
+            keep = start + last_nl + 1;
+        } else if (start == 0) {
+            keep = 0;   // Not even the header line survived
+        } else {
+            std::cerr << "⚠️  " << path << ": no line break in the last "
+                      << window << " bytes, not truncating" << std::endl;
+            return size;
+        }
+
+        if (ftruncate(fd_, keep) == -1) {
+            std::cerr << "⚠️  " << path << ": could not truncate torn tail: "
+                      << strerror(errno) << std::endl;
+            return size;
+        }
+        torn_bytes_ = size - keep;
+        std::cerr << "⚠️  " << path << ": removed " << torn_bytes_
+                  << " byte(s) of a torn row at the tail" << std::endl;
+        return keep;
+    }
+};
+
+#endif // EC_CSV_H
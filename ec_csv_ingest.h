@@ -0,0 +1,438 @@
+#ifndef EC_CSV_INGEST_H
+#define EC_CSV_INGEST_H
+
+#include <charconv>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "ec_sample.h"
+#include "ec_csv.h"
+
+// ===========================
+// CSV LOG INGEST
+// ===========================
+// Parses smart_logger CSV logs back into SampleRecords. Two layouts have
+// been written over the project's life, often into the same file with no
+// header between them:
+//
+//   LEGACY (10 columns)  Timestamp,Temperature,Raw_EC,Sensor_Default_EC,
+//                        Smart_Calc_EC,Coefficient_Used,Deviation,
+//                        Distance_from_12_88_Sensor,Distance_from_12_88_Smart,
+//                        Improvement_Score
+//   HEX    (8 columns)   CSV_LOG_HEADER (ec_csv.h)
+//
+// The schema is detected per line from its column count, and consecutive
+// lines of one schema are reported as a segment. Header lines are skipped.
+// Rows that do not parse are rejected with a reason instead of aborting.
+//
+// The file is split into chunks at line boundaries so chunks can be parsed
+// on separate threads; csv_ingest_chunk() touches nothing but its own
+// CsvChunkResult.
+
+enum CsvSchema {
+    CSV_SCHEMA_UNKNOWN = 0,
+    CSV_SCHEMA_LEGACY = 1,    // 10 columns, no hex
+    CSV_SCHEMA_HEX = 2        // 8 columns, hex-validated
+};
+
+const int CSV_LEGACY_COLUMNS = 10;
+const int CSV_HEX_COLUMNS = 8;
+const int CSV_MAX_COLUMNS = 16;
+const size_t CSV_REJECT_TEXT_MAX = 160;      // Chars of a rejected line kept for the report
+const double CSV_HEX_TOLERANCE = 1e-5;       // Relative; text floats carry 6 significant digits
+const double CSV_STANDARD_EC = 12.88;        // Same reference and tolerance as smart_logger,
+const double CSV_PASS_TOLERANCE = 0.10;      // used to rebuild the PASS flags
+
+enum CsvRejectReason {
+    CSV_REJECT_COLUMNS = 0,       // Column count matches no schema (torn/merged line)
+    CSV_REJECT_TIMESTAMP = 1,     // Not "YYYY-MM-DD HH:MM:SS[.fff]"
+    CSV_REJECT_NUMBER = 2,        // Numeric field empty, malformed or not finite
+    CSV_REJECT_HEX = 3,           // Hex field is not 8 hex digits
+    CSV_REJECT_HEX_MISMATCH = 4,  // Hex registers disagree with the printed value
+    CSV_REJECT_REASON_COUNT = 5
+};
+
+inline const char *csv_schema_name(CsvSchema schema) {
+    switch (schema) {
+        case CSV_SCHEMA_LEGACY: return "legacy 10-column";
+        case CSV_SCHEMA_HEX:    return "hex 8-column";
+        default:                return "unknown";
+    }
+}
+
+inline const char *csv_reject_reason_name(CsvRejectReason reason) {
+    switch (reason) {
+        case CSV_REJECT_COLUMNS:      return "column count";
+        case CSV_REJECT_TIMESTAMP:    return "bad timestamp";
+        case CSV_REJECT_NUMBER:       return "bad number";
+        case CSV_REJECT_HEX:          return "bad hex";
+        case CSV_REJECT_HEX_MISMATCH: return "hex mismatch";
+        default:                      return "unknown";
+    }
+}
+
+struct CsvRejection {
+    uint64_t line;               // 1-based line number in the input
+    CsvRejectReason reason;
+    std::string text;            // Offending line, truncated
+};
+
+struct CsvSegment {
+    uint64_t first_line;         // 1-based line where the segment starts
+    CsvSchema schema;
+    uint64_t rows;               // Accepted rows
+    bool has_header;             // Segment starts with a header line
+};
+
+struct CsvChunkResult {
+    uint64_t lines = 0;
+    uint64_t header_lines = 0;
+    std::vector<SampleRecord> records;     // Filled unless the caller wants text
+    std::string csv_text;                  // Filled when re-emitting CSV
+    std::vector<CsvRejection> rejections;
+    std::vector<CsvSegment> segments;
+    uint64_t reject_counts[CSV_REJECT_REASON_COUNT] = {0};
+};
+
+// ===========================
+// READ-ONLY FILE MAPPING
+// ===========================
+class MappedFile {
+public:
+    MappedFile() {}
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool open(const std::string &path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd == -1) {
+            std::cerr << "❌ Cannot open " << path << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        struct stat st;
+        fstat(fd, &st);
+        size_ = st.st_size;
+        if (size_ == 0) {
+            ::close(fd);
+            return true;
+        }
+        void *map = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (map == MAP_FAILED) {
+            std::cerr << "❌ mmap failed for " << path << ": " << strerror(errno) << std::endl;
+            size_ = 0;
+            return false;
+        }
+        data_ = static_cast<const char *>(map);
+        madvise(map, size_, MADV_SEQUENTIAL);
+        return true;
+    }
+
+    void close() {
+        if (data_) munmap(const_cast<char *>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    const char *data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Split [0, size) into ranges of about chunk_bytes that end just after a '\n'
+inline std::vector<std::pair<size_t, size_t> > csv_split_chunks(const char *data, size_t size,
+                                                                size_t chunk_bytes) {
+    std::vector<std::pair<size_t, size_t> > chunks;
+    size_t begin = 0;
+    while (begin < size) {
+        size_t end = begin + chunk_bytes;
+        if (end >= size) {
+            end = size;
+        } else {
+            const char *nl = static_cast<const char *>(memchr(data + end, '\n', size - end));
+            end = nl ? static_cast<size_t>(nl - data) + 1 : size;
+        }
+        chunks.push_back(std::make_pair(begin, end));
+        begin = end;
+    }
+    return chunks;
+}
+
+// ===========================
+// FIELD PARSERS
+// ===========================
+// Local-time "YYYY-MM-DD HH:MM:SS" -> ns. mktime() is slow and takes a
+// global lock, so each thread caches the epoch of the current hour (DST
+// changes happen on hour boundaries).
+struct CsvTimeCache {
+    char key[13] = {0};          // "YYYY-MM-DD HH"
+    int64_t hour_epoch = 0;
+};
+
+inline bool csv_parse_digits(const char *p, int n, int *out) {
+    int v = 0;
+    for (int i = 0; i < n; i++) {
+        if (p[i] < '0' || p[i] > '9') return false;
+        v = v * 10 + (p[i] - '0');
+    }
+    *out = v;
+    return true;
+}
+
+inline bool csv_parse_timestamp(const char *b, const char *e, CsvTimeCache &cache, int64_t *out_ns) {
+    if (e - b < 19 || b[4] != '-' || b[7] != '-' || b[10] != ' ' || b[13] != ':' || b[16] != ':') {
+        return false;
+    }
+    int year, month, day, hour, minute, second;
+    if (!csv_parse_digits(b, 4, &year) || !csv_parse_digits(b + 5, 2, &month) ||
+        !csv_parse_digits(b + 8, 2, &day) || !csv_parse_digits(b + 11, 2, &hour) ||
+        !csv_parse_digits(b + 14, 2, &minute) || !csv_parse_digits(b + 17, 2, &second)) {
+        return false;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+        return false;
+    }
+
+    // Optional ".mmm" / ".nnnnnnnnn" (smart_logger --ts-precision)
+    int64_t frac_ns = 0;
+    if (e - b > 19) {
+        int digits = static_cast<int>(e - b) - 20;
+        if (b[19] != '.' || digits < 1 || digits > 9) return false;
+        int frac;
+        if (!csv_parse_digits(b + 20, digits, &frac)) return false;
+        frac_ns = frac;
+        for (int i = digits; i < 9; i++) frac_ns *= 10;
+    }
+
+    if (memcmp(cache.key, b, sizeof(cache.key)) != 0) {
+        struct tm t;
+        memset(&t, 0, sizeof(t));
+        t.tm_year = year - 1900;
+        t.tm_mon = month - 1;
+        t.tm_mday = day;
+        t.tm_hour = hour;
+        t.tm_isdst = -1;
+        time_t epoch = mktime(&t);
+        if (epoch == -1) return false;
+        memcpy(cache.key, b, sizeof(cache.key));
+        cache.hour_epoch = epoch;
+    }
+    *out_ns = (cache.hour_epoch + minute * 60 + second) * 1000000000LL + frac_ns;
+    return true;
+}
+
+inline bool csv_parse_float(const char *b, const char *e, float *out) {
+    if (b == e) return false;
+    if (*b == '+') b++;
+    std::from_chars_result r = std::from_chars(b, e, *out);
+    return r.ec == std::errc() && r.ptr == e && std::isfinite(*out);
+}
+
+// "41351A86" -> {0x4135, 0x1A86}
+inline bool csv_parse_hex_regs(const char *b, const char *e, uint16_t *regs) {
+    if (e - b != 8) return false;
+    uint32_t bits;
+    std::from_chars_result r = std::from_chars(b, e, bits, 16);
+    if (r.ec != std::errc() || r.ptr != e) return false;
+    regs[0] = static_cast<uint16_t>(bits >> 16);
+    regs[1] = static_cast<uint16_t>(bits & 0xFFFF);
+    return true;
+}
+
+inline bool csv_hex_matches(float from_hex, float printed) {
+    double diff = std::fabs(static_cast<double>(from_hex) - printed);
+    return diff <= CSV_HEX_TOLERANCE * std::fmax(1.0, std::fabs(printed));
+}
+
+// ===========================
+// LINE PARSER
+// ===========================
+// Returns true and fills rec for an accepted data row. Header lines return
+// false with *schema set and *is_header true; rejected rows return false
+// with *reason set.
+inline bool csv_parse_line(const char *b, const char *e, CsvTimeCache &cache, SampleRecord *rec,
+                           CsvSchema *schema, bool *is_header, CsvRejectReason *reason) {
+    if (e > b && e[-1] == '\r') e--;
+
+    const char *field_b[CSV_MAX_COLUMNS];
+    const char *field_e[CSV_MAX_COLUMNS];
+    int columns = 0;
+    const char *p = b;
+    while (true) {
+        const char *comma = static_cast<const char *>(memchr(p, ',', e - p));
+        const char *end = comma ? comma : e;
+        if (columns < CSV_MAX_COLUMNS) {
+            field_b[columns] = p;
+            field_e[columns] = end;
+        }
+        columns++;
+        if (!comma) break;
+        p = comma + 1;
+    }
+
+    *is_header = false;
+    if (columns == CSV_LEGACY_COLUMNS) {
+        *schema = CSV_SCHEMA_LEGACY;
+    } else if (columns == CSV_HEX_COLUMNS) {
+        *schema = CSV_SCHEMA_HEX;
+    } else {
+        *schema = CSV_SCHEMA_UNKNOWN;
+        *reason = CSV_REJECT_COLUMNS;
+        return false;
+    }
+
+    if (field_e[0] - field_b[0] == 9 && memcmp(field_b[0], "Timestamp", 9) == 0) {
+        *is_header = true;
+        return false;
+    }
+
+    memset(rec, 0, sizeof(*rec));
+    if (!csv_parse_timestamp(field_b[0], field_e[0], cache, &rec->timestamp_ns)) {
+        *reason = CSV_REJECT_TIMESTAMP;
+        return false;
+    }
+
+    float temp, raw_ec, sensor_ec, smart_ec;
+    if (*schema == CSV_SCHEMA_LEGACY) {
+        float k, extra;
+        if (!csv_parse_float(field_b[1], field_e[1], &temp) ||
+            !csv_parse_float(field_b[2], field_e[2], &raw_ec) ||
+            !csv_parse_float(field_b[3], field_e[3], &sensor_ec) ||
+            !csv_parse_float(field_b[4], field_e[4], &smart_ec) ||
+            !csv_parse_float(field_b[5], field_e[5], &k)) {
+            *reason = CSV_REJECT_NUMBER;
+            return false;
+        }
+        for (int c = 6; c < CSV_LEGACY_COLUMNS; c++) {
+            if (!csv_parse_float(field_b[c], field_e[c], &extra)) {
+                *reason = CSV_REJECT_NUMBER;
+                return false;
+            }
+        }
+        // No register words were logged; rebuild them from the printed values
+        sample_float_to_regs(temp, rec->reg_temp);
+        sample_float_to_regs(raw_ec, rec->reg_raw_ec);
+        rec->k = k;
+    } else {
+        float deviation;
+        if (!csv_parse_float(field_b[1], field_e[1], &temp) ||
+            !csv_parse_float(field_b[3], field_e[3], &raw_ec) ||
+            !csv_parse_float(field_b[5], field_e[5], &sensor_ec) ||
+            !csv_parse_float(field_b[6], field_e[6], &smart_ec) ||
+            !csv_parse_float(field_b[7], field_e[7], &deviation)) {
+            *reason = CSV_REJECT_NUMBER;
+            return false;
+        }
+        if (!csv_parse_hex_regs(field_b[2], field_e[2], rec->reg_temp) ||
+            !csv_parse_hex_regs(field_b[4], field_e[4], rec->reg_raw_ec)) {
+            *reason = CSV_REJECT_HEX;
+            return false;
+        }
+        // The registers are the ground truth; the text is a 6-digit rounding
+        float hex_temp = sample_bits_float((uint32_t(rec->reg_temp[0]) << 16) | rec->reg_temp[1]);
+        float hex_raw = sample_bits_float((uint32_t(rec->reg_raw_ec[0]) << 16) | rec->reg_raw_ec[1]);
+        if (!csv_hex_matches(hex_temp, temp) || !csv_hex_matches(hex_raw, raw_ec)) {
+            *reason = CSV_REJECT_HEX_MISMATCH;
+            return false;
+        }
+        temp = hex_temp;
+        raw_ec = hex_raw;
+        // k was not logged: recover it from smart = raw / (1 + k (T - 25)),
+        // rounded to the 4 decimals of the coefficient table
+        if (std::fabs(temp - 25.0f) >= 0.5f && smart_ec != 0.0f) {
+            double k = (static_cast<double>(raw_ec) / smart_ec - 1.0) / (temp - 25.0);
+            rec->k = static_cast<float>(std::round(k * 1e4) / 1e4);
+        }
+    }
+
+    sample_float_to_regs(sensor_ec, rec->reg_sensor_ec);
+    rec->temp = temp;
+    rec->raw_ec = raw_ec;
+    rec->sensor_ec = sensor_ec;
+    rec->smart_ec = smart_ec;
+    if (std::fabs(sensor_ec - CSV_STANDARD_EC) <= CSV_PASS_TOLERANCE) rec->flags |= SAMPLE_FLAG_SENSOR_PASS;
+    if (std::fabs(smart_ec - CSV_STANDARD_EC) <= CSV_PASS_TOLERANCE) rec->flags |= SAMPLE_FLAG_SMART_PASS;
+    return true;
+}
+
+// ===========================
+// CHUNK PARSER (one per thread)
+// ===========================
+// Line numbers in the result are relative to the chunk (first line = 1);
+// csv_merge_chunk() rebases them.
+inline void csv_ingest_chunk(const char *b, const char *e, bool emit_csv, CsvChunkResult &out) {
+    CsvTimeCache cache;
+    TimestampFormatter ts_format;
+    char row[CSV_ROW_MAX_CHARS];
+    SampleRecord rec;
+
+    const char *p = b;
+    while (p < e) {
+        const char *nl = static_cast<const char *>(memchr(p, '\n', e - p));
+        const char *line_end = nl ? nl : e;
+        out.lines++;
+
+        CsvSchema schema;
+        bool is_header;
+        CsvRejectReason reason;
+        bool blank = (line_end == p) || (line_end == p + 1 && *p == '\r');
+        if (blank) {
+            // Ignore empty lines
+        } else if (csv_parse_line(p, line_end, cache, &rec, &schema, &is_header, &reason)) {
+            if (out.segments.empty() || out.segments.back().schema != schema) {
+                out.segments.push_back(CsvSegment{out.lines, schema, 0, false});
+            }
+            out.segments.back().rows++;
+            if (emit_csv) {
+                out.csv_text.append(row, format_sample_csv_row(row, rec, ts_format));
+            } else {
+                out.records.push_back(rec);
+            }
+        } else if (is_header) {
+            out.header_lines++;
+            out.segments.push_back(CsvSegment{out.lines, schema, 0, true});
+        } else {
+            size_t len = line_end - p;
+            if (len > CSV_REJECT_TEXT_MAX) len = CSV_REJECT_TEXT_MAX;
+            out.rejections.push_back(CsvRejection{out.lines, reason, std::string(p, len)});
+            out.reject_counts[reason]++;
+        }
+        p = nl ? nl + 1 : e;
+    }
+}
+
+// Append a chunk's segments/rejections to the running totals, rebasing
+// line numbers by the lines seen so far
+inline void csv_merge_chunk(CsvChunkResult &chunk, uint64_t line_base, std::vector<CsvSegment> &segments,
+                            std::vector<CsvRejection> &rejections, uint64_t *reject_counts) {
+    for (size_t i = 0; i < chunk.segments.size(); i++) {
+        CsvSegment seg = chunk.segments[i];
+        seg.first_line += line_base;
+        if (i == 0 && !seg.has_header && !segments.empty() && segments.back().schema == seg.schema) {
+            segments.back().rows += seg.rows;   // Segment continues across the chunk boundary
+        } else {
+            segments.push_back(seg);
+        }
+    }
+    for (CsvRejection &r : chunk.rejections) {
+        r.line += line_base;
+        rejections.push_back(std::move(r));
+    }
+    for (int i = 0; i < CSV_REJECT_REASON_COUNT; i++) reject_counts[i] += chunk.reject_counts[i];
+}
+
+#endif // EC_CSV_INGEST_H
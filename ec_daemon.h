@@ -0,0 +1,135 @@
+#ifndef EC_DAEMON_H
+#define EC_DAEMON_H
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "ec_timestamp.h"
+
+// ===========================
+// SIGNALS (signalfd)
+// ===========================
+// SIGINT, SIGTERM and SIGHUP are blocked on the main thread before any
+// other thread is started, so every thread inherits the mask and the
+// signals are never delivered asynchronously anywhere: they queue on one
+// signalfd, and the acquisition loop reads them while it waits for the
+// next sample tick. Shutdown is therefore ordinary code on the main
+// thread (drain the queues, close the logs, print the statistics), not a
+// handler restricted to async-signal-safe calls.
+//
+// Interactive steps (the diagnostics monitor, the calibration prompt)
+// wait on the same descriptor, so Ctrl+C there also ends the program
+// cleanly and restores the terminal.
+
+class SignalChannel {
+public:
+    SignalChannel() {}
+    ~SignalChannel() { close(); }
+    SignalChannel(const SignalChannel &) = delete;
+    SignalChannel &operator=(const SignalChannel &) = delete;
+
+    // Call before starting any thread
+    bool open() {
+        sigemptyset(&mask_);
+        sigaddset(&mask_, SIGINT);
+        sigaddset(&mask_, SIGTERM);
+        sigaddset(&mask_, SIGHUP);
+        if (pthread_sigmask(SIG_BLOCK, &mask_, nullptr) != 0) return false;
+        fd_ = signalfd(-1, &mask_, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (fd_ == -1) {
+            std::cerr << "❌ signalfd failed: " << strerror(errno) << std::endl;
+            pthread_sigmask(SIG_UNBLOCK, &mask_, nullptr);
+            return false;
+        }
+        return true;
+    }
+
+    int fd() const { return fd_; }
+
+    // Next pending signal without waiting; 0 if none
+    int take() {
+        struct signalfd_siginfo info;
+        if (fd_ == -1 || read(fd_, &info, sizeof(info)) != sizeof(info)) return 0;
+        return static_cast<int>(info.ssi_signo);
+    }
+
+    // Sleeps until deadline_ns (CLOCK_MONOTONIC) or a signal arrives;
+    // returns the signal, or 0 at the deadline
+    int wait_until(int64_t deadline_ns) {
+        struct pollfd pfd = {fd_, POLLIN, 0};
+        while (true) {
+            int sig = take();
+            if (sig != 0) return sig;
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            int64_t left = deadline_ns - timespec_to_ns(now);
+            if (left <= 0) return 0;
+            struct timespec timeout = {static_cast<time_t>(left / 1000000000LL),
+                                       static_cast<long>(left % 1000000000LL)};
+            if (ppoll(&pfd, 1, &timeout, nullptr) == -1 && errno != EINTR) return 0;
+        }
+    }
+
+    // Waits until fd is readable (returns 0) or a signal arrives (returns it)
+    int wait_readable(int fd) {
+        struct pollfd pfd[2] = {{fd_, POLLIN, 0}, {fd, POLLIN, 0}};
+        while (true) {
+            int sig = take();
+            if (sig != 0) return sig;
+            if (poll(pfd, 2, -1) == -1 && errno != EINTR) return 0;
+            if (pfd[1].revents) return 0;
+        }
+    }
+
+    void close() {
+        if (fd_ == -1) return;
+        ::close(fd_);
+        fd_ = -1;
+        pthread_sigmask(SIG_UNBLOCK, &mask_, nullptr);
+    }
+
+private:
+    int fd_ = -1;
+    sigset_t mask_;
+};
+
+inline bool is_stop_signal(int sig) { return sig == SIGINT || sig == SIGTERM; }
+
+// ===========================
+// SYSTEMD NOTIFICATION
+// ===========================
+// With Type=notify, systemd passes a datagram socket in $NOTIFY_SOCKET
+// and waits for READY=1 before considering the service started. Without
+// the variable (a terminal, Type=simple) this does nothing.
+inline void sd_notify_status(const char *state) {
+    const char *path = getenv("NOTIFY_SOCKET");
+    if (path == nullptr || (path[0] != '/' && path[0] != '@')) return;
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    size_t len = strlen(path);
+    if (len >= sizeof(addr.sun_path)) return;
+    memcpy(addr.sun_path, path, len);
+    if (addr.sun_path[0] == '@') addr.sun_path[0] = '\0';   // Abstract namespace
+
+    int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) return;
+    sendto(fd, state, strlen(state), MSG_NOSIGNAL, reinterpret_cast<struct sockaddr *>(&addr),
+           static_cast<socklen_t>(offsetof(struct sockaddr_un, sun_path) + len));
+    ::close(fd);
+}
+
+#endif // EC_DAEMON_H
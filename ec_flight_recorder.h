@@ -0,0 +1,343 @@
+#ifndef EC_FLIGHT_RECORDER_H
+#define EC_FLIGHT_RECORDER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "ec_sample.h"
+#include "ec_binlog.h"
+#include "ec_log_segment.h"
+
+// ===========================
+// FLIGHT RECORDER RING FILE (.ring)
+// ===========================
+// A fixed-size, memory-mapped circular file holding the last N minutes of
+// every sample at full rate, independent of the log sink, its ingest
+// compression and its rotation. Disk footprint is constant: the file is
+// allocated once and then only overwritten.
+//
+// Layout (native little-endian):
+//
+//   [Header: 64 bytes][Slot 0][Slot 1] ... [Slot capacity-1]
+//   Slot = [seq: 8 bytes][SampleRecord]
+//
+// Sample number n (from 1) lives in slot (n - 1) % capacity. The header's
+// head is the number of the newest sample. Recording is one memcpy into the
+// mapping plus three stores, no system call and no allocation: the slot's
+// seq is zeroed, the record copied, then seq and head are published
+// (a seqlock, so a concurrent snapshot never takes a half-written slot).
+//
+// The mapping is shared, so everything recorded survives a crash of the
+// process (not of the OS). The header's clean flag is only set by close();
+// a ring found unclean on the next start is saved first.
+//
+// Snapshots (a trigger such as an anomaly, or that crash recovery) copy the
+// requested window out of the ring on a background thread and write it as
+// a permanent binary log, ec_flight.20260114-220501.ecb, which ec_log_tool
+// reads like any other .ecb.
+
+const char FLIGHT_MAGIC[8] = {'E', 'C', 'F', 'L', 'T', '\r', '\n', 0x1a};
+const uint32_t FLIGHT_VERSION = 1;
+
+struct FlightHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t slot_size;          // sizeof(FlightSlot)
+    uint64_t capacity;           // Slots
+    uint64_t head;               // Number of the newest sample (0 = empty)
+    int64_t  created_ns;
+    uint32_t clean;              // 1 = closed normally, 0 = in use or crashed
+    uint8_t  reserved[20];
+};
+
+struct FlightSlot {
+    uint64_t seq;                // Sample number, 0 while being written
+    SampleRecord rec;
+};
+
+static_assert(sizeof(FlightHeader) == 64, "FlightHeader must be 64 bytes");
+
+// Copy the samples newer than from_ns out of a mapped ring, oldest first.
+// Slots overwritten while being copied are left out.
+inline void flight_collect(const FlightHeader *hdr, const FlightSlot *slots, int64_t from_ns,
+                           std::vector<SampleRecord> &out) {
+    uint64_t head = __atomic_load_n(&hdr->head, __ATOMIC_ACQUIRE);
+    uint64_t count = head < hdr->capacity ? head : hdr->capacity;
+    out.clear();
+    out.reserve(count);
+    for (uint64_t n = head - count + 1; n <= head; n++) {
+        const FlightSlot *slot = &slots[(n - 1) % hdr->capacity];
+        uint64_t before = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        SampleRecord rec;
+        memcpy(&rec, &slot->rec, sizeof(rec));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        uint64_t after = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+        if (before != n || after != n) continue;
+        if (rec.timestamp_ns >= from_ns) out.push_back(rec);
+    }
+}
+
+// "dir/ec_flight.ring" -> "dir/ec_flight.ecb" (tagged per snapshot)
+inline std::string flight_snapshot_base(const std::string &ring_path) {
+    size_t slash = ring_path.find_last_of('/');
+    size_t dot = ring_path.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return ring_path + ".ecb";
+    return ring_path.substr(0, dot) + ".ecb";
+}
+
+inline bool flight_write_snapshot(const std::string &path, const std::vector<SampleRecord> &records) {
+    BinaryLogWriter out;
+    if (!out.open(path)) return false;
+    for (const SampleRecord &rec : records) out.append(rec);
+    bool ok = out.flush() && out.sync();
+    out.close();
+    return ok;
+}
+
+// Read-only view of a ring file (ec_log_tool, crash recovery)
+class FlightRingReader {
+public:
+    ~FlightRingReader() { close(); }
+
+    bool open(const std::string &path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd == -1) {
+            std::cerr << "❌ Cannot open flight recorder " << path << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        struct stat st;
+        fstat(fd, &st);
+        size_ = static_cast<size_t>(st.st_size);
+        void *map = size_ >= sizeof(FlightHeader) ? mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0)
+                                                  : MAP_FAILED;
+        ::close(fd);
+        if (map == MAP_FAILED) {
+            std::cerr << "❌ " << path << ": not a flight recorder file" << std::endl;
+            size_ = 0;
+            return false;
+        }
+        data_ = static_cast<const uint8_t *>(map);
+        const FlightHeader *hdr = header();
+        if (memcmp(hdr->magic, FLIGHT_MAGIC, sizeof(hdr->magic)) != 0 ||
+            hdr->version != FLIGHT_VERSION || hdr->slot_size != sizeof(FlightSlot) ||
+            hdr->capacity == 0 || sizeof(FlightHeader) + hdr->capacity * sizeof(FlightSlot) > size_) {
+            std::cerr << "❌ " << path << ": not a flight recorder file of this version" << std::endl;
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (data_) munmap(const_cast<uint8_t *>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    const FlightHeader *header() const { return reinterpret_cast<const FlightHeader *>(data_); }
+
+    void collect(int64_t from_ns, std::vector<SampleRecord> &out) const {
+        flight_collect(header(), reinterpret_cast<const FlightSlot *>(data_ + sizeof(FlightHeader)),
+                       from_ns, out);
+    }
+
+private:
+    const uint8_t *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// ===========================
+// FLIGHT RECORDER
+// ===========================
+class FlightRecorder {
+public:
+    FlightRecorder() {}
+    ~FlightRecorder() { close(); }
+    FlightRecorder(const FlightRecorder &) = delete;
+    FlightRecorder &operator=(const FlightRecorder &) = delete;
+
+    // Map (or create) a ring of `capacity` samples. A ring left unclean by a
+    // crash is saved as a snapshot before it is reused. Snapshots keep the
+    // last snapshot_ns of samples.
+    bool open(const std::string &path, uint64_t capacity, int64_t snapshot_ns) {
+        close();
+        snapshot_ns_ = snapshot_ns;
+        snapshot_base_ = flight_snapshot_base(path);
+        recover(path);
+
+        size_t bytes = sizeof(FlightHeader) + capacity * sizeof(FlightSlot);
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd == -1) {
+            std::cerr << "❌ Cannot open flight recorder " << path << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        struct stat st;
+        fstat(fd, &st);
+        bool fresh = static_cast<size_t>(st.st_size) != bytes;
+        // Reserve the blocks now: a full disk must not SIGBUS a store later
+        int err = fresh ? (ftruncate(fd, 0) == 0 ? posix_fallocate(fd, 0, bytes) : errno) : 0;
+        void *map = err == 0 ? mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                             : MAP_FAILED;
+        ::close(fd);
+        if (map == MAP_FAILED) {
+            std::cerr << "❌ Cannot map flight recorder " << path << ": "
+                      << strerror(err ? err : errno) << std::endl;
+            return false;
+        }
+        size_ = bytes;
+        header_ = static_cast<FlightHeader *>(map);
+        slots_ = reinterpret_cast<FlightSlot *>(static_cast<uint8_t *>(map) + sizeof(FlightHeader));
+
+        if (fresh || memcmp(header_->magic, FLIGHT_MAGIC, sizeof(header_->magic)) != 0 ||
+            header_->version != FLIGHT_VERSION || header_->slot_size != sizeof(FlightSlot) ||
+            header_->capacity != capacity) {
+            memset(map, 0, bytes);
+            memcpy(header_->magic, FLIGHT_MAGIC, sizeof(header_->magic));
+            header_->version = FLIGHT_VERSION;
+            header_->slot_size = sizeof(FlightSlot);
+            header_->capacity = capacity;
+            struct timespec now;
+            clock_gettime(CLOCK_REALTIME, &now);
+            header_->created_ns = static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+        }
+        header_->clean = 0;
+        head_ = header_->head;
+
+        stopping_ = false;
+        pending_ = false;
+        thread_ = std::thread(&FlightRecorder::run, this);
+        return true;
+    }
+
+    bool is_open() const { return header_ != nullptr; }
+
+    // Producer thread only (the pipeline's sink stage). No system call,
+    // no allocation.
+    void record(const SampleRecord &rec) {
+        if (!header_) return;
+        uint64_t n = ++head_;
+        FlightSlot *slot = &slots_[(n - 1) % header_->capacity];
+        __atomic_store_n(&slot->seq, 0, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        memcpy(&slot->rec, &rec, sizeof(rec));
+        __atomic_store_n(&slot->seq, n, __ATOMIC_RELEASE);
+        __atomic_store_n(&header_->head, n, __ATOMIC_RELEASE);
+    }
+
+    // Producer thread only, like record(). Ask for a snapshot of the last
+    // snapshot_ns before now_ns. Ignored while the previous snapshot's
+    // window still overlaps (one anomaly often raises several triggers).
+    // Returns whether it was accepted.
+    bool trigger(int64_t now_ns, const char *reason) {
+        if (!header_) return false;
+        if (last_trigger_ns_ && now_ns - last_trigger_ns_ < snapshot_ns_) return false;
+        last_trigger_ns_ = now_ns;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (pending_) return false;
+            pending_ = true;
+            pending_reason_ = reason;
+            pending_from_ns_ = now_ns - snapshot_ns_;
+        }
+        wake_.notify_one();
+        return true;
+    }
+
+    // Waits for a running snapshot, then marks the ring clean
+    void close() {
+        if (thread_.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stopping_ = true;
+            }
+            wake_.notify_one();
+            thread_.join();
+        }
+        if (!header_) return;
+        header_->clean = 1;
+        msync(header_, size_, MS_ASYNC);
+        munmap(header_, size_);
+        header_ = nullptr;
+        slots_ = nullptr;
+    }
+
+    uint64_t snapshots() const { return snapshots_.load(std::memory_order_relaxed); }
+
+private:
+    FlightHeader *header_ = nullptr;
+    FlightSlot *slots_ = nullptr;
+    size_t size_ = 0;
+    uint64_t head_ = 0;                  // Producer thread's copy of header_->head
+    int64_t snapshot_ns_ = 0;
+    std::string snapshot_base_;
+    int64_t last_trigger_ns_ = 0;        // Producer thread only
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    bool pending_ = false;
+    const char *pending_reason_ = "";
+    int64_t pending_from_ns_ = 0;
+    std::atomic<uint64_t> snapshots_{0};
+
+    // Save what an unclean ring still holds
+    void recover(const std::string &path) {
+        if (access(path.c_str(), F_OK) != 0) return;
+        FlightRingReader ring;
+        if (!ring.open(path) || ring.header()->clean || ring.header()->head == 0) return;
+        std::vector<SampleRecord> records;
+        ring.collect(INT64_MIN, records);
+        if (records.empty()) return;
+        int64_t from_ns = records.back().timestamp_ns - snapshot_ns_;
+        records.erase(records.begin(), std::lower_bound(records.begin(), records.end(), from_ns,
+            [](const SampleRecord &r, int64_t t) { return r.timestamp_ns < t; }));
+        save(records, "previous run did not exit cleanly");
+    }
+
+    void run() {
+        std::vector<SampleRecord> records;
+        while (true) {
+            const char *reason;
+            int64_t from_ns;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [this] { return stopping_ || pending_; });
+                if (!pending_) return;
+                reason = pending_reason_;
+                from_ns = pending_from_ns_;
+            }
+            flight_collect(header_, slots_, from_ns, records);
+            save(records, reason);
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_ = false;
+        }
+    }
+
+    void save(const std::vector<SampleRecord> &records, const char *reason) {
+        if (records.empty()) return;
+        std::string path = log_free_segment_path(snapshot_base_,
+            static_cast<time_t>(records.back().timestamp_ns / 1000000000LL));
+        if (!flight_write_snapshot(path, records)) return;
+        snapshots_.fetch_add(1, std::memory_order_relaxed);
+        std::cerr << "📼 Flight recorder: " << reason << "; saved " << records.size()
+                  << " samples to " << path << std::endl;
+    }
+};
+
+#endif // EC_FLIGHT_RECORDER_H
@@ -0,0 +1,644 @@
+#ifndef EC_GORILLA_H
+#define EC_GORILLA_H
+
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "ec_sample.h"
+#include "ec_crc32.h"
+#include "ec_log_segment.h"
+
+// ===========================
+// GORILLA COMPRESSED LOG FORMAT (.ecg)
+// ===========================
+// Time-series compression in the style of Facebook's Gorilla TSDB:
+//   - timestamps: delta-of-delta with variable-length buckets
+//   - floats:     XOR against the previous value of the same channel,
+//                 storing only the meaningful bits
+// Identical consecutive samples cost 1 bit per channel, and small
+// temperature drifts only a dozen or so bits.
+//
+// Layout:
+//   [File header: 32 bytes]
+//   [Block header: 40 bytes][bitstream] [Block header][bitstream] ...
+//
+// Each block holds up to GORILLA_BLOCK_RECORDS records and starts from
+// uncompressed values, so blocks decode independently (and in parallel).
+// The bitstream of a block only ever grows at the end, so the writer can
+// flush the open block in place: new payload bytes first, then the block
+// header with the new count / length / CRC. The payload write starts at
+// the last, partial byte, which the previous header already covers; new
+// bits only fill its unused low end, so the CRC covers just the bits in
+// use there (tail_bits) and the previous header stays valid. A crash
+// therefore leaves either the old or the new committed prefix, never a
+// half-updated one.
+//
+// Timestamps are stored in units of ts_unit_ns (default 1 ms), which keeps
+// the per-sample jitter of the acquisition loop in the 9-bit bucket.
+
+const char GORILLA_MAGIC[8] = {'E', 'C', 'G', 'O', 'R', 'L', '\r', '\n'};
+const uint32_t GORILLA_VERSION = 1;
+const uint32_t GORILLA_BLOCK_RECORDS = 4096;
+const uint32_t GORILLA_BLOCK_MAGIC = 0x4B4C4247;   // "GBLK"
+const uint32_t GORILLA_TS_UNIT_NS = 1000000;      // 1 ms
+
+struct GorillaFileHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t block_records;    // Max records per block
+    uint32_t ts_unit_ns;       // Timestamp resolution
+    uint32_t reserved0;
+    int64_t  created_ns;
+};
+static_assert(sizeof(GorillaFileHeader) == 32, "GorillaFileHeader must be 32 bytes");
+
+struct GorillaBlockHeader {
+    uint32_t magic;
+    uint32_t count;            // Records in this block
+    uint32_t payload_bytes;    // Bitstream length
+    uint32_t crc32;            // CRC-32 of the bitstream
+    int64_t  first_timestamp_ns;
+    int64_t  last_timestamp_ns;
+    uint32_t tail_bits;        // Bits in use in the last payload byte (0 = all 8)
+    uint32_t reserved;
+};
+static_assert(sizeof(GorillaBlockHeader) == 40, "GorillaBlockHeader must be 40 bytes");
+
+// ===========================
+// BIT STREAM WRITER / READER (MSB first)
+// ===========================
+class BitWriter {
+public:
+    void clear() {
+        bytes_.clear();
+        bit_pos_ = 0;
+    }
+
+    void write(uint64_t value, int nbits) {
+        while (nbits > 0) {
+            if (bit_pos_ == 0) bytes_.push_back(0);
+            int room = 8 - bit_pos_;
+            int take = nbits < room ? nbits : room;
+            uint8_t chunk = static_cast<uint8_t>((value >> (nbits - take)) & ((1u << take) - 1));
+            bytes_.back() |= static_cast<uint8_t>(chunk << (room - take));
+            bit_pos_ = (bit_pos_ + take) & 7;
+            nbits -= take;
+        }
+    }
+
+    const std::vector<uint8_t> &bytes() const { return bytes_; }
+
+    // Bytes that can no longer change (the last one may still be partial)
+    size_t complete_bytes() const { return bit_pos_ == 0 ? bytes_.size() : bytes_.size() - 1; }
+
+    // Bits used in the last byte (0 = byte full)
+    uint32_t tail_bits() const { return static_cast<uint32_t>(bit_pos_); }
+
+private:
+    std::vector<uint8_t> bytes_;
+    int bit_pos_ = 0;          // Bits used in the last byte (0 = byte full)
+};
+
+class BitReader {
+public:
+    BitReader(const uint8_t *data, size_t len) : data_(data), len_(len) {}
+
+    uint64_t read(int nbits) {
+        uint64_t value = 0;
+        while (nbits > 0) {
+            if (pos_ >= len_ * 8) {
+                overrun_ = true;
+                return value << nbits;
+            }
+            size_t byte = pos_ >> 3;
+            int bit = pos_ & 7;
+            int room = 8 - bit;
+            int take = nbits < room ? nbits : room;
+            uint8_t chunk = (data_[byte] >> (room - take)) & ((1u << take) - 1);
+            value = (value << take) | chunk;
+            pos_ += take;
+            nbits -= take;
+        }
+        return value;
+    }
+
+    bool bit() { return read(1) != 0; }
+    bool overrun() const { return overrun_; }
+
+private:
+    const uint8_t *data_;
+    size_t len_;
+    size_t pos_ = 0;
+    bool overrun_ = false;
+};
+
+// ===========================
+// CHANNEL CODECS
+// ===========================
+// Delta-of-delta timestamp buckets:
+//   0                      dod == 0
+//   10    + 7 bits         [-64, 63]
+//   110   + 9 bits         [-256, 255]
+//   1110  + 12 bits        [-2048, 2047]
+//   11110 + 32 bits        int32 range
+//   11111 + 64 bits        anything else
+struct GorillaTimestampState {
+    int64_t prev = 0;
+    int64_t prev_delta = 0;
+};
+
+inline void gorilla_put_signed(BitWriter &out, int64_t value, int nbits) {
+    out.write(static_cast<uint64_t>(value) & ((nbits == 64) ? ~0ull : ((1ull << nbits) - 1)), nbits);
+}
+
+inline int64_t gorilla_get_signed(BitReader &in, int nbits) {
+    uint64_t raw = in.read(nbits);
+    if (nbits < 64 && (raw >> (nbits - 1)) & 1) raw |= ~0ull << nbits;
+    return static_cast<int64_t>(raw);
+}
+
+inline void gorilla_encode_timestamp(BitWriter &out, GorillaTimestampState &st, int64_t ts) {
+    int64_t delta = ts - st.prev;
+    int64_t dod = delta - st.prev_delta;
+    if (dod == 0) {
+        out.write(0, 1);
+    } else if (dod >= -64 && dod <= 63) {
+        out.write(0x2, 2);
+        gorilla_put_signed(out, dod, 7);
+    } else if (dod >= -256 && dod <= 255) {
+        out.write(0x6, 3);
+        gorilla_put_signed(out, dod, 9);
+    } else if (dod >= -2048 && dod <= 2047) {
+        out.write(0xE, 4);
+        gorilla_put_signed(out, dod, 12);
+    } else if (dod >= INT32_MIN && dod <= INT32_MAX) {
+        out.write(0x1E, 5);
+        gorilla_put_signed(out, dod, 32);
+    } else {
+        out.write(0x1F, 5);
+        gorilla_put_signed(out, dod, 64);
+    }
+    st.prev_delta = delta;
+    st.prev = ts;
+}
+
+inline int64_t gorilla_decode_timestamp(BitReader &in, GorillaTimestampState &st) {
+    int64_t dod;
+    if (!in.bit()) {
+        dod = 0;
+    } else if (!in.bit()) {
+        dod = gorilla_get_signed(in, 7);
+    } else if (!in.bit()) {
+        dod = gorilla_get_signed(in, 9);
+    } else if (!in.bit()) {
+        dod = gorilla_get_signed(in, 12);
+    } else if (!in.bit()) {
+        dod = gorilla_get_signed(in, 32);
+    } else {
+        dod = gorilla_get_signed(in, 64);
+    }
+    st.prev_delta += dod;
+    st.prev += st.prev_delta;
+    return st.prev;
+}
+
+// XOR float codec (32-bit variant of Gorilla's double encoding):
+//   0                                   same as previous value
+//   10 + meaningful bits                fits the previous leading/trailing window
+//   11 + 5 bits leading + 5 bits (len-1) + len bits
+struct GorillaFloatState {
+    uint32_t prev = 0;
+    int leading = -1;          // -1 = no window yet
+    int trailing = 0;
+};
+
+inline void gorilla_encode_bits32(BitWriter &out, GorillaFloatState &st, uint32_t bits) {
+    uint32_t x = bits ^ st.prev;
+    st.prev = bits;
+    if (x == 0) {
+        out.write(0, 1);
+        return;
+    }
+    int lz = __builtin_clz(x);
+    int tz = __builtin_ctz(x);
+    if (st.leading >= 0 && lz >= st.leading && tz >= st.trailing) {
+        out.write(0x2, 2);
+        out.write(x >> st.trailing, 32 - st.leading - st.trailing);
+    } else {
+        int len = 32 - lz - tz;
+        out.write(0x3, 2);
+        out.write(lz, 5);
+        out.write(len - 1, 5);
+        out.write(x >> tz, len);
+        st.leading = lz;
+        st.trailing = tz;
+    }
+}
+
+inline uint32_t gorilla_decode_bits32(BitReader &in, GorillaFloatState &st) {
+    if (!in.bit()) return st.prev;
+    if (!in.bit()) {
+        int len = 32 - st.leading - st.trailing;
+        uint32_t x = static_cast<uint32_t>(in.read(len)) << st.trailing;
+        st.prev ^= x;
+        return st.prev;
+    }
+    int lz = static_cast<int>(in.read(5));
+    int len = static_cast<int>(in.read(5)) + 1;
+    int tz = 32 - lz - len;
+    if (tz < 0) tz = 0;
+    uint32_t x = static_cast<uint32_t>(in.read(len)) << tz;
+    st.leading = lz;
+    st.trailing = tz;
+    st.prev ^= x;
+    return st.prev;
+}
+
+// CRC-32 of a block's bitstream, counting only the used high bits of a
+// partial last byte (the writer fills the rest in place later)
+inline uint32_t gorilla_payload_crc(const uint8_t *payload, size_t len, uint32_t tail_bits) {
+    if (len == 0 || tail_bits == 0 || tail_bits >= 8) return crc32_compute(payload, len);
+    uint32_t crc = crc32_update(0, payload, len - 1);
+    uint8_t last = payload[len - 1] & static_cast<uint8_t>(0xFF << (8 - tail_bits));
+    return crc32_update(crc, &last, 1);
+}
+
+// ===========================
+// BLOCK ENCODER / DECODER
+// ===========================
+// Per-record channel order: timestamp, temp, raw_ec, sensor_ec, smart_ec, k, flags
+const int GORILLA_FLOAT_CHANNELS = 6;    // 5 floats + flags (as raw bits)
+
+class GorillaBlockEncoder {
+public:
+    void reset() {
+        out_.clear();
+        ts_ = GorillaTimestampState();
+        for (int c = 0; c < GORILLA_FLOAT_CHANNELS; c++) ch_[c] = GorillaFloatState();
+        count_ = 0;
+    }
+
+    void append(const SampleRecord &rec, uint32_t ts_unit_ns) {
+        int64_t ts = rec.timestamp_ns / ts_unit_ns;
+        if (count_ == 0) {
+            gorilla_put_signed(out_, ts, 64);
+            ts_.prev = ts;
+        } else {
+            gorilla_encode_timestamp(out_, ts_, ts);
+        }
+        uint32_t vals[GORILLA_FLOAT_CHANNELS] = {
+            sample_float_bits(rec.temp), sample_float_bits(rec.raw_ec),
+            sample_float_bits(rec.sensor_ec), sample_float_bits(rec.smart_ec),
+            sample_float_bits(rec.k), rec.flags
+        };
+        for (int c = 0; c < GORILLA_FLOAT_CHANNELS; c++) gorilla_encode_bits32(out_, ch_[c], vals[c]);
+        count_++;
+    }
+
+    uint32_t count() const { return count_; }
+    const BitWriter &stream() const { return out_; }
+
+private:
+    BitWriter out_;
+    GorillaTimestampState ts_;
+    GorillaFloatState ch_[GORILLA_FLOAT_CHANNELS];
+    uint32_t count_ = 0;
+};
+
+// Decode one block's bitstream, appending records to out.
+// Returns false if the stream ends early (corrupt block).
+inline bool gorilla_decode_block(const uint8_t *payload, size_t len, uint32_t count,
+                                 uint32_t ts_unit_ns, std::vector<SampleRecord> &out) {
+    BitReader in(payload, len);
+    GorillaTimestampState ts;
+    GorillaFloatState ch[GORILLA_FLOAT_CHANNELS];
+
+    for (uint32_t i = 0; i < count; i++) {
+        int64_t t;
+        if (i == 0) {
+            t = gorilla_get_signed(in, 64);
+            ts.prev = t;
+        } else {
+            t = gorilla_decode_timestamp(in, ts);
+        }
+        uint32_t vals[GORILLA_FLOAT_CHANNELS];
+        for (int c = 0; c < GORILLA_FLOAT_CHANNELS; c++) vals[c] = gorilla_decode_bits32(in, ch[c]);
+        if (in.overrun()) return false;
+
+        SampleRecord rec;
+        memset(&rec, 0, sizeof(rec));
+        rec.timestamp_ns = t * static_cast<int64_t>(ts_unit_ns);
+        rec.temp = sample_bits_float(vals[0]);
+        rec.raw_ec = sample_bits_float(vals[1]);
+        rec.sensor_ec = sample_bits_float(vals[2]);
+        rec.smart_ec = sample_bits_float(vals[3]);
+        rec.k = sample_bits_float(vals[4]);
+        rec.flags = vals[5];
+        sample_float_to_regs(rec.temp, rec.reg_temp);
+        sample_float_to_regs(rec.raw_ec, rec.reg_raw_ec);
+        sample_float_to_regs(rec.sensor_ec, rec.reg_sensor_ec);
+        out.push_back(rec);
+    }
+    return true;
+}
+
+// ===========================
+// GORILLA LOG WRITER
+// ===========================
+class GorillaLogWriter {
+public:
+    GorillaLogWriter() {}
+    ~GorillaLogWriter() { close(); }
+    GorillaLogWriter(const GorillaLogWriter &) = delete;
+    GorillaLogWriter &operator=(const GorillaLogWriter &) = delete;
+
+    // Open for append. Existing blocks are kept; a block whose CRC fails
+    // (torn by a crash) is cut off. New records always start a new block.
+    // A file of another version (or no gorilla log at all) is kept aside
+    // and a new one started.
+    bool open(const std::string &path) {
+        close();
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd_ == -1) {
+            std::cerr << "❌ Cannot open gorilla log " << path << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+
+        struct stat st;
+        fstat(fd_, &st);
+        if (st.st_size == 0) {
+            GorillaFileHeader fh;
+            memset(&fh, 0, sizeof(fh));
+            memcpy(fh.magic, GORILLA_MAGIC, sizeof(fh.magic));
+            fh.version = GORILLA_VERSION;
+            fh.block_records = GORILLA_BLOCK_RECORDS;
+            fh.ts_unit_ns = GORILLA_TS_UNIT_NS;
+            struct timespec now;
+            clock_gettime(CLOCK_REALTIME, &now);
+            fh.created_ns = static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+            if (!write_all(reinterpret_cast<const uint8_t *>(&fh), sizeof(fh), 0)) return fail();
+            ts_unit_ns_ = fh.ts_unit_ns;
+            start_block(sizeof(fh));
+            return true;
+        }
+
+        GorillaFileHeader fh;
+        if (pread(fd_, &fh, sizeof(fh), 0) != static_cast<ssize_t>(sizeof(fh)) ||
+            memcmp(fh.magic, GORILLA_MAGIC, sizeof(fh.magic)) != 0 ||
+            fh.version != GORILLA_VERSION || fh.ts_unit_ns == 0) {
+            ::close(fd_);
+            fd_ = -1;
+            if (log_archive_segment(path, "not a gorilla log of this version").empty()) return false;
+            return open(path);
+        }
+        ts_unit_ns_ = fh.ts_unit_ns;
+
+        // Walk block headers to the end (one small pread per block)
+        off_t offset = sizeof(fh);
+        GorillaBlockHeader bh;
+        while (offset + static_cast<off_t>(sizeof(bh)) <= st.st_size &&
+               pread(fd_, &bh, sizeof(bh), offset) == static_cast<ssize_t>(sizeof(bh)) &&
+               bh.magic == GORILLA_BLOCK_MAGIC &&
+               offset + static_cast<off_t>(sizeof(bh) + bh.payload_bytes) <= st.st_size) {
+            off_t next = offset + sizeof(bh) + bh.payload_bytes;
+            if (next + static_cast<off_t>(sizeof(bh)) > st.st_size && !tail_intact(bh, offset)) {
+                torn_records_ = bh.count;
+                break;   // Last block failed its CRC: drop it
+            }
+            offset = next;
+        }
+        if (offset < st.st_size) {
+            std::cerr << "⚠️  " << path << ": cut " << (st.st_size - offset)
+                      << " byte(s) of torn data at the tail" << std::endl;
+            if (ftruncate(fd_, offset) == -1) return fail();
+        }
+        start_block(offset);
+        return true;
+    }
+
+    bool append(const SampleRecord &rec) {
+        if (fd_ == -1) return false;
+        if (encoder_.count() == GORILLA_BLOCK_RECORDS) {
+            if (!flush()) return false;
+            start_block(block_offset_ + sizeof(GorillaBlockHeader) + encoder_.stream().bytes().size());
+        }
+        if (encoder_.count() == 0) first_ts_ = rec.timestamp_ns;
+        last_ts_ = rec.timestamp_ns;
+        encoder_.append(rec, ts_unit_ns_);
+        records_written_++;
+        return true;
+    }
+
+    // Write the grown part of the open block, then commit its header
+    bool flush() {
+        if (fd_ == -1) return false;
+        if (encoder_.count() == flushed_count_) return true;
+
+        const std::vector<uint8_t> &bytes = encoder_.stream().bytes();
+        off_t payload = block_offset_ + sizeof(GorillaBlockHeader);
+        if (!write_all(bytes.data() + flushed_bytes_, bytes.size() - flushed_bytes_,
+                       payload + flushed_bytes_)) return false;
+
+        GorillaBlockHeader bh;
+        memset(&bh, 0, sizeof(bh));
+        bh.magic = GORILLA_BLOCK_MAGIC;
+        bh.count = encoder_.count();
+        bh.payload_bytes = static_cast<uint32_t>(bytes.size());
+        bh.tail_bits = encoder_.stream().tail_bits();
+        bh.crc32 = gorilla_payload_crc(bytes.data(), bytes.size(), bh.tail_bits);
+        bh.first_timestamp_ns = first_ts_;
+        bh.last_timestamp_ns = last_ts_;
+        if (!write_all(reinterpret_cast<const uint8_t *>(&bh), sizeof(bh), block_offset_)) return false;
+
+        flushed_bytes_ = encoder_.stream().complete_bytes();
+        flushed_count_ = encoder_.count();
+        return true;
+    }
+
+    bool sync() {
+        if (fd_ == -1) return false;
+        if (fdatasync(fd_) == -1) {
+            std::cerr << "❌ Gorilla log fdatasync failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (fd_ == -1) return;
+        flush();
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+    bool is_open() const { return fd_ != -1; }
+    uint64_t records_written() const { return records_written_; }
+    uint32_t torn_records() const { return torn_records_; }
+
+    bool has_records() const {
+        return block_offset_ > static_cast<off_t>(sizeof(GorillaFileHeader)) || encoder_.count() > 0;
+    }
+
+    // Where the next append() lands: block header offset + index in the block
+    void next_position(uint64_t *offset, uint32_t *skip) const {
+        if (encoder_.count() == GORILLA_BLOCK_RECORDS) {
+            *offset = block_offset_ + sizeof(GorillaBlockHeader) + encoder_.stream().bytes().size();
+            *skip = 0;
+        } else {
+            *offset = block_offset_;
+            *skip = encoder_.count();
+        }
+    }
+
+private:
+    int fd_ = -1;
+    uint32_t ts_unit_ns_ = GORILLA_TS_UNIT_NS;
+    off_t block_offset_ = 0;       // File offset of the open block's header
+    size_t flushed_bytes_ = 0;     // Stable payload bytes already on disk
+    uint32_t flushed_count_ = 0;
+    int64_t first_ts_ = 0;
+    int64_t last_ts_ = 0;
+    uint64_t records_written_ = 0;
+    uint32_t torn_records_ = 0;
+    GorillaBlockEncoder encoder_;
+
+    void start_block(off_t offset) {
+        block_offset_ = offset;
+        flushed_bytes_ = 0;
+        flushed_count_ = 0;
+        encoder_.reset();
+    }
+
+    bool tail_intact(const GorillaBlockHeader &bh, off_t offset) {
+        std::vector<uint8_t> payload(bh.payload_bytes);
+        if (pread(fd_, payload.data(), payload.size(), offset + sizeof(bh)) !=
+            static_cast<ssize_t>(payload.size())) return false;
+        return gorilla_payload_crc(payload.data(), payload.size(), bh.tail_bits) == bh.crc32;
+    }
+
+    bool write_all(const uint8_t *data, size_t len, off_t offset) {
+        while (len > 0) {
+            ssize_t n = pwrite(fd_, data, len, offset);
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                std::cerr << "❌ Gorilla log write failed: " << strerror(errno) << std::endl;
+                return false;
+            }
+            data += n;
+            len -= n;
+            offset += n;
+        }
+        return true;
+    }
+
+    bool fail() {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+};
+
+// ===========================
+// GORILLA LOG READER (mmap)
+// ===========================
+struct GorillaBlockRef {
+    GorillaBlockHeader header;
+    const uint8_t *payload;
+};
+
+class GorillaLogReader {
+public:
+    GorillaLogReader() {}
+    ~GorillaLogReader() { close(); }
+    GorillaLogReader(const GorillaLogReader &) = delete;
+    GorillaLogReader &operator=(const GorillaLogReader &) = delete;
+
+    bool open(const std::string &path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd == -1) {
+            std::cerr << "❌ Cannot open " << path << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        struct stat st;
+        fstat(fd, &st);
+        size_ = st.st_size;
+        if (size_ < sizeof(GorillaFileHeader)) {
+            std::cerr << "❌ " << path << ": too small to be a gorilla log" << std::endl;
+            ::close(fd);
+            return false;
+        }
+        void *map = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (map == MAP_FAILED) {
+            std::cerr << "❌ mmap failed for " << path << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        data_ = static_cast<const uint8_t *>(map);
+
+        memcpy(&header_, data_, sizeof(header_));
+        if (memcmp(header_.magic, GORILLA_MAGIC, sizeof(header_.magic)) != 0 ||
+            header_.version != GORILLA_VERSION || header_.ts_unit_ns == 0) {
+            std::cerr << "❌ " << path << ": not a supported gorilla log" << std::endl;
+            close();
+            return false;
+        }
+
+        // Index blocks by hopping over payloads; no decoding needed
+        size_t offset = sizeof(GorillaFileHeader);
+        while (offset + sizeof(GorillaBlockHeader) <= size_) {
+            GorillaBlockRef ref;
+            memcpy(&ref.header, data_ + offset, sizeof(ref.header));
+            if (ref.header.magic != GORILLA_BLOCK_MAGIC ||
+                offset + sizeof(GorillaBlockHeader) + ref.header.payload_bytes > size_) break;
+            ref.payload = data_ + offset + sizeof(GorillaBlockHeader);
+            blocks_.push_back(ref);
+            offset += sizeof(GorillaBlockHeader) + ref.header.payload_bytes;
+        }
+        return true;
+    }
+
+    void close() {
+        if (data_) munmap(const_cast<uint8_t *>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+        blocks_.clear();
+    }
+
+    const GorillaFileHeader &header() const { return header_; }
+    const std::vector<GorillaBlockRef> &blocks() const { return blocks_; }
+    size_t file_size() const { return size_; }
+
+    // File offset of a block's header
+    uint64_t block_offset(size_t index) const {
+        return blocks_[index].payload - data_ - sizeof(GorillaBlockHeader);
+    }
+
+    bool block_intact(size_t index) const {
+        const GorillaBlockRef &ref = blocks_[index];
+        return gorilla_payload_crc(ref.payload, ref.header.payload_bytes, ref.header.tail_bits) == ref.header.crc32;
+    }
+
+    // Thread-safe: blocks share nothing but the read-only mapping
+    bool decode(size_t index, std::vector<SampleRecord> &out) const {
+        const GorillaBlockRef &ref = blocks_[index];
+        return gorilla_decode_block(ref.payload, ref.header.payload_bytes, ref.header.count,
+                                    header_.ts_unit_ns, out);
+    }
+
+private:
+    const uint8_t *data_ = nullptr;
+    size_t size_ = 0;
+    GorillaFileHeader header_;
+    std::vector<GorillaBlockRef> blocks_;
+};
+
+#endif // EC_GORILLA_H
@@ -0,0 +1,532 @@
+#ifndef EC_HTTP_LIVE_H
+#define EC_HTTP_LIVE_H
+
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+
+#include "ec_sample.h"
+#include "ec_seqlock.h"
+#include "ec_csv.h"
+#include "ec_timestamp.h"
+
+// ===========================
+// LIVE HTTP / SERVER-SENT EVENTS ENDPOINT
+// ===========================
+// A small embedded HTTP/1.1 server so a run can be watched from a browser
+// instead of the terminal running the dashboard:
+//
+//   GET /          Minimal live page (EventSource on /events)
+//   GET /current   Newest sample as one JSON object
+//   GET /events    text/event-stream, one "data: {json}" event per sample
+//
+// Further GET paths (e.g. /metrics, ec_metrics.h) are added with
+// add_route(); their handler runs on the server thread.
+//
+// It reads the same seqlock snapshot as the dashboard thread, so it never
+// touches the serial bus and the acquisition loop never waits for it. One
+// thread runs an epoll loop over the listening socket and every client;
+// it looks at the snapshot every HTTP_POLL_MS and, when a new sample is
+// there, formats its JSON once and appends the same event to every
+// subscriber.
+//
+// Each client has a bounded output buffer (HTTP_CLIENT_MAX_PENDING). A
+// subscriber too slow to drain it misses events (counted) instead of
+// buffering without limit; after HTTP_CLIENT_MAX_MISSED missed events in a
+// row it is disconnected, and EventSource reconnects by itself. Plain
+// requests are answered with Connection: close. Binds to 127.0.0.1 unless
+// told otherwise.
+
+const int HTTP_POLL_MS = 50;                        // Snapshot check period
+const int HTTP_KEEPALIVE_MS = 15000;                // SSE comment when idle
+const size_t HTTP_MAX_CLIENTS = 1024;
+const size_t HTTP_REQUEST_MAX_BYTES = 8192;
+const size_t HTTP_CLIENT_MAX_PENDING = 64 * 1024;   // Unsent bytes per client
+const uint32_t HTTP_CLIENT_MAX_MISSED = 30;         // Then the subscriber is dropped
+const size_t HTTP_JSON_MAX_CHARS = 512;
+
+// Newest sample as handed from the acquisition loop to the dashboard and
+// the HTTP endpoint
+struct LiveSample {
+    SampleRecord rec;
+    int sample_count;
+};
+
+struct HttpServerStats {
+    uint64_t requests = 0;       // Requests answered
+    uint64_t events = 0;         // Samples published as events
+    uint64_t missed = 0;         // Events not queued to a slow subscriber
+    uint64_t dropped = 0;        // Subscribers disconnected for being too slow
+    size_t clients = 0;          // Open connections
+    size_t subscribers = 0;      // ...of which on /events
+};
+
+// JSON number (csv_put_float's "%g" digits); NaN/inf have no JSON form
+inline char *json_put_float(char *p, char *end, double value) {
+    if (!std::isfinite(value)) {
+        memcpy(p, "null", 4);
+        return p + 4;
+    }
+    return csv_put_float(p, end, value);
+}
+
+inline char *json_put_text(char *p, const char *text) {
+    size_t len = strlen(text);
+    memcpy(p, text, len);
+    return p + len;
+}
+
+// {"seq":..,"time":"..","timestamp_ns":..,"temp":..,...} without '\n';
+// writes into buf (HTTP_JSON_MAX_CHARS bytes) and returns the length
+inline size_t format_live_sample_json(char *buf, const LiveSample &s, TimestampFormatter &ts_format) {
+    char *end = buf + HTTP_JSON_MAX_CHARS;
+    const SampleRecord &r = s.rec;
+    char *p = json_put_text(buf, "{\"seq\":");
+    p = std::to_chars(p, end, s.sample_count).ptr;
+    p = json_put_text(p, ",\"time\":\"");
+    p += ts_format.format(r.timestamp_ns, p);
+    p = json_put_text(p, "\",\"timestamp_ns\":");
+    p = std::to_chars(p, end, r.timestamp_ns).ptr;
+    p = json_put_text(p, ",\"temp\":");
+    p = json_put_float(p, end, r.temp);
+    p = json_put_text(p, ",\"raw_ec\":");
+    p = json_put_float(p, end, r.raw_ec);
+    p = json_put_text(p, ",\"sensor_ec\":");
+    p = json_put_float(p, end, r.sensor_ec);
+    p = json_put_text(p, ",\"smart_ec\":");
+    p = json_put_float(p, end, r.smart_ec);
+    p = json_put_text(p, ",\"k\":");
+    p = json_put_float(p, end, r.k);
+    p = json_put_text(p, ",\"deviation\":");
+    p = json_put_float(p, end, static_cast<double>(r.sensor_ec) - r.smart_ec);
+    p = json_put_text(p, (r.flags & SAMPLE_FLAG_SENSOR_PASS) ? ",\"sensor_pass\":true"
+                                                              : ",\"sensor_pass\":false");
+    p = json_put_text(p, (r.flags & SAMPLE_FLAG_SMART_PASS) ? ",\"smart_pass\":true"
+                                                             : ",\"smart_pass\":false");
+    p = json_put_text(p, ",\"hex_temp\":\"");
+    p = csv_put_hex_regs(p, r.reg_temp);
+    p = json_put_text(p, "\",\"hex_raw_ec\":\"");
+    p = csv_put_hex_regs(p, r.reg_raw_ec);
+    p = json_put_text(p, "\",\"hex_sensor_ec\":\"");
+    p = csv_put_hex_regs(p, r.reg_sensor_ec);
+    p = json_put_text(p, "\"}");
+    return p - buf;
+}
+
+const char HTTP_LIVE_PAGE[] =
+    "<!DOCTYPE html>\n<html><head><meta charset=\"utf-8\"><title>EC Smart Logger</title>\n"
+    "<style>body{font-family:monospace;margin:2em}td{padding:2px 12px}"
+    ".pass{color:green}.fail{color:#c00}</style></head><body>\n"
+    "<h2>EC Smart Logger - live</h2><table id=\"t\"></table><p id=\"s\">connecting...</p>\n"
+    "<script>\n"
+    "const rows=[['time','Time',''],['temp','Temperature','&deg;C'],['raw_ec','Raw EC','mS/cm'],"
+    "['sensor_ec','Sensor EC (k=0.02)','mS/cm'],['smart_ec','Smart EC','mS/cm'],['k','k',''],"
+    "['deviation','Deviation','mS/cm']];\n"
+    "const es=new EventSource('events');\n"
+    "es.onmessage=e=>{const d=JSON.parse(e.data);"
+    "document.getElementById('t').innerHTML=rows.map(r=>'<tr><td>'+r[1]+'</td><td>'+d[r[0]]+"
+    "'</td><td>'+r[2]+'</td></tr>').join('')+'<tr><td>Smart vs standard</td><td class=\"'+"
+    "(d.smart_pass?'pass\">PASS':'fail\">FAIL')+'</td></tr>';"
+    "document.getElementById('s').textContent='sample '+d.seq;};\n"
+    "es.onerror=()=>{document.getElementById('s').textContent='reconnecting...';};\n"
+    "</script></body></html>\n";
+
+class LiveHttpServer {
+public:
+    LiveHttpServer() {}
+    ~LiveHttpServer() { stop(); }
+    LiveHttpServer(const LiveHttpServer &) = delete;
+    LiveHttpServer &operator=(const LiveHttpServer &) = delete;
+
+    // Listens on bind_addr:port and serves from live. Returns false (with a
+    // message) if the socket cannot be set up; the logger runs on without.
+    bool start(const std::string &bind_addr, int port, const Seqlock<LiveSample> *live,
+               TimestampPrecision ts_precision) {
+        stop();
+        live_ = live;
+        ts_format_.set_precision(ts_precision);
+
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        if (inet_pton(AF_INET, bind_addr.c_str(), &addr.sin_addr) != 1) {
+            std::cerr << "❌ HTTP: invalid bind address '" << bind_addr << "'" << std::endl;
+            return false;
+        }
+
+        listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        int one = 1;
+        if (listen_fd_ == -1 ||
+            setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) == -1 ||
+            bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == -1 ||
+            listen(listen_fd_, 512) == -1) {
+            std::cerr << "❌ HTTP: cannot listen on " << bind_addr << ":" << port
+                      << ": " << strerror(errno) << std::endl;
+            close_fds();
+            return false;
+        }
+
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epoll_fd_ == -1 || wake_fd_ == -1 || !watch(listen_fd_, EPOLLIN) || !watch(wake_fd_, EPOLLIN)) {
+            std::cerr << "❌ HTTP: epoll setup failed: " << strerror(errno) << std::endl;
+            close_fds();
+            return false;
+        }
+
+        running_ = true;
+        thread_ = std::thread(&LiveHttpServer::run, this);
+        return true;
+    }
+
+    void stop() {
+        if (thread_.joinable()) {
+            running_ = false;
+            uint64_t one = 1;
+            if (write(wake_fd_, &one, sizeof(one)) == -1) {
+                // The loop also checks running_ every HTTP_POLL_MS
+            }
+            thread_.join();
+        }
+        for (auto &c : clients_) ::close(c.first);
+        clients_.clear();
+        close_fds();
+    }
+
+    bool running() const { return thread_.joinable(); }
+
+    // Extra GET path answered with body()'s text. Call before start().
+    void add_route(const std::string &path, const std::string &content_type,
+                   std::function<std::string()> body) {
+        routes_[path] = Route{content_type, body};
+    }
+
+    // Safe to call from any thread
+    HttpServerStats stats() const {
+        HttpServerStats s;
+        s.requests = requests_.load(std::memory_order_relaxed);
+        s.events = events_.load(std::memory_order_relaxed);
+        s.missed = missed_.load(std::memory_order_relaxed);
+        s.dropped = dropped_.load(std::memory_order_relaxed);
+        s.clients = client_count_.load(std::memory_order_relaxed);
+        s.subscribers = subscriber_count_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    struct Route {
+        std::string content_type;
+        std::function<std::string()> body;
+    };
+
+    struct Client {
+        std::string in;          // Request bytes until the blank line
+        std::string out;         // Unsent response / event bytes
+        size_t out_pos = 0;
+        bool subscriber = false; // On /events
+        bool close_when_sent = false;
+        bool want_write = false; // EPOLLOUT registered
+        uint32_t missed = 0;     // Events missed in a row
+    };
+
+    const Seqlock<LiveSample> *live_ = nullptr;
+    TimestampFormatter ts_format_;
+    int listen_fd_ = -1;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::unordered_map<int, Client> clients_;   // Server thread only
+    std::unordered_map<std::string, Route> routes_;
+
+    uint32_t last_version_ = 0;
+    LiveSample sample_;
+    std::string event_;          // Newest "id: ..\ndata: {..}\n\n"
+    int64_t last_event_ms_ = 0;
+
+    std::atomic<uint64_t> requests_{0}, events_{0}, missed_{0}, dropped_{0};
+    std::atomic<size_t> client_count_{0}, subscriber_count_{0};
+
+    static int64_t now_ms() { return sample_clock_now().monotonic_ns / 1000000; }
+
+    void close_fds() {
+        if (listen_fd_ != -1) ::close(listen_fd_);
+        if (epoll_fd_ != -1) ::close(epoll_fd_);
+        if (wake_fd_ != -1) ::close(wake_fd_);
+        listen_fd_ = epoll_fd_ = wake_fd_ = -1;
+    }
+
+    bool watch(int fd, uint32_t events) {
+        epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = events;
+        ev.data.fd = fd;
+        return epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) == 0;
+    }
+
+    void set_want_write(int fd, Client &c, bool want) {
+        if (c.want_write == want) return;
+        epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN | EPOLLRDHUP | (want ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+        ev.data.fd = fd;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev);
+        c.want_write = want;
+    }
+
+    void run() {
+        epoll_event events[64];
+        last_event_ms_ = now_ms();
+        while (running_) {
+            int n = epoll_wait(epoll_fd_, events, 64, HTTP_POLL_MS);
+            if (n == -1 && errno != EINTR) {
+                std::cerr << "❌ HTTP: epoll_wait failed: " << strerror(errno) << std::endl;
+                break;
+            }
+            for (int i = 0; i < n; i++) {
+                int fd = events[i].data.fd;
+                if (fd == listen_fd_) {
+                    accept_clients();
+                } else if (fd == wake_fd_) {
+                    uint64_t v;
+                    if (read(wake_fd_, &v, sizeof(v)) == -1) {
+                        // Nothing pending
+                    }
+                } else {
+                    handle_client(fd, events[i].events);
+                }
+            }
+            publish_newest();
+        }
+    }
+
+    void accept_clients() {
+        while (true) {
+            int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd == -1) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR && errno != ECONNABORTED) {
+                    std::cerr << "⚠️  HTTP: accept failed: " << strerror(errno) << std::endl;
+                }
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                return;
+            }
+            if (clients_.size() >= HTTP_MAX_CLIENTS) {
+                static const char busy[] =
+                    "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+                if (send(fd, busy, sizeof(busy) - 1, MSG_NOSIGNAL | MSG_DONTWAIT) == -1) {
+                    // Closing anyway
+                }
+                ::close(fd);
+                continue;
+            }
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            if (!watch(fd, EPOLLIN | EPOLLRDHUP)) {
+                ::close(fd);
+                continue;
+            }
+            clients_[fd];
+            client_count_.store(clients_.size(), std::memory_order_relaxed);
+        }
+    }
+
+    void drop_client(int fd) {
+        auto it = clients_.find(fd);
+        if (it == clients_.end()) return;
+        if (it->second.subscriber) subscriber_count_.fetch_sub(1, std::memory_order_relaxed);
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        clients_.erase(it);
+        client_count_.store(clients_.size(), std::memory_order_relaxed);
+    }
+
+    void handle_client(int fd, uint32_t ev) {
+        auto it = clients_.find(fd);
+        if (it == clients_.end()) return;
+        Client &c = it->second;
+
+        if (ev & (EPOLLERR | EPOLLHUP)) {
+            drop_client(fd);
+            return;
+        }
+        if (ev & (EPOLLIN | EPOLLRDHUP)) {
+            char buf[4096];
+            while (true) {
+                ssize_t got = recv(fd, buf, sizeof(buf), 0);
+                if (got > 0) {
+                    // Subscribers have nothing more to say; ignore it
+                    if (!c.subscriber && !c.close_when_sent) c.in.append(buf, got);
+                    continue;
+                }
+                if (got == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                    drop_client(fd);
+                    return;
+                }
+                if (errno == EINTR) continue;
+                break;
+            }
+            if (!c.subscriber && !c.close_when_sent) {
+                if (c.in.find("\r\n\r\n") != std::string::npos) {
+                    respond(c);
+                } else if (c.in.size() > HTTP_REQUEST_MAX_BYTES) {
+                    reply(c, "431 Request Header Fields Too Large", "text/plain", "Request too large\n");
+                }
+            }
+        }
+        if (!flush_client(fd, c)) return;
+    }
+
+    // Sends what it can; false if the client was closed
+    bool flush_client(int fd, Client &c) {
+        while (c.out_pos < c.out.size()) {
+            ssize_t sent = send(fd, c.out.data() + c.out_pos, c.out.size() - c.out_pos,
+                                MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (sent > 0) {
+                c.out_pos += sent;
+                continue;
+            }
+            if (sent == -1 && errno == EINTR) continue;
+            if (sent == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                set_want_write(fd, c, true);
+                return true;
+            }
+            drop_client(fd);
+            return false;
+        }
+        c.out.clear();
+        c.out_pos = 0;
+        set_want_write(fd, c, false);
+        if (c.close_when_sent) {
+            drop_client(fd);
+            return false;
+        }
+        return true;
+    }
+
+    void reply(Client &c, const char *status, const char *type, const std::string &body) {
+        c.out += "HTTP/1.1 ";
+        c.out += status;
+        c.out += "\r\nContent-Type: ";
+        c.out += type;
+        c.out += "\r\nContent-Length: ";
+        c.out += std::to_string(body.size());
+        c.out += "\r\nCache-Control: no-cache\r\nAccess-Control-Allow-Origin: *\r\nConnection: close\r\n\r\n";
+        c.out += body;
+        c.close_when_sent = true;
+        c.in.clear();
+        requests_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void respond(Client &c) {
+        size_t line_end = c.in.find("\r\n");
+        std::string line = c.in.substr(0, line_end);
+        size_t sp1 = line.find(' ');
+        size_t sp2 = sp1 == std::string::npos ? std::string::npos : line.find(' ', sp1 + 1);
+        if (sp2 == std::string::npos) {
+            reply(c, "400 Bad Request", "text/plain", "Bad request\n");
+            return;
+        }
+        std::string method = line.substr(0, sp1);
+        std::string path = line.substr(sp1 + 1, sp2 - sp1 - 1);
+        path = path.substr(0, path.find('?'));
+
+        if (method != "GET") {
+            reply(c, "405 Method Not Allowed", "text/plain", "Only GET is supported\n");
+        } else if (path == "/" || path == "/index.html") {
+            reply(c, "200 OK", "text/html; charset=utf-8", HTTP_LIVE_PAGE);
+        } else if (path == "/current") {
+            LiveSample s;
+            if (live_->load(s) == 0) {
+                reply(c, "503 Service Unavailable", "application/json", "{\"error\":\"no sample yet\"}\n");
+            } else {
+                char json[HTTP_JSON_MAX_CHARS];
+                size_t len = format_live_sample_json(json, s, ts_format_);
+                json[len++] = '\n';
+                reply(c, "200 OK", "application/json", std::string(json, len));
+            }
+        } else if (path == "/events") {
+            c.out += "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n"
+                     "Cache-Control: no-cache\r\nAccess-Control-Allow-Origin: *\r\n"
+                     "Connection: keep-alive\r\n\r\nretry: 2000\n\n";
+            c.out += event_;   // Newest sample right away, if any
+            c.subscriber = true;
+            c.in.clear();
+            c.in.shrink_to_fit();
+            subscriber_count_.fetch_add(1, std::memory_order_relaxed);
+            requests_.fetch_add(1, std::memory_order_relaxed);
+        } else if (routes_.count(path)) {
+            const Route &route = routes_[path];
+            reply(c, "200 OK", route.content_type.c_str(), route.body());
+        } else {
+            reply(c, "404 Not Found", "text/plain", "Not found: try /, /current or /events\n");
+        }
+    }
+
+    // New snapshot version -> one event for every subscriber; otherwise a
+    // keep-alive comment now and then so proxies keep the stream open
+    void publish_newest() {
+        uint32_t version = live_->version();
+        int64_t now = now_ms();
+        const std::string *payload = nullptr;
+        static const std::string keepalive = ": keepalive\n\n";
+        if (version != last_version_ && live_->load(sample_) != 0) {
+            last_version_ = version;
+            char json[HTTP_JSON_MAX_CHARS];
+            size_t len = format_live_sample_json(json, sample_, ts_format_);
+            event_.assign("id: ");
+            event_ += std::to_string(sample_.sample_count);
+            event_ += "\ndata: ";
+            event_.append(json, len);
+            event_ += "\n\n";
+            payload = &event_;
+            events_.fetch_add(1, std::memory_order_relaxed);
+        } else if (now - last_event_ms_ >= HTTP_KEEPALIVE_MS) {
+            payload = &keepalive;
+        }
+        if (payload == nullptr) return;
+        last_event_ms_ = now;
+
+        std::vector<int> fds;
+        fds.reserve(clients_.size());
+        for (auto &entry : clients_) {
+            if (entry.second.subscriber) fds.push_back(entry.first);
+        }
+        for (int fd : fds) {
+            Client &c = clients_[fd];
+            if (c.out.size() - c.out_pos + payload->size() > HTTP_CLIENT_MAX_PENDING) {
+                missed_.fetch_add(1, std::memory_order_relaxed);
+                if (++c.missed >= HTTP_CLIENT_MAX_MISSED) {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    drop_client(fd);
+                }
+                continue;
+            }
+            c.missed = 0;
+            if (c.out_pos > 0) {
+                c.out.erase(0, c.out_pos);
+                c.out_pos = 0;
+            }
+            c.out += *payload;
+            flush_client(fd, c);
+        }
+    }
+};
+
+#endif // EC_HTTP_LIVE_H
@@ -0,0 +1,215 @@
+#ifndef EC_INGEST_COMPRESS_H
+#define EC_INGEST_COMPRESS_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "ec_sample.h"
+
+// ===========================
+// INGEST-TIME COMPRESSION
+// ===========================
+// Optional filter between the acquisition loop and the log writer that
+// drops samples which can be rebuilt from their neighbours within a
+// per-channel tolerance. While the bath sits on a plateau almost nothing
+// is written; a step or a drifting temperature is kept point for point.
+//
+//   DEADBAND       Keep a sample when any channel moved more than its
+//                  tolerance since the last kept sample. Reconstruction:
+//                  hold the last kept value.
+//   SWINGING DOOR  Keep the end points of straight segments. Every dropped
+//                  sample lies within tolerance of the line between the two
+//                  kept samples around it. Reconstruction: linear
+//                  interpolation. Emits one sample late, since a segment
+//                  end is only known once the next sample breaks the line.
+//
+// In both modes the max reconstruction error per channel is guaranteed to
+// be <= its tolerance. Kept samples carry SAMPLE_FLAG_RETAINED (plus
+// SAMPLE_FLAG_LINEAR for swinging door) so readers know the log is sparse
+// and how to fill the gaps. A change in the pass/fail flags is always kept
+// exactly, and max_gap_s forces a heartbeat sample during long plateaus.
+
+enum IngestCompressionMode {
+    INGEST_COMPRESS_OFF = 0,
+    INGEST_COMPRESS_DEADBAND = 1,
+    INGEST_COMPRESS_SWINGING_DOOR = 2
+};
+
+const int INGEST_CHANNELS = 5;   // temp, raw_ec, sensor_ec, smart_ec, k
+
+struct IngestCompressionConfig {
+    IngestCompressionMode mode = INGEST_COMPRESS_OFF;
+    double temp_tolerance = 0.02;     // °C
+    double ec_tolerance = 0.005;      // mS/cm, applied to raw, sensor and smart EC
+    double k_tolerance = 0.0001;      // Temperature coefficient
+    double max_gap_s = 300.0;         // Keep at least one sample this often (0 = never)
+};
+
+struct IngestCompressionStats {
+    uint64_t seen = 0;        // Samples offered
+    uint64_t retained = 0;    // Samples passed on to the log
+};
+
+class IngestCompressor {
+public:
+    void configure(const IngestCompressionConfig &config) {
+        config_ = config;
+        tolerance_[0] = config.temp_tolerance;
+        tolerance_[1] = config.ec_tolerance;
+        tolerance_[2] = config.ec_tolerance;
+        tolerance_[3] = config.ec_tolerance;
+        tolerance_[4] = config.k_tolerance;
+        has_anchor_ = false;
+        has_pending_ = false;
+    }
+
+    bool enabled() const { return config_.mode != INGEST_COMPRESS_OFF; }
+
+    // Feed one sample. Writes 0, 1 or 2 samples to keep into out[] (room
+    // for 2 required) and returns how many.
+    size_t process(const SampleRecord &rec, SampleRecord *out) {
+        stats_.seen++;
+        if (config_.mode == INGEST_COMPRESS_OFF) {
+            out[0] = rec;
+            stats_.retained++;
+            return 1;
+        }
+
+        size_t n = 0;
+        if (!has_anchor_) {
+            emit(rec, out, n);
+            return n;
+        }
+
+        if (config_.mode == INGEST_COMPRESS_DEADBAND) {
+            if (breaks_deadband(rec)) emit(rec, out, n);
+            return n;
+        }
+
+        // Swinging door
+        if (!has_pending_) {
+            accept_pending(rec, out, n);
+            return n;
+        }
+        double lower[INGEST_CHANNELS], upper[INGEST_CHANNELS];
+        if (extends_segment(rec, lower, upper)) {
+            for (int c = 0; c < INGEST_CHANNELS; c++) {
+                lower_[c] = lower[c];
+                upper_[c] = upper[c];
+            }
+            pending_ = rec;
+            return n;
+        }
+
+        // Door closed: the pending sample ends the segment and anchors the next
+        emit(pending_, out, n);
+        accept_pending(rec, out, n);
+        return n;
+    }
+
+    // Release the sample held back by swinging door (call at shutdown)
+    size_t finish(SampleRecord *out) {
+        size_t n = 0;
+        if (has_pending_) emit(pending_, out, n);
+        return n;
+    }
+
+    IngestCompressionStats stats() const { return stats_; }
+
+private:
+    IngestCompressionConfig config_;
+    double tolerance_[INGEST_CHANNELS] = {0};
+    IngestCompressionStats stats_;
+
+    bool has_anchor_ = false;
+    SampleRecord anchor_ = SampleRecord();    // Last kept sample
+    bool has_pending_ = false;
+    SampleRecord pending_ = SampleRecord();   // Latest sample, a valid segment end
+    double lower_[INGEST_CHANNELS] = {0};    // Slope window allowed by the samples
+    double upper_[INGEST_CHANNELS] = {0};    // strictly between anchor_ and pending_
+
+    static const uint32_t COMPRESSOR_FLAGS = SAMPLE_FLAG_RETAINED | SAMPLE_FLAG_LINEAR;
+
+    static void channels(const SampleRecord &rec, double *v) {
+        v[0] = rec.temp;
+        v[1] = rec.raw_ec;
+        v[2] = rec.sensor_ec;
+        v[3] = rec.smart_ec;
+        v[4] = rec.k;
+    }
+
+    static double seconds_between(const SampleRecord &a, const SampleRecord &b) {
+        return (b.timestamp_ns - a.timestamp_ns) / 1e9;
+    }
+
+    bool flags_changed(const SampleRecord &rec) const {
+        return (rec.flags & ~COMPRESSOR_FLAGS) != (anchor_.flags & ~COMPRESSOR_FLAGS);
+    }
+
+    bool gap_exceeded(const SampleRecord &rec) const {
+        return config_.max_gap_s > 0 && seconds_between(anchor_, rec) > config_.max_gap_s;
+    }
+
+    void emit(const SampleRecord &rec, SampleRecord *out, size_t &n) {
+        out[n] = rec;
+        out[n].flags |= SAMPLE_FLAG_RETAINED;
+        if (config_.mode == INGEST_COMPRESS_SWINGING_DOOR) out[n].flags |= SAMPLE_FLAG_LINEAR;
+        n++;
+        stats_.retained++;
+        anchor_ = rec;
+        has_anchor_ = true;
+        has_pending_ = false;
+    }
+
+    bool breaks_deadband(const SampleRecord &rec) const {
+        if (flags_changed(rec) || gap_exceeded(rec)) return true;
+        double a[INGEST_CHANNELS], v[INGEST_CHANNELS];
+        channels(anchor_, a);
+        channels(rec, v);
+        for (int c = 0; c < INGEST_CHANNELS; c++) {
+            if (std::fabs(v[c] - a[c]) > tolerance_[c]) return true;
+        }
+        return false;
+    }
+
+    // First sample after the anchor: any straight line fits, unless the
+    // flags changed, which must be kept exactly
+    void accept_pending(const SampleRecord &rec, SampleRecord *out, size_t &n) {
+        if (flags_changed(rec)) {
+            emit(rec, out, n);
+            return;
+        }
+        pending_ = rec;
+        has_pending_ = true;
+        for (int c = 0; c < INGEST_CHANNELS; c++) {
+            lower_[c] = -INFINITY;
+            upper_[c] = INFINITY;
+        }
+    }
+
+    // Can rec replace pending_ as the segment end? pending_ then becomes an
+    // intermediate sample, narrowing the window to slopes that pass within
+    // tolerance of it; rec's own slope from the anchor must still fit.
+    bool extends_segment(const SampleRecord &rec, double *lower, double *upper) const {
+        if (flags_changed(rec) || gap_exceeded(rec)) return false;
+
+        double dt_pending = seconds_between(anchor_, pending_);
+        double dt_rec = seconds_between(anchor_, rec);
+        if (dt_pending <= 0 || dt_rec <= dt_pending) return false;
+
+        double a[INGEST_CHANNELS], p[INGEST_CHANNELS], v[INGEST_CHANNELS];
+        channels(anchor_, a);
+        channels(pending_, p);
+        channels(rec, v);
+        for (int c = 0; c < INGEST_CHANNELS; c++) {
+            lower[c] = std::fmax(lower_[c], (p[c] - tolerance_[c] - a[c]) / dt_pending);
+            upper[c] = std::fmin(upper_[c], (p[c] + tolerance_[c] - a[c]) / dt_pending);
+            double slope = (v[c] - a[c]) / dt_rec;
+            if (slope < lower[c] || slope > upper[c]) return false;
+        }
+        return true;
+    }
+};
+
+#endif // EC_INGEST_COMPRESS_H
@@ -0,0 +1,262 @@
+#ifndef EC_LOG_INDEX_H
+#define EC_LOG_INDEX_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "ec_sample.h"
+
+// ===========================
+// SPARSE TIME INDEX (sidecar LOG.idx)
+// ===========================
+// One fixed-size entry per LOG_INDEX_INTERVAL records, in log order. Each
+// entry holds where its first record lives in the log plus the time span
+// and value ranges of its records, so a query can binary-search to a time
+// range and skip entries whose ranges cannot match a filter, then decode
+// only the few blocks/lines that remain.
+//
+// Positions are (offset, skip): for CSV the byte offset of the row (skip
+// is 0); for .ecb/.ecg the file offset of the block and the record's index
+// inside it.
+//
+// The index is written after the log data it describes and may lag it
+// after a crash; readers treat the last entry as open-ended and scan from
+// it to the end of the log. Ranges are conservative (never too narrow).
+
+const char LOG_INDEX_MAGIC[8] = {'E', 'C', 'L', 'I', 'D', 'X', '\r', '\n'};
+const uint32_t LOG_INDEX_VERSION = 1;
+const uint32_t LOG_INDEX_INTERVAL = 1024;   // Records per entry
+
+struct LogIndexHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t log_format;        // LogFormat of the indexed log
+    uint32_t interval;          // Records per entry
+    uint32_t entry_size;        // sizeof(LogIndexEntry)
+    uint32_t reserved[2];
+};
+static_assert(sizeof(LogIndexHeader) == 32, "LogIndexHeader must stay 32 bytes");
+
+struct LogIndexEntry {
+    int64_t  first_timestamp_ns;
+    int64_t  last_timestamp_ns;
+    uint64_t offset;            // Position of the first record
+    uint32_t skip;
+    uint32_t count;             // Records covered
+    float    min_temp, max_temp;
+    float    min_raw_ec, max_raw_ec;
+    float    min_sensor_ec, max_sensor_ec;
+    float    min_smart_ec, max_smart_ec;
+};
+static_assert(sizeof(LogIndexEntry) == 64, "LogIndexEntry must stay 64 bytes");
+
+inline std::string log_index_path(const std::string &log_path) {
+    return log_path + ".idx";
+}
+
+// (offset, skip) ordering
+inline bool log_position_before(uint64_t off_a, uint32_t skip_a, uint64_t off_b, uint32_t skip_b) {
+    return off_a < off_b || (off_a == off_b && skip_a < skip_b);
+}
+
+// ===========================
+// INDEX WRITER
+// ===========================
+// Fed every record (with its log position) just before the log writer
+// appends it. flush() must follow the log's flush so the index never
+// points at data that has not reached the OS.
+class LogIndexWriter {
+public:
+    LogIndexWriter() {}
+    ~LogIndexWriter() { close(); }
+    LogIndexWriter(const LogIndexWriter &) = delete;
+    LogIndexWriter &operator=(const LogIndexWriter &) = delete;
+
+    // log_has_records: the log already holds data. Without a matching index
+    // for it, indexing stays off (rebuild with ec_log_tool index) rather
+    // than describing only part of the log. Entries at or past the log's
+    // append position (cut by torn-tail recovery) are dropped.
+    bool open(const std::string &path, uint32_t log_format, bool log_has_records,
+              uint64_t next_offset, uint32_t next_skip) {
+        close();
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd_ == -1) {
+            std::cerr << "⚠️  Cannot open index " << path << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+
+        struct stat st;
+        fstat(fd_, &st);
+        if (st.st_size == 0 || !log_has_records) {
+            if (log_has_records) {
+                unlink(path.c_str());
+                return disable(path, "no index for the existing log");
+            }
+            LogIndexHeader hdr;
+            memset(&hdr, 0, sizeof(hdr));
+            memcpy(hdr.magic, LOG_INDEX_MAGIC, sizeof(hdr.magic));
+            hdr.version = LOG_INDEX_VERSION;
+            hdr.log_format = log_format;
+            hdr.interval = LOG_INDEX_INTERVAL;
+            hdr.entry_size = sizeof(LogIndexEntry);
+            if (ftruncate(fd_, 0) == -1 ||
+                pwrite(fd_, &hdr, sizeof(hdr), 0) != static_cast<ssize_t>(sizeof(hdr))) {
+                return disable(path, strerror(errno));
+            }
+            slot_ = 0;
+            return true;
+        }
+
+        LogIndexHeader hdr;
+        if (pread(fd_, &hdr, sizeof(hdr), 0) != static_cast<ssize_t>(sizeof(hdr)) ||
+            memcmp(hdr.magic, LOG_INDEX_MAGIC, sizeof(hdr.magic)) != 0 ||
+            hdr.version != LOG_INDEX_VERSION || hdr.log_format != log_format ||
+            hdr.entry_size != sizeof(LogIndexEntry)) {
+            return disable(path, "index does not match this log");
+        }
+
+        // Keep whole entries that start before the append position
+        uint64_t slots = (st.st_size - sizeof(hdr)) / sizeof(LogIndexEntry);
+        LogIndexEntry e;
+        while (slots > 0 &&
+               pread(fd_, &e, sizeof(e), entry_offset(slots - 1)) == static_cast<ssize_t>(sizeof(e)) &&
+               !log_position_before(e.offset, e.skip, next_offset, next_skip)) {
+            slots--;
+        }
+        slot_ = slots;
+        if (ftruncate(fd_, entry_offset(slot_)) == -1) return disable(path, strerror(errno));
+        return true;
+    }
+
+    void add(const SampleRecord &rec, uint64_t offset, uint32_t skip) {
+        if (fd_ == -1) return;
+        if (current_.count == 0) {
+            memset(&current_, 0, sizeof(current_));
+            current_.first_timestamp_ns = rec.timestamp_ns;
+            current_.offset = offset;
+            current_.skip = skip;
+            current_.min_temp = current_.max_temp = rec.temp;
+            current_.min_raw_ec = current_.max_raw_ec = rec.raw_ec;
+            current_.min_sensor_ec = current_.max_sensor_ec = rec.sensor_ec;
+            current_.min_smart_ec = current_.max_smart_ec = rec.smart_ec;
+        }
+        current_.last_timestamp_ns = rec.timestamp_ns;
+        widen(current_.min_temp, current_.max_temp, rec.temp);
+        widen(current_.min_raw_ec, current_.max_raw_ec, rec.raw_ec);
+        widen(current_.min_sensor_ec, current_.max_sensor_ec, rec.sensor_ec);
+        widen(current_.min_smart_ec, current_.max_smart_ec, rec.smart_ec);
+        current_.count++;
+
+        if (current_.count == LOG_INDEX_INTERVAL) {
+            closed_.push_back(current_);
+            current_.count = 0;
+        }
+    }
+
+    // Persist entries completed since the last flush, then the open
+    // (partial) entry in the slot after them
+    bool flush() {
+        if (fd_ == -1) return true;
+        bool ok = true;
+        for (const LogIndexEntry &e : closed_) {
+            ok = write_entry(e, slot_) && ok;
+            slot_++;
+        }
+        closed_.clear();
+        if (current_.count > 0) ok = write_entry(current_, slot_) && ok;
+        return ok;
+    }
+
+    bool sync() {
+        if (fd_ == -1) return true;
+        return fdatasync(fd_) == 0;
+    }
+
+    void close() {
+        if (fd_ == -1) return;
+        flush();
+        ::close(fd_);
+        fd_ = -1;
+        current_.count = 0;
+        closed_.clear();
+    }
+
+    bool is_open() const { return fd_ != -1; }
+
+private:
+    int fd_ = -1;
+    uint64_t slot_ = 0;                  // Slot of the first unwritten entry
+    std::vector<LogIndexEntry> closed_;  // Full entries awaiting flush()
+    LogIndexEntry current_ = LogIndexEntry();
+
+    static off_t entry_offset(uint64_t slot) {
+        return sizeof(LogIndexHeader) + static_cast<off_t>(slot) * sizeof(LogIndexEntry);
+    }
+
+    // NaN readings would poison the ranges; they cannot match a filter anyway
+    static void widen(float &lo, float &hi, float v) {
+        if (std::isnan(v)) return;
+        if (std::isnan(lo) || v < lo) lo = v;
+        if (std::isnan(hi) || v > hi) hi = v;
+    }
+
+    bool write_entry(const LogIndexEntry &e, uint64_t slot) {
+        if (pwrite(fd_, &e, sizeof(e), entry_offset(slot)) != static_cast<ssize_t>(sizeof(e))) {
+            std::cerr << "⚠️  Index write failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool disable(const std::string &path, const std::string &why) {
+        std::cerr << "⚠️  " << path << ": " << why << ", time index disabled"
+                  << " (rebuild with: ec_log_tool index LOG)" << std::endl;
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+};
+
+// ===========================
+// INDEX READER
+// ===========================
+// Whole file in memory: a month at 1 Hz is ~2,500 entries (160 KB)
+inline bool log_index_load(const std::string &path, uint32_t log_format, std::vector<LogIndexEntry> &out) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) return false;
+    struct stat st;
+    fstat(fd, &st);
+
+    LogIndexHeader hdr;
+    bool ok = st.st_size >= static_cast<off_t>(sizeof(hdr)) &&
+              pread(fd, &hdr, sizeof(hdr), 0) == static_cast<ssize_t>(sizeof(hdr)) &&
+              memcmp(hdr.magic, LOG_INDEX_MAGIC, sizeof(hdr.magic)) == 0 &&
+              hdr.version == LOG_INDEX_VERSION && hdr.log_format == log_format &&
+              hdr.entry_size == sizeof(LogIndexEntry);
+    if (ok) {
+        size_t n = (st.st_size - sizeof(hdr)) / sizeof(LogIndexEntry);
+        out.resize(n);
+        size_t bytes = n * sizeof(LogIndexEntry);
+        ok = pread(fd, out.data(), bytes, sizeof(hdr)) == static_cast<ssize_t>(bytes);
+    }
+    ::close(fd);
+    return ok;
+}
+
+// First entry whose records may reach timestamp_ns (assumes a monotonic clock)
+inline size_t log_index_seek(const std::vector<LogIndexEntry> &entries, int64_t timestamp_ns) {
+    return std::lower_bound(entries.begin(), entries.end(), timestamp_ns,
+                            [](const LogIndexEntry &e, int64_t ts) {
+                                return e.last_timestamp_ns < ts;
+                            }) - entries.begin();
+}
+
+#endif // EC_LOG_INDEX_H
@@ -0,0 +1,229 @@
+#ifndef EC_LOG_MANIFEST_H
+#define EC_LOG_MANIFEST_H
+
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "ec_sample.h"
+#include "ec_log_index.h"
+#include "ec_timestamp.h"
+
+// ===========================
+// SEGMENT MANIFEST (LOG.manifest.csv)
+// ===========================
+// One line per closed (rotated) segment of a log, with the time span and
+// temperature / Smart EC ranges of its records, so a query or a batch job
+// can pick the few segments that matter and process them in parallel
+// without opening the rest:
+//
+//   Segment,Records,First_ns,Last_ns,First,Last,Min_Temp,Max_Temp,Min_Smart_EC,Max_Smart_EC
+//   ec_data_log.20260114-000000.csv.gz,86400,...,2026-01-14 00:00:00,2026-01-14 23:59:59,...
+//
+// Segment names are relative to the manifest's directory. A line with
+// nothing but the name means "unknown" (the segment was resumed from a run
+// without a time index) and must never be skipped. The active segment is
+// not listed; it always has to be considered.
+
+const char LOG_MANIFEST_HEADER[] =
+    "Segment,Records,First_ns,Last_ns,First,Last,Min_Temp,Max_Temp,Min_Smart_EC,Max_Smart_EC\n";
+
+inline std::string log_manifest_path(const std::string &log_path) {
+    return log_path + ".manifest.csv";
+}
+
+inline std::string log_path_dir(const std::string &path) {
+    size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+}
+
+inline std::string log_path_base(const std::string &path) {
+    size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+// Records and ranges of one segment, accumulated as it is written
+struct SegmentStats {
+    uint64_t records = 0;
+    int64_t first_ns = 0;
+    int64_t last_ns = 0;
+    float min_temp = NAN, max_temp = NAN;
+    float min_smart_ec = NAN, max_smart_ec = NAN;
+    bool ranges_known = true;
+
+    void add(const SampleRecord &rec) {
+        if (records == 0 && first_ns == 0) first_ns = rec.timestamp_ns;
+        last_ns = rec.timestamp_ns;
+        records++;
+        widen(min_temp, max_temp, rec.temp);
+        widen(min_smart_ec, max_smart_ec, rec.smart_ec);
+    }
+
+    // Resume the statistics of an existing segment from its time index
+    void seed(const std::vector<LogIndexEntry> &entries) {
+        for (const LogIndexEntry &e : entries) {
+            if (e.count == 0) continue;
+            if (records == 0) first_ns = e.first_timestamp_ns;
+            last_ns = e.last_timestamp_ns;
+            records += e.count;
+            widen(min_temp, max_temp, e.min_temp);
+            widen(min_temp, max_temp, e.max_temp);
+            widen(min_smart_ec, max_smart_ec, e.min_smart_ec);
+            widen(min_smart_ec, max_smart_ec, e.max_smart_ec);
+        }
+    }
+
+    static void widen(float &lo, float &hi, float v) {
+        if (std::isnan(v)) return;
+        if (std::isnan(lo) || v < lo) lo = v;
+        if (std::isnan(hi) || v > hi) hi = v;
+    }
+};
+
+struct ManifestEntry {
+    std::string segment;        // File name, relative to the manifest
+    SegmentStats stats;
+};
+
+inline std::string manifest_format_line(const ManifestEntry &e) {
+    std::ostringstream out;
+    const SegmentStats &s = e.stats;
+    TimestampFormatter ts_format;
+    out << e.segment;
+    if (!s.ranges_known) {
+        out << ",,,,,,,,,\n";
+        return out.str();
+    }
+    out << "," << s.records << "," << s.first_ns << "," << s.last_ns << ","
+        << ts_format.format(s.first_ns) << "," << ts_format.format(s.last_ns);
+    if (!std::isnan(s.min_temp)) {
+        // Round-trip precision: rounded bounds could exclude their own extremes
+        out << std::setprecision(9) << "," << s.min_temp << "," << s.max_temp << ","
+            << s.min_smart_ec << "," << s.max_smart_ec;
+    } else {
+        out << ",,,,";
+    }
+    out << "\n";
+    return out.str();
+}
+
+inline bool manifest_parse_line(const std::string &line, ManifestEntry *e) {
+    std::vector<std::string> f;
+    std::stringstream ss(line);
+    std::string field;
+    while (std::getline(ss, field, ',')) f.push_back(field);
+    if (!line.empty() && line.back() == ',') f.push_back("");
+    if (f.size() != 10 || f[0].empty() || f[0] == "Segment") return false;
+
+    e->segment = f[0];
+    e->stats = SegmentStats();
+    e->stats.ranges_known = !f[2].empty();
+    if (!e->stats.ranges_known) return true;
+    e->stats.records = std::strtoull(f[1].c_str(), nullptr, 10);
+    e->stats.first_ns = std::strtoll(f[2].c_str(), nullptr, 10);
+    e->stats.last_ns = std::strtoll(f[3].c_str(), nullptr, 10);
+    if (!f[6].empty()) {
+        e->stats.min_temp = std::strtof(f[6].c_str(), nullptr);
+        e->stats.max_temp = std::strtof(f[7].c_str(), nullptr);
+        e->stats.min_smart_ec = std::strtof(f[8].c_str(), nullptr);
+        e->stats.max_smart_ec = std::strtof(f[9].c_str(), nullptr);
+    }
+    return true;
+}
+
+inline bool log_manifest_load(const std::string &path, std::vector<ManifestEntry> &out) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    ManifestEntry e;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (manifest_parse_line(line, &e)) out.push_back(e);
+    }
+    return true;
+}
+
+// ===========================
+// MANIFEST WRITER
+// ===========================
+// Shared by the log writer thread (add) and the background compressor
+// (rename), hence the mutex. Adds are appended and fdatasync'ed; renames
+// rewrite the small file and atomically replace it.
+class SegmentManifest {
+public:
+    void open(const std::string &log_path) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        path_ = log_manifest_path(log_path);
+        dir_ = log_path_dir(log_path);
+        entries_.clear();
+        log_manifest_load(path_, entries_);
+    }
+
+    const std::string &dir() const { return dir_; }
+
+    bool add(const ManifestEntry &e) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        bool fresh = access(path_.c_str(), F_OK) != 0;
+        int fd = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd == -1) {
+            std::cerr << "⚠️  Cannot open manifest " << path_ << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        std::string text = (fresh ? std::string(LOG_MANIFEST_HEADER) : std::string()) + manifest_format_line(e);
+        bool ok = ::write(fd, text.data(), text.size()) == static_cast<ssize_t>(text.size()) &&
+                  fdatasync(fd) == 0;
+        ::close(fd);
+        if (!ok) std::cerr << "⚠️  Manifest write failed: " << strerror(errno) << std::endl;
+        entries_.push_back(e);
+        return ok;
+    }
+
+    bool rename_segment(const std::string &from, const std::string &to) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<ManifestEntry> renamed = entries_;
+        for (ManifestEntry &e : renamed) {
+            if (e.segment == from) e.segment = to;
+        }
+        std::string text = LOG_MANIFEST_HEADER;
+        for (const ManifestEntry &e : renamed) text += manifest_format_line(e);
+
+        std::string tmp = path_ + ".tmp";
+        int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd == -1) return false;
+        bool ok = ::write(fd, text.data(), text.size()) == static_cast<ssize_t>(text.size()) &&
+                  fdatasync(fd) == 0;
+        ::close(fd);
+        if (ok) ok = ::rename(tmp.c_str(), path_.c_str()) == 0;
+        if (!ok) {
+            std::cerr << "⚠️  Manifest update failed: " << strerror(errno) << std::endl;
+            unlink(tmp.c_str());
+            return false;
+        }
+        entries_.swap(renamed);
+        return true;
+    }
+
+    std::vector<ManifestEntry> entries() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_;
+    }
+
+private:
+    std::mutex mutex_;
+    std::string path_;
+    std::string dir_;
+    std::vector<ManifestEntry> entries_;
+};
+
+#endif // EC_LOG_MANIFEST_H
@@ -0,0 +1,228 @@
+#ifndef EC_LOG_ROTATE_H
+#define EC_LOG_ROTATE_H
+
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <zlib.h>
+
+#include "ec_log_manifest.h"
+
+// ===========================
+// LOG ROTATION
+// ===========================
+// The active log segment is closed and renamed aside (ec_log_segment.h)
+// once it reaches a size limit or its first sample's local hour / day is
+// over. The closed segment and its ranges are added to LOG.manifest.csv,
+// and a background thread at idle CPU and I/O priority gzips it to
+// SEGMENT.gz (Python, pandas and zcat read these directly). Gorilla
+// segments are already compressed and are left as they are.
+//
+// Compression is crash-safe: SEGMENT.gz.tmp is written and fsync'ed, then
+// renamed, then the manifest is updated, then the plain file and its time
+// index (positions in the plain file) are removed.
+// Anything interrupted is picked up again from the manifest on the next
+// start.
+
+enum RotationInterval {
+    ROTATE_NEVER = 0,
+    ROTATE_HOURLY = 1,
+    ROTATE_DAILY = 2
+};
+
+struct RotationPolicy {
+    uint64_t max_bytes = 0;                     // Rotate at this segment size (0 = no limit)
+    RotationInterval interval = ROTATE_NEVER;   // ...or when the local hour/day ends
+    bool compress = true;                       // gzip closed segments in the background
+
+    bool enabled() const { return max_bytes > 0 || interval != ROTATE_NEVER; }
+};
+
+const size_t ROTATE_GZIP_CHUNK = 1024 * 1024;
+
+// First local hour / day boundary after timestamp_ns
+inline int64_t rotation_boundary_ns(int64_t timestamp_ns, RotationInterval interval) {
+    time_t secs = static_cast<time_t>(timestamp_ns / 1000000000LL);
+    struct tm tm;
+    localtime_r(&secs, &tm);
+    tm.tm_min = 0;
+    tm.tm_sec = 0;
+    if (interval == ROTATE_HOURLY) {
+        tm.tm_hour += 1;
+    } else {
+        tm.tm_hour = 0;
+        tm.tm_mday += 1;
+    }
+    tm.tm_isdst = -1;
+    time_t next = mktime(&tm);
+    // Repeated hour at the end of DST: fall back to the next UTC hour
+    if (next <= secs) next = (secs / 3600 + 1) * 3600;
+    return static_cast<int64_t>(next) * 1000000000LL;
+}
+
+// ===========================
+// BACKGROUND SEGMENT COMPRESSOR
+// ===========================
+class SegmentCompressor {
+public:
+    SegmentCompressor() {}
+    ~SegmentCompressor() { stop(); }
+    SegmentCompressor(const SegmentCompressor &) = delete;
+    SegmentCompressor &operator=(const SegmentCompressor &) = delete;
+
+    // Queues segments the manifest lists as plain files (interrupted runs)
+    void start(SegmentManifest *manifest) {
+        manifest_ = manifest;
+        for (const ManifestEntry &e : manifest_->entries()) {
+            std::string path = manifest_->dir() + e.segment;
+            if (has_gz_suffix(e.segment)) {
+                // Compressed, but the plain file survived a crash
+                std::string plain = path.substr(0, path.size() - 3);
+                if (access(plain.c_str(), F_OK) == 0 && access(path.c_str(), F_OK) == 0) {
+                    unlink(plain.c_str());
+                }
+            } else if (access(path.c_str(), F_OK) == 0 && compressible(path)) {
+                queue_.push_back(path);
+            }
+        }
+        stopping_ = false;
+        thread_ = std::thread(&SegmentCompressor::run, this);
+    }
+
+    void enqueue(const std::string &path) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(path);
+        }
+        wake_.notify_one();
+    }
+
+    // Abandons the current file between chunks; it is redone next start
+    void stop() {
+        if (!thread_.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_one();
+        thread_.join();
+    }
+
+    uint64_t segments_compressed() const { return compressed_.load(std::memory_order_relaxed); }
+
+    // Gorilla logs are compressed already
+    static bool compressible(const std::string &path) {
+        return !(path.size() >= 4 && path.compare(path.size() - 4, 4, ".ecg") == 0);
+    }
+
+private:
+    SegmentManifest *manifest_ = nullptr;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<std::string> queue_;
+    bool stopping_ = false;
+    std::atomic<uint64_t> compressed_{0};
+
+    static bool has_gz_suffix(const std::string &s) {
+        return s.size() >= 3 && s.compare(s.size() - 3, 3, ".gz") == 0;
+    }
+
+    bool stop_requested() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stopping_;
+    }
+
+    void run() {
+        // Per-thread on Linux: nice 19 and the idle I/O class (ioprio_set
+        // has no glibc wrapper; class 3 = IOPRIO_CLASS_IDLE)
+        pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+        setpriority(PRIO_PROCESS, tid, 19);
+        syscall(SYS_ioprio_set, 1, tid, 3 << 13);
+
+        while (true) {
+            std::string path;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+                if (stopping_) return;
+                path = queue_.front();
+                queue_.pop_front();
+            }
+            compress(path);
+        }
+    }
+
+    void compress(const std::string &path) {
+        std::string gz = path + ".gz";
+        std::string tmp = gz + ".tmp";
+        int in = ::open(path.c_str(), O_RDONLY);
+        if (in == -1) {
+            std::cerr << "⚠️  Cannot open segment " << path << ": " << strerror(errno) << std::endl;
+            return;
+        }
+        gzFile out = gzopen(tmp.c_str(), "wb6");
+        if (!out) {
+            std::cerr << "⚠️  Cannot create " << tmp << std::endl;
+            ::close(in);
+            return;
+        }
+
+        std::vector<char> buf(ROTATE_GZIP_CHUNK);
+        bool ok = true;
+        while (ok) {
+            if (stop_requested()) {
+                ok = false;
+                break;
+            }
+            ssize_t n = ::read(in, buf.data(), buf.size());
+            if (n == -1 && errno == EINTR) continue;
+            if (n <= 0) {
+                ok = (n == 0);
+                break;
+            }
+            ok = gzwrite(out, buf.data(), static_cast<unsigned>(n)) == n;
+        }
+        ::close(in);
+        if (gzclose(out) != Z_OK) ok = false;
+        if (ok) ok = sync_file(tmp) && ::rename(tmp.c_str(), gz.c_str()) == 0;
+        if (!ok) {
+            unlink(tmp.c_str());
+            if (!stop_requested()) std::cerr << "⚠️  Compressing " << path << " failed" << std::endl;
+            return;
+        }
+
+        // The plain file goes only once the manifest names the .gz; if that
+        // fails, the segment stays plain and is compressed again next start
+        if (!manifest_->rename_segment(log_path_base(path), log_path_base(gz))) {
+            unlink(gz.c_str());
+            return;
+        }
+        unlink(path.c_str());
+        unlink(log_index_path(path).c_str());   // Positions in the plain file
+        compressed_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static bool sync_file(const std::string &path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd == -1) return false;
+        bool ok = fdatasync(fd) == 0;
+        ::close(fd);
+        return ok;
+    }
+};
+
+#endif // EC_LOG_ROTATE_H
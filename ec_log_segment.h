@@ -0,0 +1,76 @@
+#ifndef EC_LOG_SEGMENT_H
+#define EC_LOG_SEGMENT_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+#include "ec_log_index.h"
+
+// ===========================
+// LOG SEGMENTS
+// ===========================
+// A log path names the active segment. A segment that is rotated out
+// (ec_log_rotate.h) or can no longer be appended to (it was written with a
+// different schema) is renamed aside with a local-time tag before the
+// extension, and a fresh segment is started under the original name:
+//
+//   ec_data_log.csv  ->  ec_data_log.20260114-220501.csv
+//
+// Its time index (LOG.idx) holds file positions, so it moves along with it.
+// Rollup tiers aggregate by time, not position, and stay with the active
+// path.
+
+// "dir/name.ext" + tag -> "dir/name.tag.ext" (no extension: "dir/name.tag")
+inline std::string log_segment_path(const std::string &path, const std::string &tag) {
+    size_t slash = path.find_last_of('/');
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash) ||
+        dot == (slash == std::string::npos ? 0 : slash + 1)) {
+        return path + "." + tag;
+    }
+    return path.substr(0, dot) + "." + tag + path.substr(dot);
+}
+
+// First unused archive name for path, tagged with the local time `when`
+inline std::string log_free_segment_path(const std::string &path, time_t when) {
+    struct tm tm;
+    localtime_r(&when, &tm);
+    char stamp[32];
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &tm);
+
+    std::string candidate = log_segment_path(path, stamp);
+    for (int n = 2; access(candidate.c_str(), F_OK) == 0 ||
+                    access((candidate + ".gz").c_str(), F_OK) == 0; n++) {
+        candidate = log_segment_path(path, std::string(stamp) + "-" + std::to_string(n));
+    }
+    return candidate;
+}
+
+// Move a segment and its index to a new name
+inline bool log_rename_segment(const std::string &from, const std::string &to) {
+    if (rename(from.c_str(), to.c_str()) == -1) {
+        std::cerr << "❌ Cannot move " << from << " aside: " << strerror(errno) << std::endl;
+        return false;
+    }
+    std::string idx = log_index_path(from);
+    if (access(idx.c_str(), F_OK) == 0) rename(idx.c_str(), log_index_path(to).c_str());
+    return true;
+}
+
+// Rename the segment at path aside, tagged with the current time. Returns
+// the new name, or an empty string if the rename failed.
+inline std::string log_archive_segment(const std::string &path, const char *why) {
+    std::string archived = log_free_segment_path(path, time(nullptr));
+    if (!log_rename_segment(path, archived)) return std::string();
+    std::cerr << "⚠️  " << path << ": " << why << "; kept as " << archived
+              << ", starting a new segment" << std::endl;
+    return archived;
+}
+
+#endif // EC_LOG_SEGMENT_H
@@ -0,0 +1,475 @@
+#ifndef EC_LOG_SELFTEST_H
+#define EC_LOG_SELFTEST_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "ec_sample.h"
+#include "ec_gorilla.h"
+#include "ec_wal.h"
+
+// ===========================
+// LOG FORMAT SELF-TEST
+// ===========================
+// Checks the log codecs and their crash recovery without a sensor
+// (./ec_log_tool selftest). Everything runs in a private temporary
+// directory from fixed seeds, so a failure reproduces:
+//   - random gorilla blocks (drift, exact repeats, random bit patterns,
+//     timestamp gaps and steps back) decode bit-exactly
+//   - a gorilla log cut at every byte of its last block reopens with
+//     exactly the records of the blocks before it
+//   - a gorilla flush torn at every byte of its payload reopens with
+//     exactly the records of the flush before it
+//   - WAL samples encode and decode bit-exactly, and a WAL cut inside its
+//     header or at every byte of its last group commit reopens with every
+//     complete sample and nothing damaged in front of new appends
+// After every recovery one more record is appended and must read back.
+
+const uint64_t SELFTEST_SEED = 0x45434C4F47ULL;   // "ECLOG"
+const int SELFTEST_ROUNDTRIP_BLOCKS = 64;
+const uint32_t SELFTEST_TAIL_RECORDS = 300;      // Records in the block that gets cut
+const int SELFTEST_TORN_FLUSHES = 12;
+const uint32_t SELFTEST_WAL_RECORDS = 1500;     // More than the WAL recovery window holds
+const uint32_t SELFTEST_WAL_TAIL_RECORDS = 40;   // Records in the last group commit
+const int SELFTEST_MAX_REPORTED = 20;            // Failures printed in full
+
+// ===========================
+// CHECKS AND SCRATCH FILES
+// ===========================
+class SelftestReport {
+public:
+    // Count one check; a failed one is printed (the first few)
+    bool expect(bool ok, const std::string &what) {
+        checks_++;
+        if (!ok) {
+            failures_++;
+            if (failures_ <= SELFTEST_MAX_REPORTED) std::cerr << "❌ " << what << std::endl;
+        }
+        return ok;
+    }
+
+    uint64_t checks() const { return checks_; }
+    uint64_t failures() const { return failures_; }
+
+private:
+    uint64_t checks_ = 0;
+    uint64_t failures_ = 0;
+};
+
+// Private directory for the files under test, removed with them
+class SelftestDir {
+public:
+    SelftestDir() {}
+    ~SelftestDir() {
+        for (const std::string &p : paths_) unlink(p.c_str());
+        if (!dir_.empty()) rmdir(dir_.c_str());
+    }
+    SelftestDir(const SelftestDir &) = delete;
+    SelftestDir &operator=(const SelftestDir &) = delete;
+
+    bool create() {
+        const char *tmp = getenv("TMPDIR");
+        std::string templ = std::string(tmp && *tmp ? tmp : "/tmp") + "/ec_selftest.XXXXXX";
+        std::vector<char> dir(templ.begin(), templ.end());
+        dir.push_back('\0');
+        if (!mkdtemp(dir.data())) {
+            std::cerr << "❌ Cannot create a directory in " << templ << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        dir_ = dir.data();
+        return true;
+    }
+
+    std::string path(const std::string &name) {
+        paths_.push_back(dir_ + "/" + name);
+        return paths_.back();
+    }
+
+private:
+    std::string dir_;
+    std::vector<std::string> paths_;
+};
+
+// Recovery reports every cut it makes; expected here, so keep it quiet
+class SelftestQuietCerr {
+public:
+    SelftestQuietCerr() : saved_(std::cerr.rdbuf(nullptr)) {}
+    ~SelftestQuietCerr() {
+        std::cerr.rdbuf(saved_);
+        std::cerr.clear();
+    }
+
+private:
+    std::streambuf *saved_;
+};
+
+inline bool selftest_read_file(const std::string &path, std::vector<uint8_t> &out) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) return false;
+    out.resize(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    in.read(reinterpret_cast<char *>(out.data()), out.size());
+    return static_cast<bool>(in);
+}
+
+inline bool selftest_write_file(const std::string &path, const uint8_t *data, size_t len) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(data), len);
+    return static_cast<bool>(out);
+}
+
+// ===========================
+// TEST RECORDS
+// ===========================
+// A mix that reaches every encoder bucket: steady 1 s polls with jitter,
+// long gaps, clock steps back, slow drift, exact repeats and random bit
+// patterns (NaN and infinity included)
+inline std::vector<SampleRecord> selftest_records(std::mt19937_64 &rng, size_t n) {
+    std::vector<SampleRecord> out(n);
+    int64_t t = 1768000000000000000LL;
+    float SampleRecord::*const fields[5] = {&SampleRecord::temp, &SampleRecord::raw_ec, &SampleRecord::sensor_ec,
+                                            &SampleRecord::smart_ec, &SampleRecord::k};
+    float drift[5] = {20.0f, 11.5f, 12.7f, 12.88f, 0.0191f};
+    for (size_t i = 0; i < n; i++) {
+        SampleRecord &r = out[i];
+        memset(&r, 0, sizeof(r));
+        uint32_t mode = rng() % 8;
+        if (mode == 0) {
+            t += static_cast<int64_t>(rng() % 100000) * 1000000000LL;
+        } else if (mode == 1) {
+            t -= static_cast<int64_t>(rng() % 5000) * 1000000LL;
+        } else {
+            t += 900000000LL + static_cast<int64_t>(rng() % 200000000ULL);
+        }
+        r.timestamp_ns = t;
+
+        for (int c = 0; c < 5; c++) {
+            if (mode == 2) {
+                r.*fields[c] = sample_bits_float(static_cast<uint32_t>(rng()));
+            } else if (mode == 3 && i > 0) {
+                r.*fields[c] = out[i - 1].*fields[c];
+            } else {
+                drift[c] += (static_cast<int>(rng() % 201) - 100) * 0.0001f;
+                r.*fields[c] = drift[c];
+            }
+        }
+        r.flags = mode == 2 ? static_cast<uint32_t>(rng()) : static_cast<uint32_t>(rng() % 16);
+        sample_float_to_regs(r.temp, r.reg_temp);
+        sample_float_to_regs(r.raw_ec, r.reg_raw_ec);
+        sample_float_to_regs(r.sensor_ec, r.reg_sensor_ec);
+    }
+    return out;
+}
+
+// Equal as stored: timestamps at the log's resolution, values bit for bit
+inline bool selftest_same(const SampleRecord &a, const SampleRecord &b, int64_t ts_unit_ns) {
+    return a.timestamp_ns / ts_unit_ns == b.timestamp_ns / ts_unit_ns &&
+           sample_float_bits(a.temp) == sample_float_bits(b.temp) &&
+           sample_float_bits(a.raw_ec) == sample_float_bits(b.raw_ec) &&
+           sample_float_bits(a.sensor_ec) == sample_float_bits(b.sensor_ec) &&
+           sample_float_bits(a.smart_ec) == sample_float_bits(b.smart_ec) &&
+           sample_float_bits(a.k) == sample_float_bits(b.k) &&
+           a.flags == b.flags &&
+           memcmp(a.reg_temp, b.reg_temp, sizeof(a.reg_temp)) == 0 &&
+           memcmp(a.reg_raw_ec, b.reg_raw_ec, sizeof(a.reg_raw_ec)) == 0 &&
+           memcmp(a.reg_sensor_ec, b.reg_sensor_ec, sizeof(a.reg_sensor_ec)) == 0;
+}
+
+// ===========================
+// GORILLA
+// ===========================
+inline void selftest_gorilla_roundtrip(SelftestReport &report, std::mt19937_64 &rng) {
+    for (int round = 0; round < SELFTEST_ROUNDTRIP_BLOCKS; round++) {
+        size_t n = 1 + rng() % GORILLA_BLOCK_RECORDS;
+        std::vector<SampleRecord> in = selftest_records(rng, n);
+        GorillaBlockEncoder encoder;
+        encoder.reset();
+        for (const SampleRecord &r : in) encoder.append(r, GORILLA_TS_UNIT_NS);
+
+        const std::vector<uint8_t> &bytes = encoder.stream().bytes();
+        std::vector<SampleRecord> out;
+        bool ok = gorilla_decode_block(bytes.data(), bytes.size(), encoder.count(), GORILLA_TS_UNIT_NS, out) &&
+                  out.size() == n;
+        for (size_t i = 0; ok && i < n; i++) ok = selftest_same(in[i], out[i], GORILLA_TS_UNIT_NS);
+        report.expect(ok, "gorilla round trip of a block of " + std::to_string(n) + " records");
+    }
+}
+
+// Appends records, flushing after random batches the way group commit does
+inline bool selftest_write_gorilla(GorillaLogWriter &writer, const SampleRecord *recs, size_t n,
+                                   std::mt19937_64 &rng) {
+    size_t batch = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (!writer.append(recs[i])) return false;
+        if (batch == 0) batch = 1 + rng() % 64;
+        if (--batch == 0 && !writer.flush()) return false;
+    }
+    return writer.flush();
+}
+
+// Every intact block, in file order; false if a block fails its CRC
+inline bool selftest_read_gorilla(const std::string &path, std::vector<SampleRecord> &out) {
+    out.clear();
+    GorillaLogReader reader;
+    if (!reader.open(path)) return false;
+    for (size_t b = 0; b < reader.blocks().size(); b++) {
+        if (!reader.block_intact(b) || !reader.decode(b, out)) return false;
+    }
+    return true;
+}
+
+// File offsets of the block headers in the bytes of a gorilla log
+inline std::vector<uint64_t> selftest_gorilla_blocks(const std::vector<uint8_t> &file) {
+    std::vector<uint64_t> offsets;
+    uint64_t offset = sizeof(GorillaFileHeader);
+    GorillaBlockHeader bh;
+    while (offset + sizeof(bh) <= file.size()) {
+        memcpy(&bh, file.data() + offset, sizeof(bh));
+        if (bh.magic != GORILLA_BLOCK_MAGIC) break;
+        offsets.push_back(offset);
+        offset += sizeof(bh) + bh.payload_bytes;
+    }
+    return offsets;
+}
+
+// True if path decodes to exactly expected[0, count)
+inline bool selftest_gorilla_holds(const std::string &path, const std::vector<SampleRecord> &expected, size_t count) {
+    std::vector<SampleRecord> got;
+    if (!selftest_read_gorilla(path, got) || got.size() != count) return false;
+    for (size_t i = 0; i < count; i++) {
+        if (!selftest_same(got[i], expected[i], GORILLA_TS_UNIT_NS)) return false;
+    }
+    return true;
+}
+
+// Reopen a damaged copy of a log and append extra. The log must keep the
+// committed bytes before keep unchanged (of a last byte the flush left
+// partial, the tail_bits in use) and hold extra in a new block at keep.
+// Comparing bytes instead of decoding keeps thousands of cuts fast; the
+// committed log itself was decoded once by the caller.
+inline bool selftest_gorilla_recovers(const std::string &path, const std::vector<uint8_t> &committed,
+                                      size_t keep, uint32_t tail_bits, const SampleRecord &extra) {
+    {
+        SelftestQuietCerr quiet;
+        GorillaLogWriter writer;
+        if (!writer.open(path) || !writer.append(extra) || !writer.flush()) return false;
+    }
+    std::vector<uint8_t> file;
+    if (!selftest_read_file(path, file) || file.size() < keep) return false;
+    size_t exact = tail_bits ? keep - 1 : keep;
+    if (memcmp(file.data(), committed.data(), exact) != 0) return false;
+    if (tail_bits && ((file[exact] ^ committed[exact]) & (0xFF << (8 - tail_bits)) & 0xFF)) return false;
+
+    std::vector<uint64_t> blocks = selftest_gorilla_blocks(file);
+    if (blocks.empty() || blocks.back() != keep) return false;
+
+    GorillaLogReader reader;
+    std::vector<SampleRecord> got;
+    if (!reader.open(path) || reader.blocks().size() != blocks.size()) return false;
+    size_t last = blocks.size() - 1;
+    return reader.block_intact(last) && reader.decode(last, got) &&
+           got.size() == 1 && selftest_same(got[0], extra, GORILLA_TS_UNIT_NS);
+}
+
+// One full block and a partial one, cut at every byte of the partial one
+inline void selftest_gorilla_truncation(SelftestReport &report, SelftestDir &dir, std::mt19937_64 &rng) {
+    std::string path = dir.path("cut.ecg");
+    std::vector<SampleRecord> recs = selftest_records(rng, GORILLA_BLOCK_RECORDS + SELFTEST_TAIL_RECORDS + 1);
+    SampleRecord extra = recs.back();
+    recs.pop_back();
+    {
+        GorillaLogWriter writer;
+        if (!report.expect(writer.open(path) && selftest_write_gorilla(writer, recs.data(), recs.size(), rng),
+                           "gorilla log written")) return;
+    }
+    if (!report.expect(selftest_gorilla_holds(path, recs, recs.size()), "gorilla log reads back")) return;
+
+    std::vector<uint8_t> full;
+    std::vector<uint64_t> blocks;
+    if (!report.expect(selftest_read_file(path, full) && (blocks = selftest_gorilla_blocks(full)).size() == 2,
+                       "gorilla log holds two blocks")) return;
+    uint64_t last_block = blocks[1];
+
+    for (size_t len = last_block; len < full.size(); len++) {
+        bool ok = selftest_write_file(path, full.data(), len) &&
+                  selftest_gorilla_recovers(path, full, last_block, 0, extra);
+        report.expect(ok, "gorilla log cut at byte " + std::to_string(len) + " of " +
+                          std::to_string(full.size()) + " keeps the first block");
+    }
+}
+
+// A flush writes new payload bytes from the last partial byte on, then the
+// block header. Crash after any number of those payload bytes: the header
+// of the flush before must still cover an intact prefix.
+inline void selftest_gorilla_torn_flush(SelftestReport &report, SelftestDir &dir, std::mt19937_64 &rng) {
+    std::string path = dir.path("torn.ecg");
+    for (int round = 0; round < SELFTEST_TORN_FLUSHES; round++) {
+        // Half the rounds tear a flush inside the second block
+        size_t before = (round % 2 ? GORILLA_BLOCK_RECORDS : 0) + 1 + rng() % (GORILLA_BLOCK_RECORDS - 64);
+        size_t more = 1 + rng() % 48;
+        std::vector<SampleRecord> recs = selftest_records(rng, before + more + 1);
+        SampleRecord extra = recs.back();
+
+        std::vector<uint8_t> committed, torn;
+        {
+            unlink(path.c_str());
+            GorillaLogWriter writer;
+            bool ok = writer.open(path) && selftest_write_gorilla(writer, recs.data(), before, rng) &&
+                      selftest_read_file(path, committed) && selftest_gorilla_holds(path, recs, before);
+            for (size_t i = before; ok && i < before + more; i++) ok = writer.append(recs[i]);
+            ok = ok && writer.flush() && selftest_read_file(path, torn);
+            if (!report.expect(ok, "gorilla log written for torn flush " + std::to_string(round))) continue;
+        }
+
+        // The flush rewrote the partial byte of the committed payload
+        std::vector<uint64_t> blocks = selftest_gorilla_blocks(committed);
+        if (!report.expect(!blocks.empty(), "gorilla log holds a block")) continue;
+        GorillaBlockHeader bh;
+        memcpy(&bh, committed.data() + blocks.back(), sizeof(bh));
+        size_t start = committed.size() - (bh.tail_bits ? 1 : 0);
+
+        for (size_t n = 0; start + n <= torn.size(); n++) {
+            std::vector<uint8_t> crashed = committed;
+            if (crashed.size() < start + n) crashed.resize(start + n);
+            memcpy(crashed.data() + start, torn.data() + start, n);
+            bool ok = selftest_write_file(path, crashed.data(), crashed.size()) &&
+                      selftest_gorilla_recovers(path, committed, committed.size(), bh.tail_bits, extra);
+            report.expect(ok, "gorilla flush of " + std::to_string(before) + "+" + std::to_string(more) +
+                              " records torn after " + std::to_string(n) + " payload byte(s) keeps " +
+                              std::to_string(before));
+        }
+    }
+}
+
+// ===========================
+// WAL
+// ===========================
+inline void selftest_wal_roundtrip(SelftestReport &report, std::mt19937_64 &rng) {
+    std::vector<SampleRecord> in = selftest_records(rng, SELFTEST_WAL_RECORDS);
+    bool ok = true;
+    for (size_t i = 0; ok && i < in.size(); i++) {
+        uint8_t payload[WAL_SAMPLE_PAYLOAD];
+        SampleRecord out;
+        memset(&out, 0, sizeof(out));
+        wal_encode_sample(in[i], payload);
+        wal_decode_sample(payload, &out);
+        ok = selftest_same(in[i], out, 1);
+    }
+    report.expect(ok, "WAL sample round trip");
+}
+
+// Every intact sample in file order
+inline bool selftest_read_wal(const std::string &path, std::vector<SampleRecord> &out,
+                              std::vector<uint64_t> *ends, WalScanStats *stats) {
+    out.clear();
+    WalLogReader reader;
+    if (!reader.open(path)) return false;
+    *stats = reader.visit(0, UINT64_MAX, [&](const SampleRecord &rec, uint64_t offset) {
+        out.push_back(rec);
+        if (ends) ends->push_back(offset + sizeof(WalRecordHeader) + WAL_SAMPLE_PAYLOAD);
+    });
+    return true;
+}
+
+// A WAL larger than the recovery window, cut inside its header and at
+// every byte of its last group commit. Reopening must cut exactly the
+// torn bytes, leave nothing damaged in front of new appends, and keep
+// every sample that was complete.
+inline void selftest_wal_truncation(SelftestReport &report, SelftestDir &dir, std::mt19937_64 &rng) {
+    std::string path = dir.path("cut.ecw");
+    std::vector<SampleRecord> recs = selftest_records(rng, SELFTEST_WAL_RECORDS + 1);
+    SampleRecord extra = recs.back();
+    recs.pop_back();
+
+    uint64_t last_commit = 0;
+    {
+        WalLogWriter writer;
+        bool ok = writer.open(path);
+        size_t tail = recs.size() - SELFTEST_WAL_TAIL_RECORDS;
+        for (size_t i = 0, batch = 0; ok && i < tail; i++) {
+            writer.append(recs[i]);
+            if (batch == 0) batch = 1 + rng() % 64;
+            if (--batch == 0) ok = writer.flush();
+        }
+        ok = ok && writer.flush();
+        uint32_t skip;
+        writer.next_position(&last_commit, &skip);
+        for (size_t i = tail; ok && i < recs.size(); i++) writer.append(recs[i]);
+        if (!report.expect(ok && writer.flush(), "WAL written")) return;
+    }
+
+    std::vector<uint8_t> full;
+    std::vector<SampleRecord> got;
+    std::vector<uint64_t> ends;
+    WalScanStats stats;
+    bool ok = selftest_read_file(path, full) && selftest_read_wal(path, got, &ends, &stats) &&
+              got.size() == recs.size() && stats.sessions == 1 && stats.skipped_bytes == 0 &&
+              full.size() > WAL_TAIL_SCAN_BYTES;
+    for (size_t i = 0; ok && i < got.size(); i++) ok = selftest_same(got[i], recs[i], 1);
+    if (!report.expect(ok, "WAL reads back")) return;
+    uint64_t session_end = ends.front() - sizeof(WalRecordHeader) - WAL_SAMPLE_PAYLOAD;
+
+    std::vector<uint64_t> cuts;
+    for (uint64_t len = 0; len < sizeof(WalFileHeader); len++) cuts.push_back(len);
+    for (uint64_t len = last_commit; len <= full.size(); len++) cuts.push_back(len);
+
+    for (uint64_t len : cuts) {
+        // Samples complete before the cut, and where the last intact record ends
+        size_t intact = 0;
+        while (intact < ends.size() && ends[intact] <= len) intact++;
+        uint64_t keep = intact ? ends[intact - 1] : session_end;
+        bool fresh = len < sizeof(WalFileHeader);
+
+        uint64_t torn = 0;
+        ok = selftest_write_file(path, full.data(), len);
+        if (ok) {
+            SelftestQuietCerr quiet;
+            WalLogWriter writer;
+            ok = writer.open(path);
+            torn = writer.torn_bytes();
+            writer.append(extra);
+            ok = ok && writer.flush();
+        }
+        ok = ok && selftest_read_wal(path, got, nullptr, &stats) && got.size() == intact + 1 &&
+             stats.skipped_bytes == 0 && stats.sessions == (fresh ? 1u : 2u) &&
+             torn == (fresh ? 0 : len - keep);
+        for (size_t i = 0; ok && i < intact; i++) ok = selftest_same(got[i], recs[i], 1);
+        ok = ok && selftest_same(got[intact], extra, 1);
+        report.expect(ok, "WAL cut at byte " + std::to_string(len) + " of " + std::to_string(full.size()) +
+                          " keeps " + std::to_string(intact) + " samples");
+    }
+}
+
+// ===========================
+// RUN
+// ===========================
+// Returns the process exit status: 0 if every check passed
+inline int run_log_selftest() {
+    SelftestDir dir;
+    if (!dir.create()) return 1;
+    std::mt19937_64 rng(SELFTEST_SEED);
+    SelftestReport report;
+
+    selftest_gorilla_roundtrip(report, rng);
+    selftest_gorilla_truncation(report, dir, rng);
+    selftest_gorilla_torn_flush(report, dir, rng);
+    selftest_wal_roundtrip(report, rng);
+    selftest_wal_truncation(report, dir, rng);
+
+    if (report.failures() > 0) {
+        std::cerr << "❌ selftest: " << report.failures() << " of " << report.checks() << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "✅ selftest: all " << report.checks() << " checks passed" << std::endl;
+    return 0;
+}
+
+#endif // EC_LOG_SELFTEST_H
@@ -0,0 +1,1171 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <ctime>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <thread>
+#include <zlib.h>
+
+#include "ec_sample.h"
+#include "ec_binlog.h"
+#include "ec_csv.h"
+#include "ec_gorilla.h"
+#include "ec_csv_ingest.h"
+#include "ec_log_index.h"
+#include "ec_rollup.h"
+#include "ec_async_log.h"
+#include "ec_log_manifest.h"
+#include "ec_flight_recorder.h"
+#include "ec_chart.h"
+#include "ec_log_selftest.h"
+
+// ===========================
+// EC LOG TOOL
+// ===========================
+// Offline companion to smart_logger for working with its log files.
+//
+//   ./ec_log_tool info   ec_data_log.ecb
+//   ./ec_log_tool to-csv ec_data_log.ecg [out.csv] [-j THREADS]
+//   ./ec_log_tool ingest ec_data_log.csv clean.ecb [-j THREADS]
+//   ./ec_log_tool query  ec_data_log.csv --from "2026-01-14 22:00:00" --to "2026-01-15 06:00:00"
+//   ./ec_log_tool rollup ec_data_log.csv.1h.ecr --from 2026-01-14
+//   ./ec_log_tool segments ec_data_log.csv --temp-min 30 | xargs -P 8 -n 1 ...
+//   ./ec_log_tool flight ec_flight.ring incident.ecb --from "2026-01-14 22:00:00"
+//   ./ec_log_tool plot   ec_data_log.csv [OUT_DIR] [--points N]
+//   ./ec_log_tool selftest
+//
+// Compile:
+//   g++ -O2 -pthread -o ec_log_tool ec_log_tool.cpp -lz
+
+enum LogKind {
+    LOG_KIND_UNKNOWN = 0,
+    LOG_KIND_BINARY = 1,      // .ecb columnar blocks
+    LOG_KIND_GORILLA = 2,     // .ecg compressed blocks
+    LOG_KIND_CSV = 3,         // .csv text (by extension)
+    LOG_KIND_WAL = 4          // .ecw write-ahead log
+};
+
+// Query filter; every bound is inclusive
+struct QueryFilter {
+    int64_t from_ns = std::numeric_limits<int64_t>::min();
+    int64_t to_ns = std::numeric_limits<int64_t>::max();
+    float temp_min = -std::numeric_limits<float>::infinity();
+    float temp_max = std::numeric_limits<float>::infinity();
+    float ec_min = -std::numeric_limits<float>::infinity();     // Smart_Calc_EC
+    float ec_max = std::numeric_limits<float>::infinity();
+};
+
+struct ToolOptions {
+    unsigned jobs = 0;        // Worker threads, 0 = all cores
+    QueryFilter filter;
+    std::string output;       // query: write rows here instead of stdout
+    bool count_only = false;  // query: print only the number of matches
+    size_t plot_points = CHART_DEFAULT_POINTS;   // plot: LTTB points per curve
+    double standard_ec = CSV_STANDARD_EC;   // build-rollups: EC reference of the error sums
+    bool unindexed = false;   // query: input has no index (decompressed LOG.gz), scan it whole
+};
+
+const size_t INGEST_CHUNK_BYTES = 16 * 1024 * 1024;   // CSV bytes parsed per task
+const uint64_t LOG_END = std::numeric_limits<uint64_t>::max();   // Scan to end of file
+
+// ===========================
+// LOG DETECTION
+// ===========================
+bool has_suffix(const std::string &s, const std::string &suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+LogKind detect_log_kind(const std::string &path) {
+    char magic[8] = {0};
+    std::ifstream in(path, std::ios::binary);
+    in.read(magic, sizeof(magic));
+    if (memcmp(magic, BINLOG_MAGIC, sizeof(magic)) == 0) return LOG_KIND_BINARY;
+    if (memcmp(magic, GORILLA_MAGIC, sizeof(magic)) == 0) return LOG_KIND_GORILLA;
+    if (memcmp(magic, WAL_MAGIC, sizeof(magic)) == 0) return LOG_KIND_WAL;
+    if (has_suffix(path, ".csv")) return LOG_KIND_CSV;
+    return LOG_KIND_UNKNOWN;
+}
+
+// The LogFormat smart_logger records in the index header
+LogFormat log_kind_format(LogKind kind) {
+    switch (kind) {
+        case LOG_KIND_BINARY:  return LOG_FORMAT_BINARY;
+        case LOG_KIND_GORILLA: return LOG_FORMAT_GORILLA;
+        case LOG_KIND_WAL:     return LOG_FORMAT_WAL;
+        default:               return LOG_FORMAT_CSV;
+    }
+}
+
+unsigned resolve_jobs(const ToolOptions &opts) {
+    if (opts.jobs > 0) return opts.jobs;
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw > 0 ? hw : 1;
+}
+
+bool binlog_has_crc(const BinaryLogReader &reader) {
+    return reader.block_count() > 0 && reader.block(0).crc32 != nullptr;
+}
+
+// ===========================
+// RECORD STREAMING
+// ===========================
+// Calls fn with consecutive batches of records in file order. Gorilla
+// blocks are decoded by a pool of threads, a window at a time, so memory
+// stays bounded on multi-gigabyte logs. Records that fail their CRC are
+// skipped and counted in *skipped.
+typedef std::function<void(const SampleRecord *, size_t)> RecordBatchFn;
+
+bool visit_binary_log(const std::string &path, const RecordBatchFn &fn, uint64_t *skipped) {
+    BinaryLogReader reader;
+    if (!reader.open(path)) return false;
+
+    std::vector<SampleRecord> batch;
+    for (size_t b = 0; b < reader.block_count(); b++) {
+        BinlogBlockView blk = reader.block(b);
+        batch.clear();
+        for (uint32_t i = 0; i < blk.count; i++) {
+            if (!blk.record_valid(i)) {
+                (*skipped)++;
+                continue;
+            }
+            batch.push_back(blk.record(i));
+        }
+        if (!batch.empty()) fn(batch.data(), batch.size());
+    }
+    return true;
+}
+
+bool visit_gorilla_log(const std::string &path, unsigned jobs, const RecordBatchFn &fn,
+                       uint64_t *skipped) {
+    GorillaLogReader reader;
+    if (!reader.open(path)) return false;
+
+    const std::vector<GorillaBlockRef> &blocks = reader.blocks();
+    size_t window = jobs * 4;
+    std::vector<std::vector<SampleRecord> > decoded(window);
+    std::vector<char> ok(window);
+
+    for (size_t base = 0; base < blocks.size(); base += window) {
+        size_t n = std::min(window, blocks.size() - base);
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < jobs && t < n; t++) {
+            workers.emplace_back([&, t]() {
+                for (size_t i = t; i < n; i += jobs) {
+                    decoded[i].clear();
+                    ok[i] = reader.block_intact(base + i) && reader.decode(base + i, decoded[i]);
+                }
+            });
+        }
+        for (auto &w : workers) w.join();
+
+        for (size_t i = 0; i < n; i++) {
+            if (!ok[i]) {
+                *skipped += blocks[base + i].header.count;
+                continue;
+            }
+            fn(decoded[i].data(), decoded[i].size());
+        }
+    }
+    return true;
+}
+
+// Damaged regions of a WAL are counted in bytes, not records
+bool visit_wal_log(const std::string &path, const RecordBatchFn &fn, uint64_t *skipped_bytes) {
+    WalLogReader reader;
+    if (!reader.open(path)) return false;
+
+    std::vector<SampleRecord> batch;
+    batch.reserve(LOG_BATCH_MAX);
+    WalScanStats stats = reader.visit(0, LOG_END, [&](const SampleRecord &rec, uint64_t) {
+        batch.push_back(rec);
+        if (batch.size() == LOG_BATCH_MAX) {
+            fn(batch.data(), batch.size());
+            batch.clear();
+        }
+    });
+    if (!batch.empty()) fn(batch.data(), batch.size());
+    *skipped_bytes += stats.skipped_bytes;
+    return true;
+}
+
+bool visit_log(const std::string &path, const ToolOptions &opts, const RecordBatchFn &fn,
+               uint64_t *skipped) {
+    switch (detect_log_kind(path)) {
+        case LOG_KIND_BINARY:
+            return visit_binary_log(path, fn, skipped);
+        case LOG_KIND_GORILLA:
+            return visit_gorilla_log(path, resolve_jobs(opts), fn, skipped);
+        case LOG_KIND_WAL:
+            return visit_wal_log(path, fn, skipped);
+        default:
+            std::cerr << "❌ " << path << ": unrecognized log format" << std::endl;
+            return false;
+    }
+}
+
+// ===========================
+// COMMAND: INFO
+// ===========================
+int info_binary(const std::string &path) {
+    BinaryLogReader reader;
+    if (!reader.open(path)) return 1;
+
+    const BinlogFileHeader &hdr = reader.header();
+    uint64_t records = 0, corrupt = 0;
+    int64_t first_ts = 0, last_ts = 0;
+
+    for (size_t b = 0; b < reader.block_count(); b++) {
+        BinlogBlockView blk = reader.block(b);
+        if (blk.count == 0) continue;
+        if (records == 0) first_ts = blk.timestamp_ns[0];
+        last_ts = blk.timestamp_ns[blk.count - 1];
+        records += blk.count;
+        for (uint32_t i = 0; i < blk.count; i++) {
+            if (!blk.record_valid(i)) corrupt++;
+        }
+    }
+
+    std::cout << "  File:          " << path << " (binary columnar)\n";
+    std::cout << "  Version:       " << hdr.version << "\n";
+    std::cout << "  Columns:       " << hdr.column_count << "\n";
+    std::cout << "  Block size:    " << hdr.block_size << " bytes (" << hdr.block_capacity << " records)\n";
+    std::cout << "  Blocks:        " << reader.block_count() << "\n";
+    std::cout << "  Records:       " << records << "\n";
+    std::cout << "  CRC failures:  " << (binlog_has_crc(reader) ? std::to_string(corrupt) : "n/a (version 1)") << "\n";
+    if (records > 0) {
+        std::cout << "  First sample:  " << format_timestamp_ns(first_ts) << "\n";
+        std::cout << "  Last sample:   " << format_timestamp_ns(last_ts) << "\n";
+    }
+    return 0;
+}
+
+int info_gorilla(const std::string &path, const ToolOptions &opts) {
+    GorillaLogReader reader;
+    if (!reader.open(path)) return 1;
+
+    const std::vector<GorillaBlockRef> &blocks = reader.blocks();
+    uint64_t records = 0;
+    for (const GorillaBlockRef &ref : blocks) records += ref.header.count;
+
+    // Full parallel decode doubles as an integrity check and a speed test
+    uint64_t decoded = 0, skipped = 0;
+    auto start = std::chrono::steady_clock::now();
+    visit_gorilla_log(path, resolve_jobs(opts),
+                      [&](const SampleRecord *, size_t n) { decoded += n; }, &skipped);
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double raw_mb = decoded * sizeof(SampleRecord) / 1e6;
+
+    std::cout << "  File:          " << path << " (gorilla compressed)\n";
+    std::cout << "  Version:       " << reader.header().version << "\n";
+    std::cout << "  Blocks:        " << blocks.size() << " (up to " << reader.header().block_records << " records)\n";
+    std::cout << "  Records:       " << records << "\n";
+    std::cout << "  CRC failures:  " << skipped << " record(s)\n";
+    if (records > 0) {
+        std::cout << "  Bytes/record:  " << std::fixed << std::setprecision(2)
+                  << static_cast<double>(reader.file_size()) / records << "\n";
+        std::cout << "  First sample:  " << format_timestamp_ns(blocks.front().header.first_timestamp_ns) << "\n";
+        std::cout << "  Last sample:   " << format_timestamp_ns(blocks.back().header.last_timestamp_ns) << "\n";
+        std::cout << "  Decode:        " << std::setprecision(1) << raw_mb / (secs > 0 ? secs : 1e-9)
+                  << " MB/s (" << resolve_jobs(opts) << " threads)\n";
+    }
+    return 0;
+}
+
+int info_wal(const std::string &path) {
+    WalLogReader reader;
+    if (!reader.open(path)) return 1;
+
+    const WalFileHeader &hdr = reader.header();
+    int64_t first_ts = 0, last_ts = 0;
+    WalScanStats stats = reader.visit(0, LOG_END, [&](const SampleRecord &rec, uint64_t) {
+        if (first_ts == 0) first_ts = rec.timestamp_ns;
+        last_ts = rec.timestamp_ns;
+    });
+
+    char session[17];
+    snprintf(session, sizeof(session), "%016llx", static_cast<unsigned long long>(hdr.session_id));
+    std::cout << "  File:          " << path << " (write-ahead log)\n";
+    std::cout << "  Version:       " << hdr.version << " (schema " << hdr.schema_version << ")\n";
+    std::cout << "  Created:       " << format_timestamp_ns(hdr.created_ns) << " by session " << session << "\n";
+    std::cout << "  Sessions:      " << stats.sessions << "\n";
+    std::cout << "  Records:       " << stats.samples << "\n";
+    std::cout << "  Damaged bytes: " << stats.skipped_bytes << "\n";
+    if (stats.samples > 0) {
+        std::cout << "  First sample:  " << format_timestamp_ns(first_ts) << "\n";
+        std::cout << "  Last sample:   " << format_timestamp_ns(last_ts) << "\n";
+    }
+    return 0;
+}
+
+int cmd_info(const std::string &path, const ToolOptions &opts) {
+    switch (detect_log_kind(path)) {
+        case LOG_KIND_BINARY:  return info_binary(path);
+        case LOG_KIND_GORILLA: return info_gorilla(path, opts);
+        case LOG_KIND_WAL:     return info_wal(path);
+        case LOG_KIND_CSV:
+            std::cerr << "❌ " << path << " is a CSV log; use ingest or query" << std::endl;
+            return 1;
+        default:
+            std::cerr << "❌ " << path << ": unrecognized log format" << std::endl;
+            return 1;
+    }
+}
+
+// ===========================
+// COMMAND: TO-CSV
+// ===========================
+// Writes the same 8-column layout smart_logger's CSV sink uses, so
+// plot_data.py works unchanged on converted binary logs.
+int cmd_to_csv(const std::string &path, const std::string &out_path, const ToolOptions &opts) {
+    std::ofstream out(out_path);
+    if (!out) {
+        std::cerr << "❌ Cannot create " << out_path << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    out << CSV_LOG_HEADER;
+
+    uint64_t rows = 0, skipped = 0;
+    TimestampFormatter ts_format;
+    bool ok = visit_log(path, opts, [&](const SampleRecord *recs, size_t n) {
+        for (size_t i = 0; i < n; i++) write_sample_csv_row(out, recs[i], ts_format);
+        rows += n;
+    }, &skipped);
+    if (!ok) return 1;
+
+    if (skipped > 0) {
+        std::cerr << "⚠️  Skipped " << skipped
+                  << (detect_log_kind(path) == LOG_KIND_WAL ? " damaged byte(s)" : " record(s) with a bad CRC")
+                  << std::endl;
+    }
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "✅ Wrote " << rows << " rows to " << out_path
+              << " in " << std::fixed << std::setprecision(2) << secs << " s" << std::endl;
+    return 0;
+}
+
+// ===========================
+// COMMAND: INGEST
+// ===========================
+// Cleans a CSV log of any schema mix (successor of fix_csv.py). The input is
+// mmap'ed and parsed a window of chunks at a time, one chunk per thread;
+// results are written in file order. The output format follows the
+// extension: .ecb binary, .ecg gorilla, anything else 8-column CSV.
+// Rejected rows go to OUT.rejected.csv with line number and reason.
+bool write_rejection_report(const std::string &path, const std::vector<CsvRejection> &rejections) {
+    std::ofstream rep(path);
+    if (!rep) {
+        std::cerr << "❌ Cannot create " << path << std::endl;
+        return false;
+    }
+    rep << "Line,Reason,Text\n";
+    for (const CsvRejection &r : rejections) {
+        std::string quoted;
+        for (char c : r.text) {
+            if (c == '"') quoted += '"';
+            quoted += c;
+        }
+        rep << r.line << "," << csv_reject_reason_name(r.reason) << ",\"" << quoted << "\"\n";
+    }
+    return true;
+}
+
+int cmd_ingest(const std::string &path, const std::string &out_path, const ToolOptions &opts) {
+    LogKind out_kind = has_suffix(out_path, ".ecb") ? LOG_KIND_BINARY
+                     : has_suffix(out_path, ".ecg") ? LOG_KIND_GORILLA : LOG_KIND_UNKNOWN;
+    bool emit_csv = (out_kind == LOG_KIND_UNKNOWN);
+
+    MappedFile in;
+    if (!in.open(path)) return 1;
+
+    // Start from an empty output; the log writers would otherwise append
+    unlink(out_path.c_str());
+    std::ofstream csv_out;
+    BinaryLogWriter binary_out;
+    GorillaLogWriter gorilla_out;
+    bool opened = emit_csv ? static_cast<bool>((csv_out.open(out_path, std::ios::binary), csv_out))
+                : out_kind == LOG_KIND_BINARY ? binary_out.open(out_path) : gorilla_out.open(out_path);
+    if (!opened) {
+        std::cerr << "❌ Cannot create " << out_path << std::endl;
+        return 1;
+    }
+    if (emit_csv) csv_out << CSV_LOG_HEADER;
+
+    auto start = std::chrono::steady_clock::now();
+    unsigned jobs = resolve_jobs(opts);
+    std::vector<std::pair<size_t, size_t> > chunks =
+        csv_split_chunks(in.data(), in.size(), INGEST_CHUNK_BYTES);
+
+    size_t window = jobs * 4;
+    std::vector<CsvChunkResult> results(window);
+    std::vector<CsvSegment> segments;
+    std::vector<CsvRejection> rejections;
+    uint64_t reject_counts[CSV_REJECT_REASON_COUNT] = {0};
+    uint64_t lines = 0, headers = 0, rows = 0;
+
+    for (size_t base = 0; base < chunks.size(); base += window) {
+        size_t n = std::min(window, chunks.size() - base);
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < jobs && t < n; t++) {
+            workers.emplace_back([&, t]() {
+                for (size_t i = t; i < n; i += jobs) {
+                    results[i] = CsvChunkResult();
+                    csv_ingest_chunk(in.data() + chunks[base + i].first,
+                                     in.data() + chunks[base + i].second, emit_csv, results[i]);
+                }
+            });
+        }
+        for (auto &w : workers) w.join();
+
+        for (size_t i = 0; i < n; i++) {
+            CsvChunkResult &res = results[i];
+            csv_merge_chunk(res, lines, segments, rejections, reject_counts);
+            lines += res.lines;
+            headers += res.header_lines;
+            if (emit_csv) {
+                csv_out.write(res.csv_text.data(), res.csv_text.size());
+            } else {
+                for (const SampleRecord &rec : res.records) {
+                    if (out_kind == LOG_KIND_BINARY) binary_out.append(rec);
+                    else gorilla_out.append(rec);
+                }
+            }
+        }
+    }
+    for (const CsvSegment &seg : segments) rows += seg.rows;
+
+    bool ok;
+    if (emit_csv) {
+        csv_out.close();
+        ok = !csv_out.fail();
+    } else if (out_kind == LOG_KIND_BINARY) {
+        ok = binary_out.flush();
+        binary_out.close();
+    } else {
+        ok = gorilla_out.flush();
+        gorilla_out.close();
+    }
+    if (!ok) {
+        std::cerr << "❌ Failed writing " << out_path << std::endl;
+        return 1;
+    }
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "✅ Ingested " << rows << " rows from " << path << " into " << out_path << "\n";
+    std::cout << "   " << lines << " lines (" << headers << " header), "
+              << std::fixed << std::setprecision(1) << in.size() / 1e6 << " MB in "
+              << std::setprecision(2) << secs << " s ("
+              << std::setprecision(1) << in.size() / 1e6 / (secs > 0 ? secs : 1e-9) << " MB/s, "
+              << jobs << " threads)\n";
+
+    std::cout << "   Segments:\n";
+    const size_t MAX_SEGMENTS_SHOWN = 20;
+    for (size_t i = 0; i < segments.size() && i < MAX_SEGMENTS_SHOWN; i++) {
+        std::cout << "     line " << std::setw(10) << segments[i].first_line << "  "
+                  << std::left << std::setw(18) << csv_schema_name(segments[i].schema) << std::right
+                  << segments[i].rows << " rows" << (segments[i].has_header ? " (header)" : "") << "\n";
+    }
+    if (segments.size() > MAX_SEGMENTS_SHOWN) {
+        std::cout << "     ... " << segments.size() - MAX_SEGMENTS_SHOWN << " more\n";
+    }
+
+    if (!rejections.empty()) {
+        std::string report = out_path + ".rejected.csv";
+        std::cerr << "⚠️  Rejected " << rejections.size() << " row(s):";
+        for (int r = 0; r < CSV_REJECT_REASON_COUNT; r++) {
+            if (reject_counts[r]) {
+                std::cerr << " " << csv_reject_reason_name(static_cast<CsvRejectReason>(r))
+                          << "=" << reject_counts[r];
+            }
+        }
+        std::cerr << std::endl;
+        if (!write_rejection_report(report, rejections)) return 1;
+        std::cerr << "   Details in " << report << std::endl;
+    }
+    return 0;
+}
+
+// ===========================
+// POSITIONED RECORD SCANS
+// ===========================
+// Visit the records stored between two log positions (see ec_log_index.h),
+// handing each one to fn together with its own position. end_offset =
+// UINT64_MAX scans to the end of the log. Records failing their CRC are
+// skipped.
+typedef std::function<void(const SampleRecord &, uint64_t, uint32_t)> PositionedRecordFn;
+
+void scan_csv_range(const MappedFile &log, uint64_t begin, uint64_t end, const PositionedRecordFn &fn) {
+    CsvTimeCache cache;
+    SampleRecord rec;
+    CsvSchema schema;
+    bool is_header;
+    CsvRejectReason reason;
+    const char *data = log.data();
+    size_t stop = end < log.size() ? end : log.size();
+    size_t p = begin;
+    while (p < stop) {
+        const char *nl = static_cast<const char *>(memchr(data + p, '\n', log.size() - p));
+        size_t line_end = nl ? static_cast<size_t>(nl - data) : log.size();
+        if (csv_parse_line(data + p, data + line_end, cache, &rec, &schema, &is_header, &reason)) {
+            fn(rec, p, 0);
+        }
+        p = line_end + 1;
+    }
+}
+
+void scan_binary_range(const BinaryLogReader &log, uint64_t begin, uint32_t begin_skip,
+                       uint64_t end, uint32_t end_skip, const PositionedRecordFn &fn) {
+    const BinlogFileHeader &hdr = log.header();
+    size_t b = begin > hdr.header_size ? (begin - hdr.header_size) / hdr.block_size : 0;
+    for (; b < log.block_count(); b++) {
+        uint64_t offset = hdr.header_size + static_cast<uint64_t>(b) * hdr.block_size;
+        BinlogBlockView blk = log.block(b);
+        for (uint32_t i = (offset == begin ? begin_skip : 0); i < blk.count; i++) {
+            if (!log_position_before(offset, i, end, end_skip)) return;
+            if (blk.record_valid(i)) fn(blk.record(i), offset, i);
+        }
+    }
+}
+
+void scan_gorilla_range(const GorillaLogReader &log, uint64_t begin, uint32_t begin_skip,
+                        uint64_t end, uint32_t end_skip, const PositionedRecordFn &fn) {
+    const std::vector<GorillaBlockRef> &blocks = log.blocks();
+    size_t lo = 0, hi = blocks.size();
+    while (lo < hi) {   // First block at or after begin
+        size_t mid = (lo + hi) / 2;
+        if (log.block_offset(mid) < begin) lo = mid + 1; else hi = mid;
+    }
+    std::vector<SampleRecord> decoded;
+    for (size_t b = lo; b < blocks.size(); b++) {
+        uint64_t offset = log.block_offset(b);
+        if (!log_position_before(offset, 0, end, end_skip)) return;
+        decoded.clear();
+        if (!log.block_intact(b) || !log.decode(b, decoded)) continue;
+        for (uint32_t i = (offset == begin ? begin_skip : 0); i < decoded.size(); i++) {
+            if (!log_position_before(offset, i, end, end_skip)) return;
+            fn(decoded[i], offset, i);
+        }
+    }
+}
+
+void scan_wal_range(const WalLogReader &log, uint64_t begin, uint64_t end, const PositionedRecordFn &fn) {
+    log.visit(begin, end, [&](const SampleRecord &rec, uint64_t offset) { fn(rec, offset, 0); });
+}
+
+// One opened log of any kind, scannable by position
+struct PositionedLog {
+    LogKind kind = LOG_KIND_UNKNOWN;
+    MappedFile csv;
+    BinaryLogReader binary;
+    GorillaLogReader gorilla;
+    WalLogReader wal;
+
+    bool open(const std::string &path) {
+        kind = detect_log_kind(path);
+        switch (kind) {
+            case LOG_KIND_CSV:     return csv.open(path);
+            case LOG_KIND_BINARY:  return binary.open(path);
+            case LOG_KIND_GORILLA: return gorilla.open(path);
+            case LOG_KIND_WAL:     return wal.open(path);
+            default:
+                std::cerr << "❌ " << path << ": unrecognized log format" << std::endl;
+                return false;
+        }
+    }
+
+    void scan(uint64_t begin, uint32_t begin_skip, uint64_t end, uint32_t end_skip,
+              const PositionedRecordFn &fn) const {
+        switch (kind) {
+            case LOG_KIND_CSV:     scan_csv_range(csv, begin, end, fn); break;
+            case LOG_KIND_BINARY:  scan_binary_range(binary, begin, begin_skip, end, end_skip, fn); break;
+            case LOG_KIND_GORILLA: scan_gorilla_range(gorilla, begin, begin_skip, end, end_skip, fn); break;
+            case LOG_KIND_WAL:     scan_wal_range(wal, begin, end, fn); break;
+            default: break;
+        }
+    }
+};
+
+// ===========================
+// COMMAND: INDEX
+// ===========================
+// (Re)builds LOG.idx for logs written without one. smart_logger keeps the
+// index up to date by itself from then on.
+int cmd_index(const std::string &path) {
+    PositionedLog log;
+    if (!log.open(path)) return 1;
+
+    auto start = std::chrono::steady_clock::now();
+    std::string idx_path = log_index_path(path);
+    unlink(idx_path.c_str());
+    LogIndexWriter index;
+    if (!index.open(idx_path, log_kind_format(log.kind), false, 0, 0)) return 1;
+
+    uint64_t records = 0;
+    log.scan(0, 0, LOG_END, 0, [&](const SampleRecord &rec, uint64_t offset, uint32_t skip) {
+        index.add(rec, offset, skip);
+        records++;
+    });
+    bool ok = index.flush();
+    index.close();
+    if (!ok) return 1;
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "✅ Indexed " << records << " records into " << idx_path << " ("
+              << (records + LOG_INDEX_INTERVAL - 1) / LOG_INDEX_INTERVAL << " entries) in "
+              << std::fixed << std::setprecision(2) << secs << " s" << std::endl;
+    return 0;
+}
+
+// ===========================
+// COMMAND: QUERY
+// ===========================
+// Binary-searches the index for the first entry that can reach --from,
+// skips entries whose value ranges miss the filter, and decodes only the
+// rest. The last entry is open-ended (the index may lag the log), so it is
+// always scanned to the end of the file.
+bool entry_may_match(const LogIndexEntry &e, const QueryFilter &f) {
+    return e.first_timestamp_ns <= f.to_ns && e.last_timestamp_ns >= f.from_ns &&
+           e.max_temp >= f.temp_min && e.min_temp <= f.temp_max &&
+           e.max_smart_ec >= f.ec_min && e.min_smart_ec <= f.ec_max;
+}
+
+bool record_matches(const SampleRecord &rec, const QueryFilter &f) {
+    return rec.timestamp_ns >= f.from_ns && rec.timestamp_ns <= f.to_ns &&
+           rec.temp >= f.temp_min && rec.temp <= f.temp_max &&
+           rec.smart_ec >= f.ec_min && rec.smart_ec <= f.ec_max;
+}
+
+int cmd_query(const std::string &path, const ToolOptions &opts) {
+    auto start = std::chrono::steady_clock::now();
+    PositionedLog log;
+    if (!log.open(path)) return 1;
+
+    std::vector<LogIndexEntry> entries;
+    if (!opts.unindexed && !log_index_load(log_index_path(path), log_kind_format(log.kind), entries)) {
+        std::cerr << "❌ No usable index for " << path
+                  << " (build one with: ec_log_tool index " << path << ")" << std::endl;
+        return 1;
+    }
+
+    std::ofstream file_out;
+    if (!opts.output.empty()) {
+        file_out.open(opts.output);
+        if (!file_out) {
+            std::cerr << "❌ Cannot create " << opts.output << std::endl;
+            return 1;
+        }
+    }
+    std::ostream &out = opts.output.empty() ? std::cout : file_out;
+    if (!opts.count_only) out << CSV_LOG_HEADER;
+
+    const QueryFilter &f = opts.filter;
+    uint64_t matched = 0;
+    size_t scanned = 0, pruned = 0;
+    TimestampFormatter ts_format;
+    PositionedRecordFn emit = [&](const SampleRecord &rec, uint64_t, uint32_t) {
+        if (!record_matches(rec, f)) return;
+        matched++;
+        if (!opts.count_only) write_sample_csv_row(out, rec, ts_format);
+    };
+
+    size_t first = entries.empty() ? 0 : log_index_seek(entries, f.from_ns);
+    if (first == entries.size() && first > 0) first--;   // Only the open-ended tail can match
+    for (size_t i = first; i < entries.size(); i++) {
+        const LogIndexEntry &e = entries[i];
+        bool last = (i + 1 == entries.size());
+        if (!last && e.first_timestamp_ns > f.to_ns) break;
+        if (!last && !entry_may_match(e, f)) {
+            pruned++;
+            continue;
+        }
+        scanned++;
+        log.scan(e.offset, e.skip, last ? LOG_END : entries[i + 1].offset,
+                 last ? 0 : entries[i + 1].skip, emit);
+    }
+    if (entries.empty()) log.scan(0, 0, LOG_END, 0, emit);
+    out.flush();
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (opts.count_only) std::cout << matched << std::endl;
+    std::cerr << "🔎 " << matched << " matching record(s); scanned " << scanned << " of "
+              << entries.size() << " index entries (" << pruned << " skipped by filter) in "
+              << std::fixed << std::setprecision(1) << ms << " ms" << std::endl;
+    return 0;
+}
+
+// ===========================
+// COMMAND: PLOT
+// ===========================
+// Native replacement for plot_data.py (see ec_chart.h): one streaming pass
+// over the log into temperature bins, then LTTB per curve. CSV logs are
+// parsed in chunks on all cores, each thread into its own accumulator;
+// binary logs go through visit_log (gorilla blocks decode in parallel).
+// --from/--to and the value filters apply.
+int cmd_plot(const std::string &path, const std::string &out_dir, const ToolOptions &opts) {
+    auto start = std::chrono::steady_clock::now();
+    const QueryFilter &f = opts.filter;
+    ChartAccumulator acc;
+    uint64_t skipped = 0;
+
+    if (detect_log_kind(path) == LOG_KIND_CSV) {
+        MappedFile in;
+        if (!in.open(path)) return 1;
+        unsigned jobs = resolve_jobs(opts);
+        std::vector<std::pair<size_t, size_t> > chunks =
+            csv_split_chunks(in.data(), in.size(), INGEST_CHUNK_BYTES);
+        std::vector<ChartAccumulator> partial(std::min<size_t>(jobs, std::max<size_t>(chunks.size(), 1)));
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < partial.size(); t++) {
+            workers.emplace_back([&, t]() {
+                for (size_t i = t; i < chunks.size(); i += partial.size()) {
+                    scan_csv_range(in, chunks[i].first, chunks[i].second,
+                                   [&](const SampleRecord &rec, uint64_t, uint32_t) {
+                                       if (record_matches(rec, f)) partial[t].add(rec);
+                                   });
+                }
+            });
+        }
+        for (auto &w : workers) w.join();
+        for (const ChartAccumulator &p : partial) acc.merge(p);
+    } else {
+        bool ok = visit_log(path, opts, [&](const SampleRecord *recs, size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                if (record_matches(recs[i], f)) acc.add(recs[i]);
+            }
+        }, &skipped);
+        if (!ok) return 1;
+    }
+
+    if (acc.samples() == 0) {
+        std::cerr << "❌ No samples to plot in " << path << std::endl;
+        return 1;
+    }
+    double scan_secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const ChartChannelStats &sensor = acc.sensor();
+    const ChartChannelStats &smart = acc.smart();
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << "📊 " << acc.samples() << " samples from " << path << "\n";
+    std::cout << "   🔴 Sensor Default EC: mean " << sensor.mean() << ", std " << sensor.stddev()
+              << ", min " << sensor.min << ", max " << sensor.max << ", RMSE " << sensor.rmse() << " mS/cm\n";
+    std::cout << "   🟢 Smart Algorithm EC: mean " << smart.mean() << ", std " << smart.stddev()
+              << ", min " << smart.min << ", max " << smart.max << ", RMSE " << smart.rmse() << " mS/cm\n";
+    if (sensor.stddev() > 0 && sensor.rmse() > 0) {
+        std::cout << std::setprecision(2) << "   💡 Stability improvement "
+                  << (sensor.stddev() - smart.stddev()) / sensor.stddev() * 100 << "%, RMSE improvement "
+                  << (sensor.rmse() - smart.rmse()) / sensor.rmse() * 100 << "%\n";
+    }
+    if (acc.out_of_range() > 0) {
+        std::cerr << "⚠️  " << acc.out_of_range() << " sample(s) outside " << CHART_TEMP_LO << ".."
+                  << CHART_TEMP_HI << " °C left out of the charts" << std::endl;
+    }
+    if (skipped > 0) std::cerr << "⚠️  Skipped " << skipped << " damaged record(s)/byte(s)" << std::endl;
+
+    std::string dir = out_dir.empty() || out_dir.back() == '/' ? out_dir : out_dir + "/";
+    std::string comparison = dir + "ec_comparison_chart.svg";
+    std::string coefficient = dir + "coefficient_analysis.svg";
+    if (!render_comparison_chart(acc, opts.plot_points, comparison) ||
+        !render_coefficient_chart(acc, opts.plot_points, coefficient)) {
+        return 1;
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << std::setprecision(2) << "📈 Charts saved: " << comparison << ", " << coefficient
+              << " (scan " << scan_secs << " s, total " << secs << " s)" << std::endl;
+    return 0;
+}
+
+// ===========================
+// COMMAND: BUILD-ROLLUPS / ROLLUP
+// ===========================
+// build-rollups recomputes LOG.1m/.1h.ecr from a log (smart_logger
+// maintains them live). Logs do not record the standard, so the EC errors
+// are against --standard (default 12.88). rollup prints one tier's buckets
+// in a time range as CSV, followed by a summary of the whole range on
+// stderr.
+int cmd_build_rollups(const std::string &path, const ToolOptions &opts) {
+    PositionedLog log;
+    if (!log.open(path)) return 1;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < ROLLUP_TIER_COUNT; t++) unlink((path + ROLLUP_TIERS[t].suffix).c_str());
+    RollupSet rollups;
+    rollups.open(path);
+    uint64_t records = 0;
+    log.scan(0, 0, LOG_END, 0, [&](const SampleRecord &rec, uint64_t, uint32_t) {
+        rollups.add(rec, static_cast<float>(opts.standard_ec));
+        records++;
+    });
+    bool ok = rollups.flush();
+    rollups.close();
+    if (!ok) return 1;
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "✅ Rolled up " << records << " records into " << path << ".{1m,1h}.ecr in "
+              << std::fixed << std::setprecision(2) << secs << " s" << std::endl;
+    return 0;
+}
+
+const char ROLLUP_CSV_HEADER[] =
+    "Bucket,Count,Reference_EC,Temp_Min,Temp_Max,Temp_Mean,Raw_EC_Mean,"
+    "Sensor_EC_Min,Sensor_EC_Max,Sensor_EC_Mean,Sensor_Bias,Sensor_RMSE,Sensor_Pass_Rate,"
+    "Smart_EC_Min,Smart_EC_Max,Smart_EC_Mean,Smart_Bias,Smart_RMSE,Smart_Pass_Rate\n";
+
+void write_rollup_csv_row(std::ostream &out, const std::string &label, const RollupRecord &r) {
+    out << label << "," << r.count << "," << r.reference_ec << ","
+        << r.ch[0].min << "," << r.ch[0].max << "," << rollup_mean(r, 0) << ","
+        << rollup_mean(r, 1) << ","
+        << r.ch[2].min << "," << r.ch[2].max << "," << rollup_mean(r, 2) << ","
+        << rollup_bias(r, 2) << "," << rollup_rmse(r, 2) << ","
+        << (r.count ? static_cast<double>(r.sensor_pass) / r.count : 0.0) << ","
+        << r.ch[3].min << "," << r.ch[3].max << "," << rollup_mean(r, 3) << ","
+        << rollup_bias(r, 3) << "," << rollup_rmse(r, 3) << ","
+        << (r.count ? static_cast<double>(r.smart_pass) / r.count : 0.0) << "\n";
+}
+
+int cmd_rollup(const std::string &path, const ToolOptions &opts) {
+    RollupFileHeader header;
+    std::vector<RollupRecord> buckets;
+    if (!rollup_load(path, header, buckets)) return 1;
+
+    std::ofstream file_out;
+    if (!opts.output.empty()) {
+        file_out.open(opts.output);
+        if (!file_out) {
+            std::cerr << "❌ Cannot create " << opts.output << std::endl;
+            return 1;
+        }
+    }
+    std::ostream &out = opts.output.empty() ? std::cout : file_out;
+    out << ROLLUP_CSV_HEADER;
+
+    RollupRecord total;
+    rollup_init(total, 0);
+    size_t shown = 0;
+    int64_t bucket_ns = static_cast<int64_t>(header.bucket_seconds) * 1000000000LL;
+    for (const RollupRecord &r : buckets) {
+        if (r.bucket_start_ns + bucket_ns <= opts.filter.from_ns || r.bucket_start_ns > opts.filter.to_ns) {
+            continue;
+        }
+        write_rollup_csv_row(out, format_timestamp_ns(r.bucket_start_ns), r);
+        rollup_merge(total, r);
+        shown++;
+    }
+    out.flush();
+
+    std::cerr << "📊 " << shown << " bucket(s) of " << header.bucket_seconds << " s, "
+              << total.count << " samples";
+    if (total.count > 0) {
+        std::cerr << std::fixed << std::setprecision(4)
+                  << "; sensor RMSE " << rollup_rmse(total, 2)
+                  << ", smart RMSE " << rollup_rmse(total, 3) << " mS/cm against ";
+        if (std::isnan(total.reference_ec)) std::cerr << "each sample's standard";
+        else std::cerr << std::setprecision(3) << total.reference_ec << " mS/cm";
+        std::cerr << "; pass " << std::setprecision(1)
+                  << 100.0 * total.sensor_pass / total.count << "% / "
+                  << 100.0 * total.smart_pass / total.count << "%";
+    }
+    std::cerr << std::endl;
+    return 0;
+}
+
+// Accepts "YYYY-MM-DD HH:MM:SS" or "YYYY-MM-DD" (start or end of that day)
+bool parse_time_arg(const std::string &arg, bool upper, int64_t *out_ns) {
+    std::string text = arg;
+    if (text.size() == 10) text += upper ? " 23:59:59" : " 00:00:00";
+    CsvTimeCache cache;
+    if (!csv_parse_timestamp(text.data(), text.data() + text.size(), cache, out_ns)) {
+        std::cerr << "❌ Bad time '" << arg << "' (expected YYYY-MM-DD[ HH:MM:SS])" << std::endl;
+        return false;
+    }
+    // CSV rows carry whole seconds: an upper bound covers its entire second
+    if (upper) *out_ns += 999999999LL;
+    return true;
+}
+
+// ===========================
+// COMMAND: SEGMENTS
+// ===========================
+// Lists the rotated segments (LOG.manifest.csv) whose time and value ranges
+// can hold matches for the filters, one path per line, followed by the
+// active segment, which is never in the manifest. Segments without known
+// ranges are always listed. Meant to feed per-segment jobs run in parallel.
+bool segment_may_match(const SegmentStats &s, const QueryFilter &f) {
+    if (!s.ranges_known) return true;
+    if (s.records == 0) return false;
+    if (s.first_ns > f.to_ns || s.last_ns < f.from_ns) return false;
+    if (std::isnan(s.min_temp)) return true;
+    return s.max_temp >= f.temp_min && s.min_temp <= f.temp_max &&
+           s.max_smart_ec >= f.ec_min && s.min_smart_ec <= f.ec_max;
+}
+
+int cmd_segments(const std::string &path, const ToolOptions &opts) {
+    std::vector<ManifestEntry> entries;
+    std::string manifest = log_manifest_path(path);
+    if (!log_manifest_load(manifest, entries) && access(path.c_str(), F_OK) != 0) {
+        std::cerr << "❌ Neither " << path << " nor " << manifest << " exists" << std::endl;
+        return 1;
+    }
+
+    std::string dir = log_path_dir(path);
+    size_t listed = 0;
+    uint64_t records = 0;
+    for (const ManifestEntry &e : entries) {
+        if (!segment_may_match(e.stats, opts.filter)) continue;
+        std::cout << dir << e.segment << "\n";
+        listed++;
+        records += e.stats.records;
+    }
+    if (access(path.c_str(), F_OK) == 0) {
+        std::cout << path << "\n";
+        listed++;
+    }
+    std::cout.flush();
+    std::cerr << "🔎 " << listed << " of " << entries.size() + (access(path.c_str(), F_OK) == 0)
+              << " segments may match (" << records << " records in closed segments)" << std::endl;
+    return 0;
+}
+
+// ===========================
+// COMMAND: FLIGHT
+// ===========================
+// Saves what a flight recorder ring currently holds (--from/--to apply) as
+// a binary log, e.g. to look at a live logger's last minutes without
+// waiting for a trigger. Safe while smart_logger is writing the ring.
+int cmd_flight(const std::string &path, const std::string &out_path, const ToolOptions &opts) {
+    FlightRingReader ring;
+    if (!ring.open(path)) return 1;
+    const FlightHeader *hdr = ring.header();
+
+    std::vector<SampleRecord> records;
+    ring.collect(opts.filter.from_ns, records);
+    while (!records.empty() && records.back().timestamp_ns > opts.filter.to_ns) records.pop_back();
+    std::cout << "📼 " << path << ": " << hdr->capacity << " slots, " << hdr->head
+              << " samples recorded, " << (hdr->clean ? "closed cleanly" : "in use or not closed")
+              << std::endl;
+    if (records.empty()) {
+        std::cerr << "⚠️  No samples in range" << std::endl;
+        return 1;
+    }
+    if (access(out_path.c_str(), F_OK) == 0) {
+        std::cerr << "❌ " << out_path << " already exists" << std::endl;
+        return 1;
+    }
+    if (!flight_write_snapshot(out_path, records)) return 1;
+
+    TimestampFormatter ts_format;
+    std::cout << "✅ Saved " << records.size() << " samples (" << ts_format.format(records.front().timestamp_ns)
+              << " .. " << ts_format.format(records.back().timestamp_ns) << ") to " << out_path << std::endl;
+    return 0;
+}
+
+// ===========================
+// COMPRESSED SEGMENTS
+// ===========================
+// Rotated segments are gzipped (ec_log_rotate.h), but every reader here
+// maps its input. A LOG.gz is therefore decompressed into a private
+// temporary directory under its plain name (the extension still picks the
+// format) and removed again on exit. The segment's index was deleted with
+// the plain file, so query scans it whole.
+class DecompressedLog {
+public:
+    DecompressedLog() {}
+    ~DecompressedLog() { remove(); }
+    DecompressedLog(const DecompressedLog &) = delete;
+    DecompressedLog &operator=(const DecompressedLog &) = delete;
+
+    bool open(const std::string &gz_path) {
+        const char *tmp = getenv("TMPDIR");
+        std::string templ = std::string(tmp && *tmp ? tmp : "/tmp") + "/ec_log_tool.XXXXXX";
+        std::vector<char> dir(templ.begin(), templ.end());
+        dir.push_back('\0');
+        if (!mkdtemp(dir.data())) {
+            std::cerr << "❌ Cannot create a directory in " << templ << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        dir_ = dir.data();
+        std::string plain = gz_path.substr(0, gz_path.size() - 3);
+        size_t slash = plain.find_last_of('/');
+        path_ = dir_ + "/" + (slash == std::string::npos ? plain : plain.substr(slash + 1));
+
+        gzFile in = gzopen(gz_path.c_str(), "rb");
+        if (!in) {
+            std::cerr << "❌ Cannot open " << gz_path << std::endl;
+            return false;
+        }
+        std::ofstream out(path_, std::ios::binary);
+        std::vector<char> buf(1 << 20);
+        int n;
+        while ((n = gzread(in, buf.data(), static_cast<unsigned>(buf.size()))) > 0) {
+            out.write(buf.data(), n);
+        }
+        int err = Z_OK;
+        const char *msg = n < 0 ? gzerror(in, &err) : nullptr;
+        gzclose(in);
+        out.close();
+        if (n < 0 || !out) {
+            std::cerr << "❌ Cannot decompress " << gz_path << ": " << (msg ? msg : strerror(errno)) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    const std::string &path() const { return path_; }
+
+private:
+    std::string dir_, path_;
+
+    void remove() {
+        if (!path_.empty()) unlink(path_.c_str());
+        if (!dir_.empty()) rmdir(dir_.c_str());
+    }
+};
+
+// ===========================
+// USAGE
+// ===========================
+void print_usage() {
+    std::cout << "\nUsage: ./ec_log_tool COMMAND [ARGS] [-j THREADS]\n\n";
+    std::cout << "Commands:\n";
+    std::cout << "  info   LOG                   Show log header, record range and integrity\n";
+    std::cout << "  to-csv LOG [OUT.csv]         Convert a .ecb/.ecg/.ecw log to CSV (default: LOG.csv)\n";
+    std::cout << "  ingest CSV OUT               Clean a CSV log of any schema into OUT\n";
+    std::cout << "                               (.ecb binary, .ecg gorilla, otherwise CSV)\n";
+    std::cout << "  index  LOG                   (Re)build the LOG.idx time index\n";
+    std::cout << "  query  LOG [FILTERS]         Print matching records as CSV using LOG.idx\n";
+    std::cout << "  build-rollups LOG            (Re)build the LOG.1m/.1h.ecr rollup tiers\n";
+    std::cout << "                               (--standard X: EC reference, default: 12.88)\n";
+    std::cout << "  rollup TIER.ecr [--from/--to] Print rollup buckets as CSV (+ range summary)\n";
+    std::cout << "  segments LOG [FILTERS]       List rotated segments that may hold matches\n";
+    std::cout << "  flight RING [OUT.ecb]        Save a flight recorder ring as a binary log\n";
+    std::cout << "                               (default: RING.ecb; --from/--to apply)\n";
+    std::cout << "  plot   LOG [OUT_DIR]         Write ec_comparison_chart.svg and coefficient_analysis.svg\n";
+    std::cout << "                               (filters apply; --points N per curve, default: 1500)\n";
+    std::cout << "  selftest                     Check the log codecs and their crash recovery\n\n";
+    std::cout << "Query filters (inclusive):\n";
+    std::cout << "  --from T / --to T            Time range, \"YYYY-MM-DD[ HH:MM:SS]\" local time\n";
+    std::cout << "  --temp-min X / --temp-max X  Temperature range (°C)\n";
+    std::cout << "  --ec-min X / --ec-max X      Smart EC range (mS/cm)\n";
+    std::cout << "  --count                      Print only the number of matches\n";
+    std::cout << "  -o FILE                      Write rows to FILE instead of stdout (query, rollup)\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  -j N   Decode/parse with N threads (default: all cores)\n\n";
+    std::cout << "info, to-csv, ingest, query and plot also read gzipped segments (LOG.gz).\n\n";
+}
+
+// ===========================
+// MAIN PROGRAM
+// ===========================
+int main(int argc, char* argv[]) {
+    ToolOptions opts;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) {
+            opts.jobs = std::atoi(argv[++i]);
+        } else if (arg == "--from" && i + 1 < argc) {
+            if (!parse_time_arg(argv[++i], false, &opts.filter.from_ns)) return 1;
+        } else if (arg == "--to" && i + 1 < argc) {
+            if (!parse_time_arg(argv[++i], true, &opts.filter.to_ns)) return 1;
+        } else if (arg == "--temp-min" && i + 1 < argc) {
+            opts.filter.temp_min = std::atof(argv[++i]);
+        } else if (arg == "--temp-max" && i + 1 < argc) {
+            opts.filter.temp_max = std::atof(argv[++i]);
+        } else if (arg == "--ec-min" && i + 1 < argc) {
+            opts.filter.ec_min = std::atof(argv[++i]);
+        } else if (arg == "--ec-max" && i + 1 < argc) {
+            opts.filter.ec_max = std::atof(argv[++i]);
+        } else if (arg == "--count") {
+            opts.count_only = true;
+        } else if (arg == "-o" && i + 1 < argc) {
+            opts.output = argv[++i];
+        } else if (arg == "--standard" && i + 1 < argc) {
+            opts.standard_ec = std::atof(argv[++i]);
+        } else if (arg == "--points" && i + 1 < argc) {
+            opts.plot_points = std::max(3, std::atoi(argv[++i]));
+        } else if (arg == "--help" || arg == "-h") {
+            print_usage();
+            return 0;
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    if (args.size() == 1 && args[0] == "selftest") {
+        return run_log_selftest();
+    }
+
+    if (args.size() < 2) {
+        print_usage();
+        return 1;
+    }
+
+    std::string cmd = args[0];
+    std::string path = args[1];
+
+    // Commands that only read the log also take a rotated, gzipped segment
+    std::string input = path;
+    DecompressedLog plain;
+    if (has_suffix(path, ".gz")) {
+        if (cmd != "info" && cmd != "to-csv" && cmd != "ingest" && cmd != "query" && cmd != "plot") {
+            std::cerr << "❌ " << cmd << " needs an uncompressed log (gunzip " << path << " first)" << std::endl;
+            return 1;
+        }
+        if (!plain.open(path)) return 1;
+        input = plain.path();
+        opts.unindexed = true;
+    }
+
+    if (cmd == "info") {
+        return cmd_info(input, opts);
+    } else if (cmd == "to-csv") {
+        std::string base = has_suffix(path, ".gz") ? path.substr(0, path.size() - 3) : path;
+        std::string out_path = (args.size() > 2) ? args[2] : base + ".csv";
+        if (out_path == path) {
+            std::cerr << "❌ Output would overwrite the input file" << std::endl;
+            return 1;
+        }
+        return cmd_to_csv(input, out_path, opts);
+    } else if (cmd == "ingest") {
+        if (args.size() < 3) {
+            print_usage();
+            return 1;
+        }
+        if (args[2] == path) {
+            std::cerr << "❌ Output would overwrite the input file" << std::endl;
+            return 1;
+        }
+        return cmd_ingest(input, args[2], opts);
+    } else if (cmd == "index") {
+        return cmd_index(path);
+    } else if (cmd == "query") {
+        return cmd_query(input, opts);
+    } else if (cmd == "build-rollups") {
+        return cmd_build_rollups(path, opts);
+    } else if (cmd == "rollup") {
+        return cmd_rollup(path, opts);
+    } else if (cmd == "segments") {
+        return cmd_segments(path, opts);
+    } else if (cmd == "flight") {
+        std::string out_path = (args.size() > 2) ? args[2] : flight_snapshot_base(path);
+        if (out_path == path) {
+            std::cerr << "❌ Output would overwrite the input file" << std::endl;
+            return 1;
+        }
+        return cmd_flight(path, out_path, opts);
+    } else if (cmd == "plot") {
+        return cmd_plot(input, args.size() > 2 ? args[2] : "", opts);
+    }
+
+    std::cerr << "❌ Unknown command: " << cmd << std::endl;
+    print_usage();
+    return 1;
+}
@@ -0,0 +1,422 @@
+#ifndef EC_METRICS_H
+#define EC_METRICS_H
+
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "ec_sample.h"
+#include "ec_async_log.h"
+#include "ec_http_live.h"
+#include "ec_pipeline.h"
+#include "ec_sinks.h"
+
+// ===========================
+// PROMETHEUS METRICS
+// ===========================
+// Sensor values and logger health in the Prometheus text exposition
+// format (version 0.0.4), served at /metrics by the HTTP endpoint
+// (ec_http_live.h) and/or written periodically for node_exporter's
+// textfile collector.
+//
+// Everything the acquisition loop updates is a relaxed std::atomic: a
+// gauge stores the bits of its double, a counter or histogram bucket is a
+// fetch_add. A scrape only loads them, so scraping can never stall
+// acquisition (the worst case is a scrape that sees a sample half
+// updated, e.g. the new temperature next to the previous EC).
+
+// Upper bounds of the Modbus latency buckets, seconds. One 2-register
+// read at 9600 baud takes ~20 ms; the response timeout is 1 s.
+const double MODBUS_LATENCY_BUCKETS_S[] = {0.005, 0.01, 0.02, 0.03, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5};
+const size_t MODBUS_LATENCY_BUCKET_COUNT = sizeof(MODBUS_LATENCY_BUCKETS_S) / sizeof(double);
+
+const int METRICS_TEXTFILE_DEFAULT_MS = 15000;
+
+class AtomicGauge {
+public:
+    void set(double value) {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        bits_.store(bits, std::memory_order_relaxed);
+    }
+
+    double get() const {
+        uint64_t bits = bits_.load(std::memory_order_relaxed);
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+private:
+    std::atomic<uint64_t> bits_{0};
+};
+
+class LatencyHistogram {
+public:
+    void observe(int64_t ns) {
+        double s = ns / 1e9;
+        size_t i = 0;
+        while (i < MODBUS_LATENCY_BUCKET_COUNT && s > MODBUS_LATENCY_BUCKETS_S[i]) i++;
+        buckets_[i].fetch_add(1, std::memory_order_relaxed);   // [COUNT] = +Inf only
+        sum_ns_.fetch_add(static_cast<uint64_t>(ns > 0 ? ns : 0), std::memory_order_relaxed);
+    }
+
+    // Non-cumulative count of bucket i (i == MODBUS_LATENCY_BUCKET_COUNT: above the last bound)
+    uint64_t bucket(size_t i) const { return buckets_[i].load(std::memory_order_relaxed); }
+    uint64_t sum_ns() const { return sum_ns_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> buckets_[MODBUS_LATENCY_BUCKET_COUNT + 1] = {};
+    std::atomic<uint64_t> sum_ns_{0};
+};
+
+// Written by the acquisition thread only, read by any number of scrapers
+struct LoggerMetrics {
+    AtomicGauge temp, raw_ec, sensor_ec, smart_ec, k;
+    AtomicGauge deviation;         // Sensor EC - Smart EC (the CSV Deviation column)
+    AtomicGauge sensor_error;      // |Sensor EC - reference standard|
+    AtomicGauge smart_error;       // |Smart EC - reference standard|
+    AtomicGauge improvement;       // sensor_error - smart_error
+    AtomicGauge sample_time_s;     // Wall-clock time of the newest sample
+    std::atomic<uint32_t> flags{0};
+
+    std::atomic<uint64_t> samples{0};
+    std::atomic<uint64_t> reads{0};
+    std::atomic<uint64_t> read_failures{0};
+    std::atomic<uint64_t> read_timeouts{0};
+    LatencyHistogram modbus_latency;
+
+    // One Modbus transaction: rc from libmodbus, err = errno after it
+    void record_read(int rc, int err, int64_t elapsed_ns) {
+        reads.fetch_add(1, std::memory_order_relaxed);
+        modbus_latency.observe(elapsed_ns);
+        if (rc == -1) {
+            read_failures.fetch_add(1, std::memory_order_relaxed);
+            if (err == ETIMEDOUT) read_timeouts.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void record_sample(const SampleRecord &rec, double sensor_err, double smart_err, double improvement_score) {
+        temp.set(rec.temp);
+        raw_ec.set(rec.raw_ec);
+        sensor_ec.set(rec.sensor_ec);
+        smart_ec.set(rec.smart_ec);
+        k.set(rec.k);
+        deviation.set(static_cast<double>(rec.sensor_ec) - rec.smart_ec);
+        sensor_error.set(sensor_err);
+        smart_error.set(smart_err);
+        improvement.set(improvement_score);
+        sample_time_s.set(rec.timestamp_ns / 1e9);
+        flags.store(rec.flags, std::memory_order_relaxed);
+        samples.fetch_add(1, std::memory_order_release);
+    }
+};
+
+// ===========================
+// EXPOSITION
+// ===========================
+inline void prom_put_value(std::string &out, double value) {
+    if (std::isnan(value)) {
+        out += "NaN";
+    } else if (std::isinf(value)) {
+        out += value > 0 ? "+Inf" : "-Inf";
+    } else {
+        // Register values are floats: print their shortest form (13.2, not
+        // 13.199999809265137)
+        char buf[32];
+        float f = static_cast<float>(value);
+        char *end = static_cast<double>(f) == value ? std::to_chars(buf, buf + sizeof(buf), f).ptr
+                                                    : std::to_chars(buf, buf + sizeof(buf), value).ptr;
+        out.append(buf, end - buf);
+    }
+}
+
+inline void prom_put_value(std::string &out, uint64_t value) {
+    char buf[24];
+    out.append(buf, std::to_chars(buf, buf + sizeof(buf), value).ptr - buf);
+}
+
+inline void prom_header(std::string &out, const char *name, const char *type, const char *help) {
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+// name{labels} value
+template <typename T>
+inline void prom_sample(std::string &out, const char *name, const char *labels, T value) {
+    out += name;
+    if (labels != nullptr) {
+        out += '{';
+        out += labels;
+        out += '}';
+    }
+    out += ' ';
+    prom_put_value(out, value);
+    out += '\n';
+}
+
+template <typename T>
+inline void prom_metric(std::string &out, const char *name, const char *type, const char *help, T value) {
+    prom_header(out, name, type, help);
+    prom_sample(out, name, nullptr, value);
+}
+
+// Label value with \\, " and newline escaped
+inline std::string prom_label(const char *name, const std::string &value) {
+    std::string out = name;
+    out += "=\"";
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            out += '\\';
+            out += c;
+        } else if (c == '\n') {
+            out += "\\n";
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+    return out;
+}
+
+// log, http, pipeline and sinks may be null (not running)
+inline std::string format_prometheus_metrics(const LoggerMetrics &m, const LogWriterStats *log,
+                                             const HttpServerStats *http, const PipelineStats *pipeline = nullptr,
+                                             const std::vector<SinkStats> *sinks = nullptr) {
+    std::string out;
+    out.reserve(4096);
+
+    uint64_t samples = m.samples.load(std::memory_order_acquire);
+    prom_metric(out, "ec_samples_total", "counter", "Acquisition cycles completed.", samples);
+
+    // Sensor gauges only once there is something to report
+    if (samples > 0) {
+        prom_metric(out, "ec_temperature_celsius", "gauge", "Measured temperature (registers 60-61).",
+                    m.temp.get());
+        prom_metric(out, "ec_raw_ec_millisiemens_per_cm", "gauge",
+                    "Uncompensated conductivity (registers 45-46).", m.raw_ec.get());
+        prom_metric(out, "ec_sensor_ec_millisiemens_per_cm", "gauge",
+                    "Sensor's own compensated EC, fixed k=0.02 (registers 41-42).", m.sensor_ec.get());
+        prom_metric(out, "ec_smart_ec_millisiemens_per_cm", "gauge",
+                    "Smart algorithm EC with the dynamic coefficient.", m.smart_ec.get());
+        prom_metric(out, "ec_coefficient", "gauge", "Dynamic temperature coefficient k in use.", m.k.get());
+        prom_metric(out, "ec_deviation_millisiemens_per_cm", "gauge",
+                    "Sensor EC minus Smart EC.", m.deviation.get());
+
+        prom_header(out, "ec_standard_error_millisiemens_per_cm", "gauge",
+                    "Distance from the reference standard (--config standard, default 12.88 mS/cm).");
+        prom_sample(out, "ec_standard_error_millisiemens_per_cm", "output=\"sensor\"", m.sensor_error.get());
+        prom_sample(out, "ec_standard_error_millisiemens_per_cm", "output=\"smart\"", m.smart_error.get());
+        prom_metric(out, "ec_improvement_millisiemens_per_cm", "gauge",
+                    "Sensor error minus Smart error (positive: Smart is closer).", m.improvement.get());
+
+        uint32_t flags = m.flags.load(std::memory_order_relaxed);
+        prom_header(out, "ec_within_tolerance", "gauge", "1 if the output is within tolerance of the reference standard.");
+        prom_sample(out, "ec_within_tolerance", "output=\"sensor\"",
+                    static_cast<uint64_t>((flags & SAMPLE_FLAG_SENSOR_PASS) ? 1 : 0));
+        prom_sample(out, "ec_within_tolerance", "output=\"smart\"",
+                    static_cast<uint64_t>((flags & SAMPLE_FLAG_SMART_PASS) ? 1 : 0));
+        prom_metric(out, "ec_last_sample_timestamp_seconds", "gauge",
+                    "Wall-clock time of the newest sample.", m.sample_time_s.get());
+    }
+
+    prom_metric(out, "ec_modbus_reads_total", "counter", "Modbus read transactions.",
+                m.reads.load(std::memory_order_relaxed));
+    prom_metric(out, "ec_modbus_read_failures_total", "counter", "Modbus reads that failed.",
+                m.read_failures.load(std::memory_order_relaxed));
+    prom_metric(out, "ec_modbus_read_timeouts_total", "counter", "Modbus reads that timed out.",
+                m.read_timeouts.load(std::memory_order_relaxed));
+
+    const char *hist = "ec_modbus_read_duration_seconds";
+    prom_header(out, hist, "histogram", "Modbus read round-trip time.");
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i <= MODBUS_LATENCY_BUCKET_COUNT; i++) {
+        cumulative += m.modbus_latency.bucket(i);
+        std::string le = "le=\"";
+        if (i < MODBUS_LATENCY_BUCKET_COUNT) {
+            prom_put_value(le, MODBUS_LATENCY_BUCKETS_S[i]);
+        } else {
+            le += "+Inf";
+        }
+        le += '"';
+        out += hist;
+        out += "_bucket{" + le + "} ";
+        prom_put_value(out, cumulative);
+        out += '\n';
+    }
+    out += hist;
+    out += "_sum ";
+    prom_put_value(out, m.modbus_latency.sum_ns() / 1e9);
+    out += '\n';
+    out += hist;
+    out += "_count ";
+    prom_put_value(out, cumulative);
+    out += '\n';
+
+    if (log != nullptr) {
+        prom_metric(out, "ec_log_records_written_total", "counter", "Records handed to the log sink.",
+                    log->written);
+        prom_metric(out, "ec_log_records_dropped_total", "counter", "Records lost to log queue overflow.",
+                    log->dropped);
+        prom_metric(out, "ec_log_records_compressed_total", "counter", "Samples dropped by ingest compression.",
+                    log->compressed);
+        prom_metric(out, "ec_log_write_errors_total", "counter", "Failed log flushes and syncs.",
+                    log->write_errors);
+        prom_metric(out, "ec_log_rotations_total", "counter", "Log segments closed by rotation.",
+                    log->rotations);
+        prom_metric(out, "ec_log_reopens_total", "counter", "Log files reopened on SIGHUP.",
+                    log->reopens);
+        prom_metric(out, "ec_log_queue_depth", "gauge", "Records waiting for the log writer.",
+                    static_cast<uint64_t>(log->depth));
+    }
+
+    if (http != nullptr) {
+        prom_metric(out, "ec_http_clients", "gauge", "Open HTTP connections.",
+                    static_cast<uint64_t>(http->clients));
+        prom_metric(out, "ec_http_subscribers", "gauge", "Clients on the /events stream.",
+                    static_cast<uint64_t>(http->subscribers));
+        prom_metric(out, "ec_http_events_missed_total", "counter", "Events not sent to slow subscribers.",
+                    http->missed);
+    }
+
+    if (pipeline != nullptr) {
+        prom_metric(out, "ec_pipeline_submitted_total", "counter", "Samples accepted by the decode stage.",
+                    pipeline->submitted);
+        prom_metric(out, "ec_pipeline_dropped_total", "counter",
+                    "Samples dropped because the decode queue was full.", pipeline->dropped);
+
+        // One series per stage: {stage="decode"} etc.
+        auto per_stage = [&](const char *name, const char *type, const char *help,
+                             double (*get)(const PipelineStageStats &)) {
+            prom_header(out, name, type, help);
+            for (int i = 0; i < PIPELINE_STAGE_COUNT; i++) {
+                prom_sample(out, name, prom_label("stage", PIPELINE_STAGE_NAMES[i]).c_str(), get(pipeline->stage[i]));
+            }
+        };
+        per_stage("ec_pipeline_stage_items_total", "counter", "Items processed by the stage.",
+                  [](const PipelineStageStats &st) { return static_cast<double>(st.items); });
+        per_stage("ec_pipeline_stage_busy_seconds_total", "counter", "Time spent processing items.",
+                  [](const PipelineStageStats &st) { return st.busy_ns / 1e9; });
+        per_stage("ec_pipeline_stage_max_seconds", "gauge", "Slowest single item.",
+                  [](const PipelineStageStats &st) { return st.max_ns / 1e9; });
+        per_stage("ec_pipeline_stage_blocked_seconds_total", "counter", "Time waiting for room in the next queue.",
+                  [](const PipelineStageStats &st) { return st.blocked_ns / 1e9; });
+        per_stage("ec_pipeline_queue_depth", "gauge", "Items waiting in the stage's input queue.",
+                  [](const PipelineStageStats &st) { return static_cast<double>(st.queue_depth); });
+        per_stage("ec_pipeline_queue_max_depth", "gauge", "High-water mark of the stage's input queue.",
+                  [](const PipelineStageStats &st) { return static_cast<double>(st.queue_max_depth); });
+
+        prom_header(out, "ec_pipeline_latency_seconds", "summary", "Bus read to sinks done.");
+        prom_sample(out, "ec_pipeline_latency_seconds_sum", nullptr, pipeline->e2e_sum_ns / 1e9);
+        prom_sample(out, "ec_pipeline_latency_seconds_count", nullptr, pipeline->e2e_count);
+        prom_metric(out, "ec_pipeline_latency_max_seconds", "gauge", "Slowest sample from bus read to sinks.",
+                    pipeline->e2e_max_ns / 1e9);
+    }
+
+    if (sinks != nullptr && !sinks->empty()) {
+        // One series per --sink: {sink="udp:host:9000"} etc.
+        auto per_sink = [&](const char *name, const char *type, const char *help,
+                            double (*get)(const SinkStats &)) {
+            prom_header(out, name, type, help);
+            for (const SinkStats &st : *sinks) {
+                prom_sample(out, name, prom_label("sink", st.name).c_str(), get(st));
+            }
+        };
+        per_sink("ec_sink_records_total", "counter", "Samples written by the sink.",
+                 [](const SinkStats &st) { return static_cast<double>(st.records); });
+        per_sink("ec_sink_dropped_records_total", "counter", "Samples dropped because the sink's queue was full.",
+                 [](const SinkStats &st) { return static_cast<double>(st.dropped); });
+        per_sink("ec_sink_write_errors_total", "counter", "Batches the sink failed to write.",
+                 [](const SinkStats &st) { return static_cast<double>(st.errors); });
+        per_sink("ec_sink_blocked_seconds_total", "counter", "Time the fan-out waited for the sink (@block).",
+                 [](const SinkStats &st) { return st.blocked_ns / 1e9; });
+        per_sink("ec_sink_backlog_bytes", "gauge", "Bytes held for later delivery (MQTT spool).",
+                 [](const SinkStats &st) { return static_cast<double>(st.backlog_bytes); });
+        per_sink("ec_sink_queue_depth", "gauge", "Batches waiting for the sink.",
+                 [](const SinkStats &st) { return static_cast<double>(st.depth); });
+        per_sink("ec_sink_queue_max_depth", "gauge", "High-water mark of the sink's queue.",
+                 [](const SinkStats &st) { return static_cast<double>(st.max_depth); });
+    }
+    return out;
+}
+
+// ===========================
+// TEXTFILE COLLECTOR OUTPUT
+// ===========================
+// Rewrites PATH every period from its own thread: the text goes to
+// PATH.tmp, which is then renamed over PATH, so node_exporter never reads
+// a half-written file. PATH must end in .prom for the collector.
+class MetricsTextfileWriter {
+public:
+    ~MetricsTextfileWriter() { stop(); }
+
+    void start(const std::string &path, int period_ms, std::function<std::string()> render) {
+        path_ = path;
+        render_ = render;
+        period_ = std::chrono::milliseconds(period_ms > 0 ? period_ms : METRICS_TEXTFILE_DEFAULT_MS);
+        running_ = true;
+        thread_ = std::thread(&MetricsTextfileWriter::run, this);
+    }
+
+    void stop() {
+        if (!thread_.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+        }
+        wake_.notify_one();
+        thread_.join();
+        write_file();   // Final values
+    }
+
+private:
+    std::string path_;
+    std::function<std::string()> render_;
+    std::chrono::milliseconds period_{METRICS_TEXTFILE_DEFAULT_MS};
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool running_ = false;
+    bool warned_ = false;
+
+    void run() {
+        while (true) {
+            write_file();
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (wake_.wait_for(lock, period_, [this] { return !running_; })) return;
+        }
+    }
+
+    void write_file() {
+        std::string text = render_();
+        std::string tmp = path_ + ".tmp";
+        FILE *f = fopen(tmp.c_str(), "w");
+        bool ok = f != nullptr && fwrite(text.data(), 1, text.size(), f) == text.size();
+        if (f != nullptr && fclose(f) != 0) ok = false;
+        if (ok && rename(tmp.c_str(), path_.c_str()) != 0) ok = false;
+        if (!ok && !warned_) {
+            std::cerr << "⚠️  Cannot write metrics to " << path_ << ": " << strerror(errno) << std::endl;
+            warned_ = true;
+        }
+    }
+};
+
+#endif // EC_METRICS_H
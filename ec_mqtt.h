@@ -0,0 +1,531 @@
+#ifndef EC_MQTT_H
+#define EC_MQTT_H
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#include "ec_sample.h"
+#include "ec_crc32.h"
+#include "ec_log_segment.h"
+
+// ===========================
+// MQTT PUBLISHER
+// ===========================
+// Just enough MQTT 3.1.1 to publish: CONNECT, PUBLISH at QoS 0/1/2 (with
+// the PUBACK or PUBREC/PUBREL/PUBCOMP handshake), PINGREQ and DISCONNECT.
+// The logger never subscribes, so the only packets a broker sends back are
+// acknowledgements and PINGRESP. Every call blocks for at most its
+// timeout; the MQTT sink (ec_sinks.h) calls them from its own thread.
+//
+// While the broker is unreachable, messages go to an on-disk spool
+// (MqttSpool) and are replayed in order once a connection is back, so
+// nothing is lost to an outage shorter than the spool's size limit.
+// Delivery is at-least-once: a message replayed after a crash may arrive
+// twice.
+
+const char *const MQTT_DEFAULT_PORT = "1883";
+const int MQTT_CONNECT_TIMEOUT_MS = 3000;
+const int MQTT_ACK_TIMEOUT_MS = 5000;          // CONNACK, PUBACK, PUBCOMP, PINGRESP
+const int MQTT_KEEPALIVE_S = 30;
+const int MQTT_RETRY_MIN_MS = 1000;            // Reconnect backoff, doubling...
+const int MQTT_RETRY_MAX_MS = 30000;           // ...up to this
+const size_t MQTT_MAX_SAMPLES_PER_MESSAGE = 3600;
+
+enum MqttPacketType : uint8_t {
+    MQTT_CONNECT = 1,
+    MQTT_CONNACK = 2,
+    MQTT_PUBLISH = 3,
+    MQTT_PUBACK = 4,
+    MQTT_PUBREC = 5,
+    MQTT_PUBREL = 6,
+    MQTT_PUBCOMP = 7,
+    MQTT_PINGREQ = 12,
+    MQTT_PINGRESP = 13,
+    MQTT_DISCONNECT = 14
+};
+
+inline int64_t mqtt_now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+inline void mqtt_put_u16(std::string &out, uint16_t value) {
+    out += static_cast<char>(value >> 8);
+    out += static_cast<char>(value & 0xFF);
+}
+
+inline void mqtt_put_string(std::string &out, const std::string &text) {
+    mqtt_put_u16(out, static_cast<uint16_t>(text.size()));
+    out += text;
+}
+
+// Fixed header: type/flags byte, then the remaining length (1-4 byte varint)
+inline std::string mqtt_packet(uint8_t type, uint8_t flags, const std::string &body) {
+    std::string packet;
+    packet.reserve(body.size() + 5);
+    packet += static_cast<char>((type << 4) | flags);
+    size_t len = body.size();
+    do {
+        uint8_t byte = len % 128;
+        len /= 128;
+        if (len > 0) byte |= 0x80;
+        packet += static_cast<char>(byte);
+    } while (len > 0);
+    packet += body;
+    return packet;
+}
+
+class MqttClient {
+public:
+    MqttClient() {}
+    ~MqttClient() { close(); }
+    MqttClient(const MqttClient &) = delete;
+    MqttClient &operator=(const MqttClient &) = delete;
+
+    // TCP connect plus CONNECT/CONNACK (clean session). Failures are
+    // printed if report is set.
+    bool connect(const std::string &host, const std::string &port, const std::string &client_id,
+                 bool report = true) {
+        close();
+        struct addrinfo hints, *res = nullptr;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        int rc = getaddrinfo(host.c_str(), port.c_str(), &hints, &res);
+        if (rc != 0) {
+            if (report) {
+                std::cerr << "⚠️  MQTT broker " << host << ":" << port << ": " << gai_strerror(rc) << std::endl;
+            }
+            return false;
+        }
+        for (struct addrinfo *ai = res; ai != nullptr && fd_ == -1; ai = ai->ai_next) {
+            fd_ = connect_with_timeout(ai);
+        }
+        freeaddrinfo(res);
+        if (fd_ == -1) {
+            if (report) {
+                std::cerr << "⚠️  MQTT broker " << host << ":" << port << " unreachable: " << strerror(errno)
+                          << std::endl;
+            }
+            return false;
+        }
+
+        std::string body;
+        mqtt_put_string(body, "MQTT");
+        body += static_cast<char>(4);           // Protocol level 3.1.1
+        body += static_cast<char>(0x02);        // Clean session
+        mqtt_put_u16(body, MQTT_KEEPALIVE_S);
+        mqtt_put_string(body, client_id);
+        uint8_t type;
+        std::string reply;
+        if (!send_packet(mqtt_packet(MQTT_CONNECT, 0, body)) || !read_packet(type, reply, MQTT_ACK_TIMEOUT_MS) ||
+            type != MQTT_CONNACK || reply.size() != 2) {
+            if (report) {
+                std::cerr << "⚠️  MQTT broker " << host << ":" << port << " did not accept the connection"
+                          << std::endl;
+            }
+            close();
+            return false;
+        }
+        if (reply[1] != 0) {
+            if (report) {
+                std::cerr << "⚠️  MQTT broker " << host << ":" << port << " refused the connection (code "
+                          << static_cast<int>(static_cast<uint8_t>(reply[1])) << ")" << std::endl;
+            }
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    bool connected() const { return fd_ != -1; }
+
+    // Returns once the broker has acknowledged the message (QoS 1/2) or it
+    // has been sent (QoS 0). false closes the connection.
+    bool publish(const std::string &topic, const char *payload, size_t len, int qos) {
+        if (fd_ == -1) return false;
+        uint16_t id = 0;
+        std::string body;
+        body.reserve(topic.size() + len + 4);
+        mqtt_put_string(body, topic);
+        if (qos > 0) {
+            id = next_id_++;
+            if (next_id_ == 0) next_id_ = 1;
+            mqtt_put_u16(body, id);
+        }
+        body.append(payload, len);
+        if (!send_packet(mqtt_packet(MQTT_PUBLISH, static_cast<uint8_t>(qos << 1), body))) return fail();
+
+        if (qos == 1) return await(MQTT_PUBACK, id) || fail();
+        if (qos == 2) {
+            if (!await(MQTT_PUBREC, id)) return fail();
+            std::string rel;
+            mqtt_put_u16(rel, id);
+            if (!send_packet(mqtt_packet(MQTT_PUBREL, 0x02, rel))) return fail();
+            return await(MQTT_PUBCOMP, id) || fail();
+        }
+        return true;
+    }
+
+    // PINGREQ after half the keepalive without traffic; false = broker gone
+    bool keepalive() {
+        if (fd_ == -1) return false;
+        if (mqtt_now_ms() - last_send_ms_ < MQTT_KEEPALIVE_S * 500) return true;
+        if (!send_packet(mqtt_packet(MQTT_PINGREQ, 0, std::string()))) return fail();
+        return await(MQTT_PINGRESP, 0) || fail();
+    }
+
+    void disconnect() {
+        if (fd_ == -1) return;
+        send_packet(mqtt_packet(MQTT_DISCONNECT, 0, std::string()));
+        close();
+    }
+
+    void close() {
+        if (fd_ == -1) return;
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+private:
+    int fd_ = -1;
+    uint16_t next_id_ = 1;
+    int64_t last_send_ms_ = 0;
+
+    bool fail() {
+        close();
+        return false;
+    }
+
+    static int connect_with_timeout(const struct addrinfo *ai) {
+        int fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd == -1) return -1;
+        if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == -1) {
+            struct pollfd pfd = {fd, POLLOUT, 0};
+            int err = 0;
+            socklen_t err_len = sizeof(err);
+            if (errno != EINPROGRESS || poll(&pfd, 1, MQTT_CONNECT_TIMEOUT_MS) != 1 ||
+                getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &err_len) == -1 || err != 0) {
+                if (err != 0) errno = err;
+                else if (errno == EINPROGRESS) errno = ETIMEDOUT;
+                int saved = errno;
+                ::close(fd);
+                errno = saved;
+                return -1;
+            }
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        return fd;
+    }
+
+    bool wait_fd(short events, int64_t deadline_ms) {
+        struct pollfd pfd = {fd_, events, 0};
+        while (true) {
+            int timeout = static_cast<int>(deadline_ms - mqtt_now_ms());
+            if (timeout < 0) timeout = 0;
+            int rc = poll(&pfd, 1, timeout);
+            if (rc == 1) return true;
+            if (rc == 0 || errno != EINTR) return false;
+        }
+    }
+
+    bool send_packet(const std::string &packet) {
+        int64_t deadline = mqtt_now_ms() + MQTT_ACK_TIMEOUT_MS;
+        const char *p = packet.data();
+        size_t left = packet.size();
+        while (left > 0) {
+            ssize_t n = send(fd_, p, left, MSG_NOSIGNAL);
+            if (n > 0) {
+                p += n;
+                left -= n;
+            } else if (n == -1 && errno == EINTR) {
+                continue;
+            } else if (n == -1 && errno == EAGAIN) {
+                if (!wait_fd(POLLOUT, deadline)) return false;
+            } else {
+                return false;
+            }
+        }
+        last_send_ms_ = mqtt_now_ms();
+        return true;
+    }
+
+    bool read_exact(char *buf, size_t len, int64_t deadline) {
+        while (len > 0) {
+            ssize_t n = recv(fd_, buf, len, 0);
+            if (n > 0) {
+                buf += n;
+                len -= n;
+            } else if (n == -1 && errno == EINTR) {
+                continue;
+            } else if (n == -1 && errno == EAGAIN) {
+                if (!wait_fd(POLLIN, deadline)) return false;
+            } else {
+                return false;   // Closed by the broker, or an error
+            }
+        }
+        return true;
+    }
+
+    bool read_packet(uint8_t &type, std::string &body, int timeout_ms) {
+        int64_t deadline = mqtt_now_ms() + timeout_ms;
+        char byte;
+        if (!read_exact(&byte, 1, deadline)) return false;
+        type = static_cast<uint8_t>(byte) >> 4;
+        size_t len = 0;
+        for (int shift = 0; shift < 28; shift += 7) {
+            if (!read_exact(&byte, 1, deadline)) return false;
+            len |= static_cast<size_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) break;
+        }
+        body.resize(len);
+        return len == 0 || read_exact(&body[0], len, deadline);
+    }
+
+    // Next packet of the given type (and packet ID, if any); anything else
+    // the broker sends in between (a late PINGRESP) is skipped
+    bool await(uint8_t want, uint16_t id) {
+        int64_t deadline = mqtt_now_ms() + MQTT_ACK_TIMEOUT_MS;
+        uint8_t type;
+        std::string body;
+        while (mqtt_now_ms() < deadline) {
+            if (!read_packet(type, body, static_cast<int>(deadline - mqtt_now_ms()))) return false;
+            if (type != want) continue;
+            if (want == MQTT_PINGRESP) return true;
+            if (body.size() >= 2 &&
+                ((static_cast<uint8_t>(body[0]) << 8) | static_cast<uint8_t>(body[1])) == id) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// ===========================
+// MQTT SPOOL FILE
+// ===========================
+// Messages that could not be delivered, oldest first:
+//
+//   [File header: "ECMQSPL1"][record][record] ...
+//
+//   record = [magic u32][crc32 u32][qos u8][reserved u8][topic length u16]
+//            [payload length u32][topic][payload]
+//
+// The CRC covers everything after itself. Each append is fdatasync'd, so
+// a spooled message survives power loss. open() walks the records and cuts
+// the file after the last intact one (a torn append). Replay reads from
+// the front; once the whole file has been delivered it is truncated back
+// to the header. A file with a foreign header is moved aside
+// (ec_log_segment.h) rather than appended to.
+const char MQTT_SPOOL_MAGIC[8] = {'E', 'C', 'M', 'Q', 'S', 'P', 'L', '1'};
+const uint32_t MQTT_SPOOL_RECORD_MAGIC = 0x534D4345;   // "ECMS"
+const uint64_t MQTT_SPOOL_DEFAULT_MAX_MB = 64;
+
+struct MqttSpoolRecordHeader {
+    uint32_t magic;
+    uint32_t crc32;
+    uint8_t  qos;
+    uint8_t  reserved;
+    uint16_t topic_len;
+    uint32_t payload_len;
+};
+static_assert(sizeof(MqttSpoolRecordHeader) == 16, "MqttSpoolRecordHeader must be 16 bytes");
+
+class MqttSpool {
+public:
+    ~MqttSpool() { close(); }
+
+    bool open(const std::string &path, uint64_t max_bytes) {
+        close();
+        path_ = path;
+        max_bytes_ = max_bytes;
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ == -1) {
+            std::cerr << "❌ Cannot open MQTT spool " << path << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        char magic[sizeof(MQTT_SPOOL_MAGIC)];
+        ssize_t got = pread(fd_, magic, sizeof(magic), 0);
+        if (got > 0 && (got != sizeof(magic) || memcmp(magic, MQTT_SPOOL_MAGIC, sizeof(magic)) != 0)) {
+            ::close(fd_);
+            fd_ = -1;
+            if (log_archive_segment(path, "not an MQTT spool file").empty()) return false;
+            return open(path, max_bytes);
+        }
+        if (got <= 0 && pwrite(fd_, MQTT_SPOOL_MAGIC, sizeof(MQTT_SPOOL_MAGIC), 0) != sizeof(MQTT_SPOOL_MAGIC)) {
+            std::cerr << "❌ Cannot write MQTT spool " << path << ": " << strerror(errno) << std::endl;
+            close();
+            return false;
+        }
+
+        // Find the end of the last intact record
+        struct stat st;
+        uint64_t file_size = fstat(fd_, &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+        uint64_t end = sizeof(MQTT_SPOOL_MAGIC);
+        uint8_t qos;
+        std::string topic, payload;
+        uint64_t count = 0;
+        while (read_record(end, file_size, qos, topic, payload)) count++;
+        if (ftruncate(fd_, end) == -1) {
+            std::cerr << "❌ Cannot repair MQTT spool " << path << ": " << strerror(errno) << std::endl;
+        }
+        end_ = end;
+        read_offset_ = sizeof(MQTT_SPOOL_MAGIC);
+        bytes_.store(end_ - read_offset_, std::memory_order_relaxed);
+        if (count > 0) {
+            std::cout << "  📦 MQTT spool " << path << ": " << count << " undelivered message(s)" << std::endl;
+        }
+        return true;
+    }
+
+    bool is_open() const { return fd_ != -1; }
+    bool empty() const { return read_offset_ == end_; }
+
+    // Undelivered bytes (any thread)
+    uint64_t bytes() const { return bytes_.load(std::memory_order_relaxed); }
+
+    // false if the spool is full or the write failed (reported once)
+    bool append(int qos, const std::string &topic, const char *payload, size_t len) {
+        if (fd_ == -1) return false;
+        size_t size = sizeof(MqttSpoolRecordHeader) + topic.size() + len;
+        if (end_ - read_offset_ + size > max_bytes_) {
+            if (!full_reported_) {
+                std::cerr << "⚠️  MQTT spool " << path_ << " is full; dropping messages until the broker is back"
+                          << std::endl;
+                full_reported_ = true;
+            }
+            return false;
+        }
+        std::string record(sizeof(MqttSpoolRecordHeader), '\0');
+        record += topic;
+        record.append(payload, len);
+        MqttSpoolRecordHeader h;
+        h.magic = MQTT_SPOOL_RECORD_MAGIC;
+        h.qos = static_cast<uint8_t>(qos);
+        h.reserved = 0;
+        h.topic_len = static_cast<uint16_t>(topic.size());
+        h.payload_len = static_cast<uint32_t>(len);
+        memcpy(&record[0], &h, sizeof(h));
+        h.crc32 = crc32_compute(record.data() + 8, record.size() - 8);
+        memcpy(&record[0], &h, sizeof(h));
+
+        if (pwrite(fd_, record.data(), record.size(), end_) != static_cast<ssize_t>(record.size()) ||
+            fdatasync(fd_) == -1) {
+            std::cerr << "❌ MQTT spool write failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+        end_ += record.size();
+        bytes_.store(end_ - read_offset_, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Oldest undelivered message; pop() once it has been delivered
+    bool front(uint8_t &qos, std::string &topic, std::string &payload) {
+        next_offset_ = read_offset_;
+        return read_offset_ < end_ && read_record(next_offset_, end_, qos, topic, payload);
+    }
+
+    void pop() {
+        read_offset_ = next_offset_;
+        if (read_offset_ >= end_) {
+            // Everything delivered: start over at the header
+            if (ftruncate(fd_, sizeof(MQTT_SPOOL_MAGIC)) == 0) {
+                end_ = read_offset_ = sizeof(MQTT_SPOOL_MAGIC);
+            }
+            full_reported_ = false;
+        }
+        bytes_.store(end_ - read_offset_, std::memory_order_relaxed);
+    }
+
+    void close() {
+        if (fd_ == -1) return;
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+private:
+    std::string path_;
+    int fd_ = -1;
+    uint64_t max_bytes_ = MQTT_SPOOL_DEFAULT_MAX_MB << 20;
+    uint64_t end_ = 0;           // Append position
+    uint64_t read_offset_ = 0;   // Oldest undelivered record
+    uint64_t next_offset_ = 0;   // Record after the one front() returned
+    bool full_reported_ = false;
+    std::atomic<uint64_t> bytes_{0};
+
+    // Reads the record at offset and advances it; false at limit (the end
+    // of the data) or at a damaged record
+    bool read_record(uint64_t &offset, uint64_t limit, uint8_t &qos, std::string &topic, std::string &payload) {
+        MqttSpoolRecordHeader h;
+        if (offset + sizeof(h) > limit || pread(fd_, &h, sizeof(h), offset) != sizeof(h) ||
+            h.magic != MQTT_SPOOL_RECORD_MAGIC) {
+            return false;
+        }
+        // The lengths are not covered by a checked CRC yet: a damaged header
+        // must not make us allocate more than the file holds
+        uint64_t size = sizeof(h) + static_cast<uint64_t>(h.topic_len) + h.payload_len;
+        if (size > limit - offset) return false;
+        std::string record(size, '\0');
+        if (pread(fd_, &record[0], record.size(), offset) != static_cast<ssize_t>(record.size()) ||
+            crc32_compute(record.data() + 8, record.size() - 8) != h.crc32) {
+            return false;
+        }
+        qos = h.qos;
+        topic.assign(record, sizeof(h), h.topic_len);
+        payload.assign(record, sizeof(h) + h.topic_len, h.payload_len);
+        offset += record.size();
+        return true;
+    }
+};
+
+// ===========================
+// BINARY PAYLOAD
+// ===========================
+// Compact alternative to JSON lines (payload=binary), little-endian:
+//
+//   [magic "ECMQ"][version u16 = 1][record size u16 = 32][count u32]
+//   count x [timestamp_ns i64][temp f32][raw_ec f32][sensor_ec f32]
+//           [smart_ec f32][k f32][flags u32]
+//
+// Python: struct.iter_unpack('<q5fI', payload[12:])
+const uint16_t MQTT_BINARY_VERSION = 1;
+const size_t MQTT_BINARY_HEADER = 12;
+const size_t MQTT_BINARY_RECORD = 32;
+
+inline void mqtt_binary_begin(std::string &out) {
+    out.assign("ECMQ", 4);
+    uint16_t version = MQTT_BINARY_VERSION, record = MQTT_BINARY_RECORD;
+    uint32_t count = 0;
+    out.append(reinterpret_cast<const char *>(&version), 2);
+    out.append(reinterpret_cast<const char *>(&record), 2);
+    out.append(reinterpret_cast<const char *>(&count), 4);
+}
+
+inline void mqtt_binary_append(std::string &out, const SampleRecord &rec) {
+    char buf[MQTT_BINARY_RECORD];
+    const float values[5] = {rec.temp, rec.raw_ec, rec.sensor_ec, rec.smart_ec, rec.k};
+    memcpy(buf, &rec.timestamp_ns, 8);
+    memcpy(buf + 8, values, 20);
+    memcpy(buf + 28, &rec.flags, 4);
+    out.append(buf, sizeof(buf));
+    uint32_t count = static_cast<uint32_t>((out.size() - MQTT_BINARY_HEADER) / MQTT_BINARY_RECORD);
+    memcpy(&out[8], &count, 4);
+}
+
+#endif // EC_MQTT_H
@@ -0,0 +1,253 @@
+#ifndef EC_PIPELINE_H
+#define EC_PIPELINE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "ec_sample.h"
+#include "ec_spsc_ring.h"
+#include "ec_timestamp.h"
+
+// ===========================
+// STAGED ACQUISITION PIPELINE
+// ===========================
+// One sample passes four stages, each on its own thread, connected by
+// bounded lock-free SPSC queues (ec_spsc_ring.h):
+//
+//   acquisition ──▶ decode ──▶ compensate ──▶ sinks
+//   (Modbus only)   (registers   (dynamic k,    (dashboard snapshot, metrics,
+//                    to floats)   smart EC,      flight recorder, log writer)
+//                                 pass/fail)
+//
+// The acquisition thread does nothing but bus I/O and submit(), which
+// never blocks: if the decode queue is full the sample is dropped and
+// counted, so a stuck downstream stage can never shift a Modbus read.
+// Between the worker stages there is backpressure instead: a stage whose
+// output queue is full waits until the next stage catches up (the wait is
+// counted as blocked time), so no sample is lost once it is in the
+// pipeline.
+//
+// A failed bus read still travels down the pipeline (item.failed set) so
+// that the sink stage, which owns the flight recorder and the terminal
+// warnings, can react to it; decode and compensate pass it through.
+//
+// Per stage the pipeline counts items, busy time and the slowest item,
+// per queue the depth and its high-water mark, and for the sink stage
+// the end-to-end latency from the bus read to the sinks. stats() reads
+// them from any thread (exposed at /metrics, ec_metrics.h).
+
+const size_t PIPELINE_QUEUE_CAPACITY = 1024;   // Items per queue (~17 min at 1 Hz)
+const size_t PIPELINE_BATCH_MAX = 64;
+const int PIPELINE_IDLE_MS = 100;              // Stage wake-up period when idle
+
+enum PipelineStageId {
+    PIPELINE_DECODE = 0,
+    PIPELINE_COMPENSATE = 1,
+    PIPELINE_SINKS = 2,
+    PIPELINE_STAGE_COUNT = 3
+};
+
+const char *const PIPELINE_STAGE_NAMES[PIPELINE_STAGE_COUNT] = {"decode", "compensate", "sinks"};
+
+// Which bus read failed (0 = sample complete)
+const uint32_t PIPELINE_FAILED_TEMP = 1;
+const uint32_t PIPELINE_FAILED_RAW_EC = 2;
+const uint32_t PIPELINE_FAILED_SENSOR_EC = 3;
+
+// The unit every queue carries. Acquisition fills the timestamp and the
+// register words, decode the floats, compensate smart_ec/k/flags and the
+// distances from the standard.
+struct PipelineItem {
+    SampleRecord rec;
+    int64_t acquired_ns;        // CLOCK_MONOTONIC at the start of the bus reads
+    int sample_count;
+    uint32_t failed;            // PIPELINE_FAILED_* or 0
+    double distance_sensor;     // |sensor EC - standard|
+    double distance_smart;      // |smart EC - standard|
+};
+
+struct PipelineStageStats {
+    uint64_t items = 0;         // Items processed
+    uint64_t busy_ns = 0;       // Total processing time
+    uint64_t max_ns = 0;        // Slowest single item
+    uint64_t blocked_ns = 0;    // Time waiting for room in the next queue
+    size_t queue_depth = 0;     // Items waiting in this stage's input queue
+    size_t queue_max_depth = 0;
+};
+
+struct PipelineStats {
+    PipelineStageStats stage[PIPELINE_STAGE_COUNT];
+    uint64_t submitted = 0;     // Samples accepted from acquisition
+    uint64_t dropped = 0;       // ...rejected because the decode queue was full
+    uint64_t e2e_count = 0;     // Samples through the sink stage
+    uint64_t e2e_sum_ns = 0;    // Bus read -> sinks done
+    uint64_t e2e_max_ns = 0;
+};
+
+class AcquisitionPipeline {
+public:
+    typedef std::function<void(PipelineItem &)> StageFn;
+
+    AcquisitionPipeline() {}
+    ~AcquisitionPipeline() { stop(); }
+    AcquisitionPipeline(const AcquisitionPipeline &) = delete;
+    AcquisitionPipeline &operator=(const AcquisitionPipeline &) = delete;
+
+    // fn[stage] runs on that stage's thread for every item, failed or not;
+    // sinks_batch_end (optional) on the sink thread after each batch it
+    // drains, e.g. to hand collected samples on in one go
+    void start(StageFn decode, StageFn compensate, StageFn sinks,
+               std::function<void()> sinks_batch_end = nullptr) {
+        stop();
+        stage_[PIPELINE_DECODE].fn = decode;
+        stage_[PIPELINE_COMPENSATE].fn = compensate;
+        stage_[PIPELINE_SINKS].fn = sinks;
+        sinks_batch_end_ = sinks_batch_end;
+        for (int s = 0; s < PIPELINE_STAGE_COUNT; s++) {
+            stage_[s].upstream_done = false;
+            stage_[s].thread = std::thread(&AcquisitionPipeline::run, this, s);
+        }
+    }
+
+    // Acquisition thread only. Never blocks, never allocates.
+    bool submit(const PipelineItem &item) {
+        Stage &first = stage_[PIPELINE_DECODE];
+        if (!first.queue.try_push(item)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        submitted_.fetch_add(1, std::memory_order_relaxed);
+        first.note_depth();
+        first.wake.notify_one();
+        return true;
+    }
+
+    // Let every stage finish what is queued, front to back
+    void stop() {
+        for (int s = 0; s < PIPELINE_STAGE_COUNT; s++) {
+            Stage &st = stage_[s];
+            if (!st.thread.joinable()) continue;
+            {
+                std::lock_guard<std::mutex> lock(st.mutex);
+                st.upstream_done = true;
+            }
+            st.wake.notify_one();
+            st.thread.join();
+        }
+    }
+
+    PipelineStats stats() const {
+        PipelineStats s;
+        for (int i = 0; i < PIPELINE_STAGE_COUNT; i++) {
+            const Stage &st = stage_[i];
+            PipelineStageStats &out = s.stage[i];
+            out.items = st.items.load(std::memory_order_relaxed);
+            out.busy_ns = st.busy_ns.load(std::memory_order_relaxed);
+            out.max_ns = st.max_ns.load(std::memory_order_relaxed);
+            out.blocked_ns = st.blocked_ns.load(std::memory_order_relaxed);
+            out.queue_depth = st.queue.size();
+            out.queue_max_depth = st.max_depth.load(std::memory_order_relaxed);
+        }
+        s.submitted = submitted_.load(std::memory_order_relaxed);
+        s.dropped = dropped_.load(std::memory_order_relaxed);
+        s.e2e_count = e2e_count_.load(std::memory_order_relaxed);
+        s.e2e_sum_ns = e2e_sum_ns_.load(std::memory_order_relaxed);
+        s.e2e_max_ns = e2e_max_ns_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    struct Stage {
+        SpscRing<PipelineItem, PIPELINE_QUEUE_CAPACITY> queue;   // Input
+        StageFn fn;
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable wake;       // Input queue has items / stopping
+        std::condition_variable space;      // Input queue has room (backpressure)
+        bool upstream_done = false;
+
+        std::atomic<uint64_t> items{0}, busy_ns{0}, max_ns{0}, blocked_ns{0};
+        std::atomic<size_t> max_depth{0};
+
+        void note_depth() {
+            size_t depth = queue.size();
+            if (depth > max_depth.load(std::memory_order_relaxed)) {
+                max_depth.store(depth, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    Stage stage_[PIPELINE_STAGE_COUNT];
+    std::function<void()> sinks_batch_end_;
+    std::atomic<uint64_t> submitted_{0}, dropped_{0};
+    std::atomic<uint64_t> e2e_count_{0}, e2e_sum_ns_{0}, e2e_max_ns_{0};
+
+    static void raise_max(std::atomic<uint64_t> &max, uint64_t value) {
+        if (value > max.load(std::memory_order_relaxed)) max.store(value, std::memory_order_relaxed);
+    }
+
+    static int64_t mono_ns() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return timespec_to_ns(ts);
+    }
+
+    // Hand an item to the next stage, waiting while its queue is full
+    void forward(int s, const PipelineItem &item) {
+        Stage &next = stage_[s + 1];
+        if (!next.queue.try_push(item)) {
+            int64_t start = mono_ns();
+            std::unique_lock<std::mutex> lock(next.mutex);
+            while (!next.queue.try_push(item)) {
+                next.wake.notify_one();
+                next.space.wait_for(lock, std::chrono::milliseconds(1));
+            }
+            stage_[s].blocked_ns.fetch_add(mono_ns() - start, std::memory_order_relaxed);
+        }
+        next.note_depth();
+        next.wake.notify_one();
+    }
+
+    void run(int s) {
+        Stage &st = stage_[s];
+        PipelineItem batch[PIPELINE_BATCH_MAX];
+        while (true) {
+            size_t n = st.queue.pop_batch(batch, PIPELINE_BATCH_MAX);
+            if (n == 0) {
+                std::unique_lock<std::mutex> lock(st.mutex);
+                if (st.upstream_done && st.queue.size() == 0) break;
+                st.wake.wait_for(lock, std::chrono::milliseconds(PIPELINE_IDLE_MS));
+                continue;
+            }
+            st.space.notify_one();
+
+            for (size_t i = 0; i < n; i++) {
+                PipelineItem &item = batch[i];
+                int64_t start = mono_ns();
+                st.fn(item);
+                int64_t done = mono_ns();
+                st.items.fetch_add(1, std::memory_order_relaxed);
+                st.busy_ns.fetch_add(done - start, std::memory_order_relaxed);
+                raise_max(st.max_ns, done - start);
+
+                if (s + 1 < PIPELINE_STAGE_COUNT) {
+                    forward(s, item);
+                } else {
+                    uint64_t e2e = static_cast<uint64_t>(std::max<int64_t>(0, done - item.acquired_ns));
+                    e2e_count_.fetch_add(1, std::memory_order_relaxed);
+                    e2e_sum_ns_.fetch_add(e2e, std::memory_order_relaxed);
+                    raise_max(e2e_max_ns_, e2e);
+                }
+            }
+            if (s == PIPELINE_SINKS && sinks_batch_end_) sinks_batch_end_();
+        }
+    }
+};
+
+#endif // EC_PIPELINE_H
@@ -0,0 +1,119 @@
+#ifndef EC_REGISTER_CACHE_H
+#define EC_REGISTER_CACHE_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+// ===========================
+// REGISTER CACHE
+// ===========================
+// Configuration registers (device address, calibration mode, K, the
+// calibration coefficient) practically never change, yet the diagnostics
+// view used to re-read them every refresh. Each holding register can be
+// given a time-to-live: a value read within its TTL is served from memory
+// instead of the bus. Registers without a TTL are never cached.
+//
+// Our own writes drop the written registers (invalidate()), so the next
+// read after write_integer_register / write_float_register goes to the
+// device again. Changes made by another master on the bus show up once
+// the TTL runs out.
+//
+// Times are CLOCK_MONOTONIC nanoseconds. Not thread-safe: the cache
+// belongs to the thread that owns the Modbus context.
+
+const int64_t REGISTER_CONFIG_TTL_NS = 300LL * 1000000000LL;   // 5 minutes
+
+class RegisterCache {
+public:
+    // TTL for one register (0 = always read from the device)
+    void set_ttl(int addr, int64_t ttl_ns) {
+        if (ttl_ns > 0) ttl_[addr] = ttl_ns;
+        else ttl_.erase(addr);
+        values_.erase(addr);
+    }
+
+    int64_t ttl(int addr) const {
+        auto it = ttl_.find(addr);
+        return it == ttl_.end() ? 0 : it->second;
+    }
+
+    // True if all count registers from addr are cached and younger than
+    // their TTL; copies them to regs
+    bool get(int addr, int count, int64_t now_ns, uint16_t *regs) const {
+        for (int i = 0; i < count; i++) {
+            auto it = values_.find(addr + i);
+            if (it == values_.end() || now_ns - it->second.fetched_ns >= ttl(addr + i)) return false;
+            regs[i] = it->second.value;
+        }
+        return true;
+    }
+
+    // A successful read of count registers from addr; only registers with a
+    // TTL are kept
+    void put(int addr, int count, const uint16_t *regs, int64_t now_ns) {
+        for (int i = 0; i < count; i++) {
+            if (ttl(addr + i) > 0) values_[addr + i] = Entry{regs[i], now_ns};
+        }
+    }
+
+    // Registers we just wrote (or that must be re-read for another reason)
+    void invalidate(int addr, int count) {
+        for (int i = 0; i < count; i++) values_.erase(addr + i);
+    }
+
+    void clear() { values_.clear(); }
+
+private:
+    struct Entry {
+        uint16_t value;
+        int64_t fetched_ns;
+    };
+
+    std::unordered_map<int, int64_t> ttl_;
+    std::unordered_map<int, Entry> values_;
+};
+
+// Device address (8), calibration mode (13), K (16) and the calibration
+// coefficient (28-29)
+inline void register_cache_defaults(RegisterCache &cache) {
+    const int config_regs[] = {8, 13, 16, 28, 29};
+    for (int addr : config_regs) cache.set_ttl(addr, REGISTER_CONFIG_TTL_NS);
+}
+
+// "ADDR[-ADDR]=SECONDS,..." e.g. "13=300,28-29=600,16=0" (0 = never cache)
+inline bool parse_register_ttls(const std::string &specs, RegisterCache &cache) {
+    std::stringstream ss(specs);
+    std::string item;
+    bool ok = true;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) continue;
+        size_t eq = item.find('=');
+        std::string range = item.substr(0, eq);
+        size_t dash = range.find('-');
+        std::string from = range.substr(0, dash);
+        std::string to = dash == std::string::npos ? from : range.substr(dash + 1);
+        std::string value = eq == std::string::npos ? "" : item.substr(eq + 1);
+        char *end1, *end2, *end3;
+        long first = std::strtol(from.c_str(), &end1, 0);
+        long last = std::strtol(to.c_str(), &end2, 0);
+        double secs = std::strtod(value.c_str(), &end3);
+        bool valid = !from.empty() && !to.empty() && !value.empty()
+                     && *end1 == '\0' && *end2 == '\0' && *end3 == '\0'
+                     && first >= 0 && last >= first && last <= 65535 && secs >= 0;
+        if (!valid) {
+            std::cerr << "  Invalid register TTL '" << item << "' (expected ADDR[-ADDR]=SECONDS)\n";
+            ok = false;
+            continue;
+        }
+        for (long a = first; a <= last; a++) {
+            cache.set_ttl(static_cast<int>(a), static_cast<int64_t>(secs * 1e9));
+        }
+    }
+    return ok;
+}
+
+#endif // EC_REGISTER_CACHE_H
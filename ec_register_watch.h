@@ -0,0 +1,308 @@
+#ifndef EC_REGISTER_WATCH_H
+#define EC_REGISTER_WATCH_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <modbus.h>
+
+#include "ec_register_cache.h"
+#include "ec_sample.h"
+
+// ===========================
+// REGISTER WATCH LIST
+// ===========================
+// The diagnostics view shows an arbitrary list of holding registers, given
+// on the command line (--watch) or in a file (--watch-file), one entry per
+// item:
+//
+//   ADDR[:TYPE[:LABEL]]      e.g.  13:u16:Calibration Mode
+//                                  28:float:Calibration Coefficient
+//
+// TYPE is u16 (default), i16, hex, u32 or float (two registers, ABCD).
+//
+// Every refresh the list is read with as few Modbus transactions as
+// possible: registers closer than max_gap apart share one block read (the
+// unused registers in between cost 2 bytes each on the wire, a separate
+// transaction costs a full request/response turnaround). A block the
+// device rejects with "illegal data address", because a gap hits an
+// unmapped register, is split back into single-entry reads for the rest of
+// the session. Entries still fresh in the register cache are left out of
+// the plan altogether.
+
+enum WatchType {
+    WATCH_U16 = 0,
+    WATCH_I16 = 1,
+    WATCH_HEX = 2,
+    WATCH_U32 = 3,     // Two registers, high word first
+    WATCH_FLOAT = 4    // Two registers, ABCD
+};
+
+const int WATCH_MAX_BLOCK = 125;          // Modbus limit per read
+const int WATCH_DEFAULT_GAP = 4;          // Registers a block may skip over
+const int WATCH_HIGHLIGHT_REFRESHES = 3;  // How long a change stays highlighted
+
+struct WatchEntry {
+    int addr;
+    WatchType type;
+    std::string label;
+
+    int width() const { return (type == WATCH_U32 || type == WATCH_FLOAT) ? 2 : 1; }
+};
+
+struct WatchBlock {
+    int start;
+    int count;
+    std::vector<size_t> entries;   // Indexes into the watch list
+};
+
+inline bool parse_watch_type(const std::string &name, WatchType *type) {
+    if (name.empty() || name == "u16") *type = WATCH_U16;
+    else if (name == "i16") *type = WATCH_I16;
+    else if (name == "hex") *type = WATCH_HEX;
+    else if (name == "u32") *type = WATCH_U32;
+    else if (name == "float") *type = WATCH_FLOAT;
+    else return false;
+    return true;
+}
+
+// "ADDR[:TYPE[:LABEL]]"
+inline bool parse_watch_entry(const std::string &spec, WatchEntry *e) {
+    size_t c1 = spec.find(':');
+    std::string addr = spec.substr(0, c1);
+    std::string type, label;
+    if (c1 != std::string::npos) {
+        size_t c2 = spec.find(':', c1 + 1);
+        type = spec.substr(c1 + 1, c2 == std::string::npos ? std::string::npos : c2 - c1 - 1);
+        if (c2 != std::string::npos) label = spec.substr(c2 + 1);
+    }
+    char *end;
+    long a = std::strtol(addr.c_str(), &end, 0);
+    if (addr.empty() || *end != '\0' || a < 0 || a > 65535 || !parse_watch_type(type, &e->type)) {
+        std::cerr << "  Invalid watch entry '" << spec << "' (expected ADDR[:u16|i16|hex|u32|float[:LABEL]])\n";
+        return false;
+    }
+    e->addr = static_cast<int>(a);
+    e->label = label;
+    return true;
+}
+
+// Comma-separated entries (labels cannot contain commas here)
+inline bool parse_watch_list(const std::string &specs, std::vector<WatchEntry> &out) {
+    std::stringstream ss(specs);
+    std::string item;
+    bool ok = true;
+    while (std::getline(ss, item, ',')) {
+        WatchEntry e;
+        if (!item.empty() && parse_watch_entry(item, &e)) out.push_back(e);
+        else if (!item.empty()) ok = false;
+    }
+    return ok;
+}
+
+// One entry per line; blank lines and '#' comments are ignored
+inline bool load_watch_file(const std::string &path, std::vector<WatchEntry> &out) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "  Cannot open watch file " << path << "\n";
+        return false;
+    }
+    std::string line;
+    bool ok = true;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        size_t first = line.find_first_not_of(" \t");
+        if (first == std::string::npos || line[first] == '#') continue;
+        WatchEntry e;
+        if (parse_watch_entry(line.substr(first), &e)) out.push_back(e);
+        else ok = false;
+    }
+    return ok;
+}
+
+// The registers the diagnostics view has always shown
+inline std::vector<WatchEntry> default_watch_list() {
+    return {
+        {1, WATCH_U16, ""},
+        {2, WATCH_U16, ""},
+        {16, WATCH_U16, ""},
+        {13, WATCH_U16, "Calibration Mode"},
+        {28, WATCH_FLOAT, "Calibration Coefficient"},
+    };
+}
+
+// Group the entries into the fewest block reads: sorted by address, an
+// entry joins the current block if it starts at most max_gap registers
+// after the block's end and the block stays within WATCH_MAX_BLOCK
+inline std::vector<WatchBlock> plan_watch_reads(const std::vector<WatchEntry> &entries, int max_gap) {
+    std::vector<size_t> order(entries.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return entries[a].addr < entries[b].addr;
+    });
+
+    std::vector<WatchBlock> blocks;
+    for (size_t i : order) {
+        int start = entries[i].addr;
+        int end = start + entries[i].width();   // Exclusive
+        if (!blocks.empty()) {
+            WatchBlock &b = blocks.back();
+            int b_end = b.start + b.count;
+            int merged_end = std::max(b_end, end);
+            if (start <= b_end + max_gap && merged_end - b.start <= WATCH_MAX_BLOCK) {
+                b.count = merged_end - b.start;
+                b.entries.push_back(i);
+                continue;
+            }
+        }
+        blocks.push_back(WatchBlock{start, end - start, {i}});
+    }
+    return blocks;
+}
+
+// ===========================
+// REGISTER WATCH
+// ===========================
+class RegisterWatch {
+public:
+    void set(const std::vector<WatchEntry> &entries, int max_gap) {
+        entries_ = entries;
+        max_gap_ = max_gap;
+        solo_.assign(entries_.size(), false);
+        values_.assign(entries_.size(), Value());
+        reads_ = cached_ = 0;
+    }
+
+    const std::vector<WatchEntry> &entries() const { return entries_; }
+    size_t transactions() const { return reads_; }      // Bus reads in the last poll
+    size_t cached() const { return cached_; }           // Entries served from the cache
+
+    // Entries the cache holds (ec_register_cache.h) are taken from there;
+    // the rest are planned into block reads and their results cached.
+    // Entries whose block failed show a read error.
+    void poll(modbus_t *ctx, RegisterCache &cache, int64_t now_ns) {
+        uint16_t regs[WATCH_MAX_BLOCK];
+        std::vector<WatchEntry> stale;
+        std::vector<size_t> stale_index;
+        std::vector<WatchBlock> blocks;
+        reads_ = cached_ = 0;
+        for (size_t i = 0; i < entries_.size(); i++) {
+            const WatchEntry &e = entries_[i];
+            if (cache.get(e.addr, e.width(), now_ns, regs)) {
+                update(i, true, regs);
+                cached_++;
+            } else if (solo_[i]) {
+                blocks.push_back(WatchBlock{e.addr, e.width(), {i}});
+            } else {
+                stale.push_back(e);
+                stale_index.push_back(i);
+            }
+        }
+        for (WatchBlock b : plan_watch_reads(stale, max_gap_)) {
+            for (size_t &i : b.entries) i = stale_index[i];
+            blocks.push_back(b);
+        }
+
+        for (const WatchBlock &b : blocks) {
+            reads_++;
+            bool ok = modbus_read_registers(ctx, b.start, b.count, regs) == b.count;
+            if (!ok && b.entries.size() > 1 && errno == EMBXILADD) {
+                // The gap covers an unmapped register: read alone from now on
+                for (size_t i : b.entries) {
+                    const WatchEntry &e = entries_[i];
+                    solo_[i] = true;
+                    reads_++;
+                    bool one = modbus_read_registers(ctx, e.addr, e.width(), regs) == e.width();
+                    if (one) cache.put(e.addr, e.width(), regs, now_ns);
+                    update(i, one, regs);
+                }
+                continue;
+            }
+            if (ok) cache.put(b.start, b.count, regs, now_ns);
+            for (size_t i : b.entries) update(i, ok, regs + (entries_[i].addr - b.start));
+        }
+    }
+
+    // "  Register 28 = 12880.000  (Hex: 46494000)  <- Calibration Coefficient",
+    // in bold yellow for a few refreshes after the value changed
+    void print(std::ostream &out) const {
+        for (size_t i = 0; i < entries_.size(); i++) {
+            const WatchEntry &e = entries_[i];
+            const Value &v = values_[i];
+            bool changed = v.highlight > 0;
+            out << "  " << (changed ? "\033[1;33m" : "") << "Register " << std::setw(2) << e.addr << " = ";
+            if (!v.valid) {
+                out << "[READ ERROR]";
+            } else {
+                format_value(out, e.type, v.regs);
+            }
+            if (changed) out << "\033[0m";
+            if (!e.label.empty()) out << "  <- " << e.label;
+            out << "\n";
+        }
+    }
+
+private:
+    struct Value {
+        bool valid = false;
+        bool seen = false;
+        uint16_t regs[2] = {0, 0};
+        int highlight = 0;        // Refreshes left to show as changed
+    };
+
+    std::vector<WatchEntry> entries_;
+    std::vector<bool> solo_;      // Never part of a block read (rejected before)
+    std::vector<Value> values_;
+    int max_gap_ = WATCH_DEFAULT_GAP;
+    size_t reads_ = 0;
+    size_t cached_ = 0;
+
+    void update(size_t i, bool ok, const uint16_t *regs) {
+        Value &v = values_[i];
+        if (v.highlight > 0) v.highlight--;
+        if (!ok) {
+            v.valid = false;
+            return;
+        }
+        int width = entries_[i].width();
+        bool changed = v.seen && (v.regs[0] != regs[0] || (width == 2 && v.regs[1] != regs[1]));
+        v.regs[0] = regs[0];
+        v.regs[1] = width == 2 ? regs[1] : 0;
+        v.valid = true;
+        v.seen = true;
+        if (changed) v.highlight = WATCH_HIGHLIGHT_REFRESHES;
+    }
+
+    static void format_value(std::ostream &out, WatchType type, const uint16_t *regs) {
+        char buf[64];
+        uint32_t u32 = (static_cast<uint32_t>(regs[0]) << 16) | regs[1];
+        switch (type) {
+            case WATCH_I16:
+                snprintf(buf, sizeof(buf), "%6d  (0x%04X)", static_cast<int16_t>(regs[0]), regs[0]);
+                break;
+            case WATCH_HEX:
+                snprintf(buf, sizeof(buf), "0x%04X", regs[0]);
+                break;
+            case WATCH_U32:
+                snprintf(buf, sizeof(buf), "%10u  (0x%08X)", u32, u32);
+                break;
+            case WATCH_FLOAT:
+                snprintf(buf, sizeof(buf), "%.3f  (Hex: %08X)", sample_bits_float(u32), u32);
+                break;
+            default:
+                snprintf(buf, sizeof(buf), "%5u  (0x%04X)", regs[0], regs[0]);
+                break;
+        }
+        out << buf;
+    }
+};
+
+#endif // EC_REGISTER_WATCH_H
@@ -0,0 +1,385 @@
+#ifndef EC_ROLLUP_H
+#define EC_ROLLUP_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "ec_sample.h"
+#include "ec_crc32.h"
+#include "ec_log_segment.h"
+
+// ===========================
+// MULTI-RESOLUTION ROLLUPS
+// ===========================
+// Downsampled tiers kept next to the raw log, one file per bucket size:
+//
+//   LOG.1m.ecr   LOG.1h.ecr
+//
+// Every bucket stores, per channel, min/max, the sum (for the mean) and
+// the sum and sum of squares of the error against a reference, so bias
+// and RMSE of any range come from adding a few buckets together. The EC
+// reference is the standard each sample was judged against (--config
+// standard, the same one behind the PASS counts) and is recorded in the
+// bucket; temperature is compared with 25 °C. A week of 1 h buckets
+// is 168 records, however long the raw log grows.
+//
+// There is no tier finer than a minute: at the usual 1 s poll rate a 1 s
+// bucket holds a single sample, so that tier would be a 160-byte copy of
+// every record and bigger than any log format.
+//
+// A tier is a ring of a fixed number of buckets (its retention): bucket N
+// since the epoch lives in slot N % capacity, so a tier never grows past
+// header + capacity records and the oldest bucket is overwritten once the
+// retention has passed. A slot is written whole with one pwrite().
+//
+// Each tier is fed every sample directly (no cascading), so a restart
+// can resume the last, partially filled bucket of each tier on its own:
+// open() loads the newest record back into memory and the next write
+// replaces it. Records carry a CRC-32; a torn record is ignored.
+
+const char ROLLUP_MAGIC[8] = {'E', 'C', 'R', 'O', 'L', 'L', '\r', '\n'};
+const uint32_t ROLLUP_VERSION = 2;        // 2: per-bucket EC reference
+const int ROLLUP_CHANNELS = 4;            // temp, raw_ec, sensor_ec, smart_ec
+const double ROLLUP_REFERENCE_TEMP = 25.0;  // °C compensation reference
+
+struct RollupTierSpec {
+    uint32_t bucket_seconds;
+    uint32_t capacity;          // Buckets kept (retention)
+    const char *suffix;
+};
+
+const RollupTierSpec ROLLUP_TIERS[] = {
+    {60, 7 * 1440, ".1m.ecr"},      // 7 days, 1.6 MB
+    {3600, 730 * 24, ".1h.ecr"},    // 2 years, 2.8 MB
+};
+const int ROLLUP_TIER_COUNT = sizeof(ROLLUP_TIERS) / sizeof(ROLLUP_TIERS[0]);
+
+struct RollupFileHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t bucket_seconds;
+    uint32_t record_size;       // sizeof(RollupRecord)
+    uint32_t channel_count;
+    int64_t  created_ns;
+    uint32_t capacity;          // Ring slots after the header
+    uint32_t reserved;
+};
+static_assert(sizeof(RollupFileHeader) == 40, "RollupFileHeader must stay 40 bytes");
+
+struct RollupChannel {
+    float  min;
+    float  max;
+    double sum;                 // Σv          -> mean
+    double err_sum;             // Σ(v - ref)  -> bias
+    double err_sq_sum;          // Σ(v - ref)² -> RMSE
+};
+
+struct RollupRecord {
+    int64_t  bucket_start_ns;   // UTC, aligned to bucket_seconds
+    uint32_t count;             // Samples in the bucket
+    uint32_t sensor_pass;       // Samples with SAMPLE_FLAG_SENSOR_PASS
+    uint32_t smart_pass;        // Samples with SAMPLE_FLAG_SMART_PASS
+    uint32_t crc32;             // Over the record with this field zeroed
+    float    reference_ec;      // EC the errors are against (mS/cm); NAN if the standard
+                                // changed within the bucket (each sample used its own)
+    uint32_t reserved;
+    RollupChannel ch[ROLLUP_CHANNELS];
+};
+static_assert(sizeof(RollupRecord) == 160, "RollupRecord must stay 160 bytes");
+
+inline uint32_t rollup_record_crc(const RollupRecord &rec) {
+    RollupRecord copy = rec;
+    copy.crc32 = 0;
+    return crc32_compute(&copy, sizeof(copy));
+}
+
+inline void rollup_init(RollupRecord &r, int64_t bucket_start_ns) {
+    memset(&r, 0, sizeof(r));
+    r.bucket_start_ns = bucket_start_ns;
+    for (int c = 0; c < ROLLUP_CHANNELS; c++) {
+        r.ch[c].min = INFINITY;
+        r.ch[c].max = -INFINITY;
+    }
+}
+
+// reference_ec: the standard the sample's PASS flags were judged against
+inline void rollup_add(RollupRecord &r, const SampleRecord &s, float reference_ec) {
+    if (r.count == 0) r.reference_ec = reference_ec;
+    else if (r.reference_ec != reference_ec) r.reference_ec = NAN;
+    const float v[ROLLUP_CHANNELS] = {s.temp, s.raw_ec, s.sensor_ec, s.smart_ec};
+    for (int c = 0; c < ROLLUP_CHANNELS; c++) {
+        RollupChannel &ch = r.ch[c];
+        if (v[c] < ch.min) ch.min = v[c];
+        if (v[c] > ch.max) ch.max = v[c];
+        double err = v[c] - (c == 0 ? ROLLUP_REFERENCE_TEMP : reference_ec);
+        ch.sum += v[c];
+        ch.err_sum += err;
+        ch.err_sq_sum += err * err;
+    }
+    r.count++;
+    if (s.flags & SAMPLE_FLAG_SENSOR_PASS) r.sensor_pass++;
+    if (s.flags & SAMPLE_FLAG_SMART_PASS) r.smart_pass++;
+}
+
+// Combine two buckets (e.g. to summarize a range)
+inline void rollup_merge(RollupRecord &into, const RollupRecord &from) {
+    if (from.count == 0) return;
+    if (into.count == 0) into.reference_ec = from.reference_ec;
+    else if (into.reference_ec != from.reference_ec) into.reference_ec = NAN;
+    for (int c = 0; c < ROLLUP_CHANNELS; c++) {
+        if (from.ch[c].min < into.ch[c].min) into.ch[c].min = from.ch[c].min;
+        if (from.ch[c].max > into.ch[c].max) into.ch[c].max = from.ch[c].max;
+        into.ch[c].sum += from.ch[c].sum;
+        into.ch[c].err_sum += from.ch[c].err_sum;
+        into.ch[c].err_sq_sum += from.ch[c].err_sq_sum;
+    }
+    into.count += from.count;
+    into.sensor_pass += from.sensor_pass;
+    into.smart_pass += from.smart_pass;
+}
+
+inline double rollup_mean(const RollupRecord &r, int c) {
+    return r.count ? r.ch[c].sum / r.count : NAN;
+}
+
+inline double rollup_bias(const RollupRecord &r, int c) {
+    return r.count ? r.ch[c].err_sum / r.count : NAN;
+}
+
+inline double rollup_rmse(const RollupRecord &r, int c) {
+    return r.count ? std::sqrt(r.ch[c].err_sq_sum / r.count) : NAN;
+}
+
+inline off_t rollup_slot_offset(uint64_t slot) {
+    return sizeof(RollupFileHeader) + static_cast<off_t>(slot) * sizeof(RollupRecord);
+}
+
+// Every slot of a tier file, intact or not (slots never written read as
+// zeros and fail the CRC)
+inline bool rollup_read_slots(int fd, off_t file_size, std::vector<RollupRecord> &slots) {
+    size_t n = file_size > static_cast<off_t>(sizeof(RollupFileHeader))
+             ? (file_size - sizeof(RollupFileHeader)) / sizeof(RollupRecord) : 0;
+    slots.resize(n);
+    size_t bytes = n * sizeof(RollupRecord);
+    return pread(fd, slots.data(), bytes, sizeof(RollupFileHeader)) == static_cast<ssize_t>(bytes);
+}
+
+// ===========================
+// ROLLUP TIER WRITER
+// ===========================
+// Closed buckets are queued in memory and written by flush(), in step with
+// the raw log's group commit. The open bucket is written (and rewritten in
+// place) by flush() too, so readers and restarts see it.
+class RollupTierWriter {
+public:
+    RollupTierWriter() {}
+    ~RollupTierWriter() { close(); }
+    RollupTierWriter(const RollupTierWriter &) = delete;
+    RollupTierWriter &operator=(const RollupTierWriter &) = delete;
+
+    bool open(const std::string &path, const RollupTierSpec &spec) {
+        close();
+        bucket_ns_ = static_cast<int64_t>(spec.bucket_seconds) * 1000000000LL;
+        capacity_ = spec.capacity;
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd_ == -1) {
+            std::cerr << "⚠️  Cannot open rollup " << path << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+
+        struct stat st;
+        fstat(fd_, &st);
+        if (st.st_size == 0) {
+            RollupFileHeader fh;
+            memset(&fh, 0, sizeof(fh));
+            memcpy(fh.magic, ROLLUP_MAGIC, sizeof(fh.magic));
+            fh.version = ROLLUP_VERSION;
+            fh.bucket_seconds = spec.bucket_seconds;
+            fh.record_size = sizeof(RollupRecord);
+            fh.channel_count = ROLLUP_CHANNELS;
+            fh.capacity = spec.capacity;
+            struct timespec now;
+            clock_gettime(CLOCK_REALTIME, &now);
+            fh.created_ns = static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+            if (pwrite(fd_, &fh, sizeof(fh), 0) != static_cast<ssize_t>(sizeof(fh))) return fail(path);
+            return true;
+        }
+
+        RollupFileHeader fh;
+        if (pread(fd_, &fh, sizeof(fh), 0) != static_cast<ssize_t>(sizeof(fh)) ||
+            memcmp(fh.magic, ROLLUP_MAGIC, sizeof(fh.magic)) != 0 || fh.version != ROLLUP_VERSION ||
+            fh.bucket_seconds != spec.bucket_seconds || fh.record_size != sizeof(RollupRecord) ||
+            fh.capacity != spec.capacity) {
+            // E.g. a version 1 tier (EC errors against a fixed 12.88):
+            // moved aside, never mixed with this version's buckets
+            ::close(fd_);
+            fd_ = -1;
+            if (log_archive_segment(path, "rollup of another version or size").empty()) return false;
+            return open(path, spec);
+        }
+
+        // Reopen the newest intact bucket for further samples
+        std::vector<RollupRecord> slots;
+        if (!rollup_read_slots(fd_, st.st_size, slots)) return fail(path);
+        for (const RollupRecord &r : slots) {
+            if (r.crc32 != rollup_record_crc(r)) continue;
+            if (!has_open_ || r.bucket_start_ns > open_.bucket_start_ns) {
+                open_ = r;
+                has_open_ = true;
+            }
+        }
+        return true;
+    }
+
+    void add(const SampleRecord &s, float reference_ec) {
+        if (fd_ == -1) return;
+        int64_t start = s.timestamp_ns - ((s.timestamp_ns % bucket_ns_) + bucket_ns_) % bucket_ns_;
+        if (has_open_ && open_.bucket_start_ns != start) {
+            closed_.push_back(open_);
+            has_open_ = false;
+        }
+        if (!has_open_) {
+            rollup_init(open_, start);
+            has_open_ = true;
+        }
+        rollup_add(open_, s, reference_ec);
+        dirty_ = true;
+    }
+
+    bool flush() {
+        if (fd_ == -1 || !dirty_) return true;
+        bool ok = true;
+        for (RollupRecord &r : closed_) ok = write_record(r) && ok;
+        closed_.clear();
+        if (has_open_) ok = write_record(open_) && ok;
+        dirty_ = false;
+        return ok;
+    }
+
+    bool sync() {
+        if (fd_ == -1) return true;
+        return fdatasync(fd_) == 0;
+    }
+
+    void close() {
+        if (fd_ == -1) return;
+        flush();
+        ::close(fd_);
+        fd_ = -1;
+        has_open_ = false;
+        closed_.clear();
+    }
+
+private:
+    int fd_ = -1;
+    int64_t bucket_ns_ = 60000000000LL;
+    uint32_t capacity_ = 1;
+    std::vector<RollupRecord> closed_;   // Finished buckets awaiting flush()
+    RollupRecord open_ = RollupRecord();
+    bool has_open_ = false;
+    bool dirty_ = false;
+
+    bool write_record(RollupRecord &r) {
+        uint64_t bucket = static_cast<uint64_t>(r.bucket_start_ns / bucket_ns_);
+        r.crc32 = rollup_record_crc(r);
+        if (pwrite(fd_, &r, sizeof(r), rollup_slot_offset(bucket % capacity_)) != static_cast<ssize_t>(sizeof(r))) {
+            std::cerr << "⚠️  Rollup write failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool fail(const std::string &path) {
+        (void)path;
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+};
+
+// All tiers of one log
+class RollupSet {
+public:
+    void open(const std::string &log_path) {
+        for (int t = 0; t < ROLLUP_TIER_COUNT; t++) {
+            tiers_[t].open(log_path + ROLLUP_TIERS[t].suffix, ROLLUP_TIERS[t]);
+        }
+    }
+
+    void add(const SampleRecord &s, float reference_ec) {
+        for (int t = 0; t < ROLLUP_TIER_COUNT; t++) tiers_[t].add(s, reference_ec);
+    }
+
+    bool flush() {
+        bool ok = true;
+        for (int t = 0; t < ROLLUP_TIER_COUNT; t++) ok = tiers_[t].flush() && ok;
+        return ok;
+    }
+
+    bool sync() {
+        bool ok = true;
+        for (int t = 0; t < ROLLUP_TIER_COUNT; t++) ok = tiers_[t].sync() && ok;
+        return ok;
+    }
+
+    void close() {
+        for (int t = 0; t < ROLLUP_TIER_COUNT; t++) tiers_[t].close();
+    }
+
+private:
+    RollupTierWriter tiers_[ROLLUP_TIER_COUNT];
+};
+
+// ===========================
+// ROLLUP READER
+// ===========================
+// Loads every intact bucket of the retention window, oldest first (a full
+// 1 h tier is 2.8 MB)
+inline bool rollup_load(const std::string &path, RollupFileHeader &header, std::vector<RollupRecord> &out) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        std::cerr << "❌ Cannot open " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat st;
+    fstat(fd, &st);
+    bool ok = st.st_size >= static_cast<off_t>(sizeof(header)) &&
+              pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+              memcmp(header.magic, ROLLUP_MAGIC, sizeof(header.magic)) == 0 &&
+              header.version == ROLLUP_VERSION && header.record_size == sizeof(RollupRecord) &&
+              header.capacity > 0;
+    std::vector<RollupRecord> slots;
+    if (ok) {
+        ok = rollup_read_slots(fd, st.st_size, slots);
+    } else {
+        std::cerr << "❌ " << path << ": not a rollup file" << std::endl;
+    }
+    ::close(fd);
+    if (!ok) return false;
+
+    // A slot that was not reached again after the ring wrapped holds a
+    // bucket from before the retention window
+    int64_t newest = INT64_MIN;
+    for (const RollupRecord &r : slots) {
+        if (r.crc32 == rollup_record_crc(r) && r.bucket_start_ns > newest) newest = r.bucket_start_ns;
+    }
+    int64_t window_ns = static_cast<int64_t>(header.bucket_seconds) * 1000000000LL * header.capacity;
+    for (const RollupRecord &r : slots) {
+        if (r.crc32 == rollup_record_crc(r) && r.bucket_start_ns > newest - window_ns) out.push_back(r);
+    }
+    std::sort(out.begin(), out.end(), [](const RollupRecord &a, const RollupRecord &b) {
+        return a.bucket_start_ns < b.bucket_start_ns;
+    });
+    return true;
+}
+
+#endif // EC_ROLLUP_H
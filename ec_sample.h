@@ -0,0 +1,57 @@
+#ifndef EC_SAMPLE_H
+#define EC_SAMPLE_H
+
+#include <cstdint>
+#include <cstring>
+
+// ===========================
+// SAMPLE RECORD (One Acquisition Cycle)
+// ===========================
+// Fixed-size, trivially copyable snapshot of one loop iteration.
+// This is the unit that moves between the acquisition loop and every
+// log sink, so it must stay POD (no std::string, no pointers).
+
+// Sample flag bits
+const uint32_t SAMPLE_FLAG_SENSOR_PASS = 1u << 0;  // Sensor EC within the configured tolerance of standard_ec
+const uint32_t SAMPLE_FLAG_SMART_PASS  = 1u << 1;  // Smart EC within the configured tolerance of standard_ec
+const uint32_t SAMPLE_FLAG_RETAINED    = 1u << 2;  // Kept by the ingest compressor (ec_ingest_compress.h)
+const uint32_t SAMPLE_FLAG_LINEAR      = 1u << 3;  // Retained by swinging door: interpolate to the next point
+
+struct SampleRecord {
+    int64_t  timestamp_ns;       // CLOCK_REALTIME, nanoseconds since epoch
+    uint16_t reg_temp[2];        // Registers 60-61 (ABCD)
+    uint16_t reg_raw_ec[2];      // Registers 45-46 (ABCD)
+    uint16_t reg_sensor_ec[2];   // Registers 41-42 (ABCD)
+    float    temp;               // Decoded temperature (°C)
+    float    raw_ec;             // Decoded uncompensated EC (mS/cm)
+    float    sensor_ec;          // Decoded sensor EC, fixed k=0.02 (mS/cm)
+    float    smart_ec;           // Smart algorithm EC (mS/cm)
+    float    k;                  // Dynamic coefficient used
+    uint32_t flags;              // SAMPLE_FLAG_* bits
+    float    standard_ec;        // Reference the PASS flags used (mS/cm); live only, not stored in logs
+};
+
+// ===========================
+// REGISTER WORD <-> FLOAT (ABCD)
+// ===========================
+// The decoded floats are bit-identical to the register pairs, so either
+// representation can be rebuilt from the other without loss.
+inline uint32_t sample_float_bits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline float sample_bits_float(uint32_t bits) {
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+inline void sample_float_to_regs(float value, uint16_t *regs) {
+    uint32_t bits = sample_float_bits(value);
+    regs[0] = static_cast<uint16_t>(bits >> 16);
+    regs[1] = static_cast<uint16_t>(bits & 0xFFFF);
+}
+
+#endif // EC_SAMPLE_H
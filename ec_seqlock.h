@@ -0,0 +1,56 @@
+#ifndef EC_SEQLOCK_H
+#define EC_SEQLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// ===========================
+// SEQLOCK SNAPSHOT
+// ===========================
+// Latest-value mailbox from one writer thread to any number of readers.
+// The writer never waits: store() bumps the sequence to odd, copies the
+// value in and bumps it to even again. A reader copies the value out and
+// retries if the sequence was odd or changed meanwhile, so it always gets
+// a consistent value, and a slow reader can never delay the writer.
+//
+// Readers only ever see the newest value; values stored between two
+// loads are skipped. T must be trivially copyable.
+
+template <typename T>
+class Seqlock {
+    static_assert(std::is_trivially_copyable<T>::value, "Seqlock needs a trivially copyable type");
+
+public:
+    Seqlock() { memset(&value_, 0, sizeof(value_)); }
+
+    // Writer thread only
+    void store(const T &value) {
+        uint32_t seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(&value_, &value, sizeof(T));
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    // Copies the newest value into out and returns its version (0 = nothing
+    // stored yet)
+    uint32_t load(T &out) const {
+        while (true) {
+            uint32_t before = seq_.load(std::memory_order_acquire);
+            if (before & 1) continue;   // Store in progress
+            memcpy(&out, &value_, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) == before) return before / 2;
+        }
+    }
+
+    uint32_t version() const { return seq_.load(std::memory_order_acquire) / 2; }
+
+private:
+    alignas(64) std::atomic<uint32_t> seq_{0};
+    T value_;
+};
+
+#endif // EC_SEQLOCK_H
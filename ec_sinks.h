@@ -0,0 +1,985 @@
+#ifndef EC_SINKS_H
+#define EC_SINKS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cerrno>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <modbus.h>
+
+#include "ec_sample.h"
+#include "ec_spsc_ring.h"
+#include "ec_timestamp.h"
+#include "ec_csv.h"
+#include "ec_binlog.h"
+#include "ec_http_live.h"
+#include "ec_mqtt.h"
+
+// ===========================
+// SAMPLE SINKS AND FAN-OUT
+// ===========================
+// Besides the main log (AsyncLogWriter), any number of --sink outputs
+// receive every sample:
+//
+//   csv:PATH              CSV file, same columns as the main log
+//   bin:PATH              Columnar binary log (ec_binlog.h)
+//   jsonl[:-]             JSON lines on stdout (same objects as /events)
+//   udp:HOST:PORT         JSON lines as UDP datagrams
+//   modbus-tcp:[ADDR:]PORT
+//                         Modbus TCP server holding the newest sample
+//   mqtt:HOST[:PORT][,key=value...]
+//                         MQTT publisher (ec_mqtt.h, options below)
+//
+// A suffix @drop (default) or @block sets what happens when that sink
+// falls behind (see SinkChannel).
+//
+// The pipeline's sink stage collects samples into a SampleBatch and hands
+// the same immutable batch, by shared_ptr, to every sink's queue, so
+// adding a sink costs one pointer push per batch. Formatting that sinks
+// share is done once per batch: the JSON lines are rendered by whichever
+// sink asks first and reused by the others.
+//
+// Each sink has its own SPSC queue and thread (SinkChannel), so a slow
+// disk or an unreachable host only backs up that sink.
+
+const size_t SINK_QUEUE_CAPACITY = 256;      // Batches per sink
+const size_t SINK_BATCH_MAX = 256;           // Samples per batch
+const size_t SINK_DRAIN_MAX = 16;            // Batches per queue drain
+const int SINK_IDLE_MS = 100;                // Sink wake-up period when idle
+const int SINK_REOPEN_RETRY_MS = 5000;       // File sinks: retry a failed reopen
+const size_t SINK_UDP_MAX_DATAGRAM = 1400;   // Stays under a 1500-byte MTU
+const int SINK_MODBUS_TCP_MAX_CLIENTS = 8;
+const int SINK_MODBUS_TCP_POLL_MS = 100;
+
+enum SinkPolicy {
+    SINK_POLICY_DROP = 0,    // Full queue: drop the batch, count its samples
+    SINK_POLICY_BLOCK = 1    // Full queue: wait (backs up the pipeline)
+};
+
+// ===========================
+// SAMPLE BATCH
+// ===========================
+class SampleBatch {
+public:
+    explicit SampleBatch(TimestampPrecision precision) : precision_(precision) {}
+
+    std::vector<LiveSample> samples;
+
+    // One format_live_sample_json object per line; formatted on first use
+    // (from whichever sink thread asks first) and shared after that
+    const std::string &json_lines() const {
+        std::call_once(json_once_, [this]() {
+            TimestampFormatter ts_format(precision_);
+            char line[HTTP_JSON_MAX_CHARS + 1];
+            json_.reserve(samples.size() * 320);
+            for (const LiveSample &s : samples) {
+                size_t len = format_live_sample_json(line, s, ts_format);
+                line[len++] = '\n';
+                json_.append(line, len);
+            }
+        });
+        return json_;
+    }
+
+private:
+    TimestampPrecision precision_;
+    mutable std::once_flag json_once_;
+    mutable std::string json_;
+};
+
+typedef std::shared_ptr<const SampleBatch> SampleBatchRef;
+
+// ===========================
+// SINK INTERFACE
+// ===========================
+class SampleSink {
+public:
+    virtual ~SampleSink() {}
+
+    // Main thread, before the sink's thread starts; false = sink unusable
+    virtual bool open() = 0;
+
+    // Sink thread, every batch in order; false counts as a write error
+    virtual bool write(const SampleBatch &batch) = 0;
+
+    // Sink thread, after each queue drain and at least every SINK_IDLE_MS
+    // (time-based work: batching windows, reconnects, keepalives)
+    virtual void poll() {}
+
+    // Sink thread, on SIGHUP: reopen files at their path (log rotation)
+    virtual void reopen() {}
+
+    // Sink thread, after the last batch
+    virtual void close() {}
+
+    // Any thread: data held back for later delivery (e.g. a spool file)
+    virtual uint64_t backlog_bytes() const { return 0; }
+};
+
+// A file at a fixed path. A failed SIGHUP reopen (the directory was moved,
+// the disk is full, ...) is reported and retried from poll() every
+// SINK_REOPEN_RETRY_MS; batches that arrive meanwhile are counted as write
+// errors instead of being buffered.
+class FileSink : public SampleSink {
+public:
+    explicit FileSink(const std::string &path) : path_(path) {}
+
+    bool open() override {
+        is_open_ = open_file();
+        return is_open_;
+    }
+
+    bool write(const SampleBatch &batch) override {
+        return is_open_ && write_file(batch);
+    }
+
+    void poll() override {
+        if (is_open_ || std::chrono::steady_clock::now() < retry_at_) return;
+        if (open_file()) {
+            is_open_ = true;
+            std::cerr << "  📄 Sink file " << path_ << " reopened" << std::endl;
+        } else {
+            retry_at_ = std::chrono::steady_clock::now() + std::chrono::milliseconds(SINK_REOPEN_RETRY_MS);
+        }
+    }
+
+    void reopen() override {
+        close_file();
+        is_open_ = open_file();
+        if (!is_open_) {
+            std::cerr << "⚠️  Cannot reopen sink file " << path_ << ", retrying every "
+                      << SINK_REOPEN_RETRY_MS / 1000 << " s" << std::endl;
+            retry_at_ = std::chrono::steady_clock::now() + std::chrono::milliseconds(SINK_REOPEN_RETRY_MS);
+        }
+    }
+
+    void close() override {
+        close_file();
+        is_open_ = false;
+    }
+
+protected:
+    std::string path_;
+
+    virtual bool open_file() = 0;
+    virtual bool write_file(const SampleBatch &batch) = 0;
+    virtual void close_file() = 0;
+
+private:
+    bool is_open_ = false;
+    std::chrono::steady_clock::time_point retry_at_;
+};
+
+class CsvFileSink : public FileSink {
+public:
+    CsvFileSink(const std::string &path, TimestampPrecision precision) : FileSink(path) {
+        csv_.set_timestamp_precision(precision);
+    }
+
+private:
+    CsvLogWriter csv_;
+
+    bool open_file() override { return csv_.open(path_); }
+
+    bool write_file(const SampleBatch &batch) override {
+        for (const LiveSample &s : batch.samples) csv_.append(s.rec);
+        return csv_.flush();
+    }
+
+    void close_file() override { csv_.close(); }
+};
+
+class BinaryFileSink : public FileSink {
+public:
+    explicit BinaryFileSink(const std::string &path) : FileSink(path) {}
+
+private:
+    BinaryLogWriter bin_;
+
+    bool open_file() override { return bin_.open(path_); }
+
+    bool write_file(const SampleBatch &batch) override {
+        bool ok = true;
+        for (const LiveSample &s : batch.samples) ok = bin_.append(s.rec) && ok;
+        return bin_.flush() && ok;
+    }
+
+    void close_file() override { bin_.close(); }
+};
+
+class JsonLinesSink : public SampleSink {
+public:
+    bool open() override { return true; }
+
+    bool write(const SampleBatch &batch) override {
+        const std::string &lines = batch.json_lines();
+        fwrite(lines.data(), 1, lines.size(), stdout);
+        return fflush(stdout) == 0;
+    }
+};
+
+// Whole lines per datagram, so a receiver can parse each one on its own
+class UdpSink : public SampleSink {
+public:
+    UdpSink(const std::string &host, const std::string &port) : host_(host), port_(port) {}
+    ~UdpSink() { close(); }
+
+    bool open() override {
+        struct addrinfo hints, *res = nullptr;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_DGRAM;
+        int rc = getaddrinfo(host_.c_str(), port_.c_str(), &hints, &res);
+        if (rc != 0) {
+            std::cerr << "❌ UDP sink " << host_ << ":" << port_ << ": " << gai_strerror(rc) << std::endl;
+            return false;
+        }
+        for (struct addrinfo *ai = res; ai != nullptr && fd_ == -1; ai = ai->ai_next) {
+            fd_ = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+            if (fd_ != -1 && connect(fd_, ai->ai_addr, ai->ai_addrlen) == -1) {
+                ::close(fd_);
+                fd_ = -1;
+            }
+        }
+        freeaddrinfo(res);
+        if (fd_ == -1) {
+            std::cerr << "❌ UDP sink " << host_ << ":" << port_ << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool write(const SampleBatch &batch) override {
+        const std::string &lines = batch.json_lines();
+        bool ok = true;
+        size_t start = 0;
+        while (start < lines.size()) {
+            // Extend to as many complete lines as fit
+            size_t end = lines.find('\n', start) + 1;
+            while (end < lines.size()) {
+                size_t next = lines.find('\n', end) + 1;
+                if (next - start > SINK_UDP_MAX_DATAGRAM) break;
+                end = next;
+            }
+            // ECONNREFUSED only reports that nobody listened to an earlier one
+            if (send(fd_, lines.data() + start, end - start, 0) == -1 && errno != ECONNREFUSED) ok = false;
+            start = end;
+        }
+        return ok;
+    }
+
+    void close() override {
+        if (fd_ == -1) return;
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+private:
+    std::string host_, port_;
+    int fd_ = -1;
+};
+
+// Modbus TCP server with the newest sample, for PLCs and SCADA. Holding
+// and input registers carry the same values, floats in the sensor's ABCD
+// order:
+//   0-1 temperature   2-3 raw EC   4-5 sensor EC   6-7 smart EC   8-9 k
+//   10  flags (bit 0 sensor pass, bit 1 smart pass)
+//   11-12 Unix time of the sample, seconds    13-14 sample number
+// Clients are served from the sink's own server thread; write() only
+// updates the register map under a mutex.
+const int SINK_MODBUS_TCP_REGISTERS = 15;
+
+class ModbusTcpSink : public SampleSink {
+public:
+    ModbusTcpSink(const std::string &addr, int port) : addr_(addr), port_(port) {}
+    ~ModbusTcpSink() { close(); }
+
+    bool open() override {
+        ctx_ = modbus_new_tcp(addr_.empty() ? nullptr : addr_.c_str(), port_);
+        map_ = modbus_mapping_new(0, 0, SINK_MODBUS_TCP_REGISTERS, SINK_MODBUS_TCP_REGISTERS);
+        if (ctx_ == nullptr || map_ == nullptr) {
+            std::cerr << "❌ Modbus TCP sink: " << modbus_strerror(errno) << std::endl;
+            close();
+            return false;
+        }
+        listen_fd_ = modbus_tcp_listen(ctx_, SINK_MODBUS_TCP_MAX_CLIENTS);
+        if (listen_fd_ == -1) {
+            std::cerr << "❌ Modbus TCP sink: cannot listen on port " << port_ << ": "
+                      << modbus_strerror(errno) << std::endl;
+            close();
+            return false;
+        }
+        running_ = true;
+        thread_ = std::thread(&ModbusTcpSink::serve, this);
+        return true;
+    }
+
+    bool write(const SampleBatch &batch) override {
+        if (batch.samples.empty()) return true;
+        const LiveSample &s = batch.samples.back();
+        uint16_t regs[SINK_MODBUS_TCP_REGISTERS];
+        sample_float_to_regs(s.rec.temp, regs + 0);
+        sample_float_to_regs(s.rec.raw_ec, regs + 2);
+        sample_float_to_regs(s.rec.sensor_ec, regs + 4);
+        sample_float_to_regs(s.rec.smart_ec, regs + 6);
+        sample_float_to_regs(s.rec.k, regs + 8);
+        regs[10] = static_cast<uint16_t>(s.rec.flags & (SAMPLE_FLAG_SENSOR_PASS | SAMPLE_FLAG_SMART_PASS));
+        uint32_t secs = static_cast<uint32_t>(s.rec.timestamp_ns / 1000000000LL);
+        uint32_t seq = static_cast<uint32_t>(s.sample_count);
+        regs[11] = static_cast<uint16_t>(secs >> 16);
+        regs[12] = static_cast<uint16_t>(secs & 0xFFFF);
+        regs[13] = static_cast<uint16_t>(seq >> 16);
+        regs[14] = static_cast<uint16_t>(seq & 0xFFFF);
+
+        std::lock_guard<std::mutex> lock(map_mutex_);
+        memcpy(map_->tab_registers, regs, sizeof(regs));
+        memcpy(map_->tab_input_registers, regs, sizeof(regs));
+        return true;
+    }
+
+    void close() override {
+        running_ = false;
+        if (thread_.joinable()) thread_.join();
+        for (int fd : clients_) ::close(fd);
+        clients_.clear();
+        if (listen_fd_ != -1) ::close(listen_fd_);
+        listen_fd_ = -1;
+        if (map_ != nullptr) modbus_mapping_free(map_);
+        map_ = nullptr;
+        if (ctx_ != nullptr) modbus_free(ctx_);
+        ctx_ = nullptr;
+    }
+
+private:
+    std::string addr_;
+    int port_;
+    modbus_t *ctx_ = nullptr;
+    modbus_mapping_t *map_ = nullptr;
+    std::mutex map_mutex_;
+    int listen_fd_ = -1;
+    std::vector<int> clients_;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+
+    void serve() {
+        uint8_t query[MODBUS_TCP_MAX_ADU_LENGTH];
+        std::vector<struct pollfd> fds;
+        while (running_) {
+            fds.clear();
+            fds.push_back({listen_fd_, POLLIN, 0});
+            for (int fd : clients_) fds.push_back({fd, POLLIN, 0});
+            if (::poll(fds.data(), fds.size(), SINK_MODBUS_TCP_POLL_MS) <= 0) continue;
+
+            for (size_t i = 1; i < fds.size(); i++) {
+                if (fds[i].revents == 0) continue;
+                modbus_set_socket(ctx_, fds[i].fd);
+                int rc = modbus_receive(ctx_, query);
+                if (rc > 0) {
+                    std::lock_guard<std::mutex> lock(map_mutex_);
+                    modbus_reply(ctx_, query, rc, map_);
+                } else if (rc == -1) {
+                    ::close(fds[i].fd);
+                    clients_.erase(std::find(clients_.begin(), clients_.end(), fds[i].fd));
+                }
+            }
+            if (fds[0].revents & POLLIN) {
+                int fd = modbus_tcp_accept(ctx_, &listen_fd_);
+                if (fd == -1) continue;
+                if (clients_.size() >= static_cast<size_t>(SINK_MODBUS_TCP_MAX_CLIENTS)) {
+                    ::close(fd);
+                } else {
+                    clients_.push_back(fd);
+                }
+            }
+        }
+    }
+};
+
+// MQTT publisher. Samples are collected for `window` ms (or up to
+// MQTT_MAX_SAMPLES_PER_MESSAGE) and published as one message to
+// TOPIC/SENSOR, as JSON lines (the batch's shared text) or the compact
+// binary layout (ec_mqtt.h). Undeliverable messages go to the spool and
+// are replayed, oldest first, before anything new once the broker is back.
+struct MqttSinkConfig {
+    std::string host;
+    std::string port = MQTT_DEFAULT_PORT;
+    std::string topic = "ec";                // Topic prefix
+    std::string sensor = "ec4a";             // Per-sensor topic level
+    std::string client_id;                   // Default: smart_logger-<hostname>-<pid>
+    int qos = 1;
+    int window_ms = 1000;
+    bool binary = false;                     // payload=binary instead of json
+    std::string spool = "ec_mqtt.spool";
+    uint64_t spool_max_mb = MQTT_SPOOL_DEFAULT_MAX_MB;
+};
+
+// HOST[:PORT][,topic=T][,sensor=S][,qos=0|1|2][,window=MS][,payload=json|binary]
+//   [,spool=PATH][,spool-mb=N][,client=ID]
+inline bool parse_mqtt_target(const std::string &target, MqttSinkConfig &cfg) {
+    size_t comma = target.find(',');
+    std::string address = target.substr(0, comma);
+    size_t colon = address.rfind(':');
+    if (colon != std::string::npos && address.find(']', colon) == std::string::npos) {
+        cfg.port = address.substr(colon + 1);
+        address = address.substr(0, colon);
+    }
+    if (address.size() >= 2 && address.front() == '[' && address.back() == ']') {
+        address = address.substr(1, address.size() - 2);
+    }
+    cfg.host = address;
+    if (cfg.host.empty() || cfg.port.empty()) return false;
+
+    while (comma != std::string::npos) {
+        size_t next = target.find(',', comma + 1);
+        std::string option = target.substr(comma + 1, next == std::string::npos ? std::string::npos : next - comma - 1);
+        comma = next;
+        size_t eq = option.find('=');
+        std::string key = option.substr(0, eq);
+        std::string value = eq == std::string::npos ? std::string() : option.substr(eq + 1);
+        if (key == "topic") {
+            cfg.topic = value;
+        } else if (key == "sensor") {
+            cfg.sensor = value;
+        } else if (key == "qos" && (value == "0" || value == "1" || value == "2")) {
+            cfg.qos = value[0] - '0';
+        } else if (key == "window" && std::atoi(value.c_str()) >= 0) {
+            cfg.window_ms = std::atoi(value.c_str());
+        } else if (key == "payload" && (value == "json" || value == "binary")) {
+            cfg.binary = value == "binary";
+        } else if (key == "spool" && !value.empty()) {
+            cfg.spool = value;
+        } else if (key == "spool-mb" && std::atoi(value.c_str()) > 0) {
+            cfg.spool_max_mb = static_cast<uint64_t>(std::atoi(value.c_str()));
+        } else if (key == "client" && !value.empty()) {
+            cfg.client_id = value;
+        } else {
+            std::cerr << "⚠️  Unknown or invalid MQTT option '" << option << "'" << std::endl;
+            return false;
+        }
+    }
+    if (cfg.client_id.empty()) {
+        char host[64] = "host";
+        gethostname(host, sizeof(host) - 1);
+        cfg.client_id = "smart_logger-" + std::string(host) + "-" + std::to_string(getpid());
+    }
+    return true;
+}
+
+class MqttSink : public SampleSink {
+public:
+    explicit MqttSink(const MqttSinkConfig &cfg) : cfg_(cfg) {
+        topic_ = cfg.topic.empty() ? cfg.sensor : cfg.topic + "/" + cfg.sensor;
+    }
+
+    bool open() override {
+        if (!spool_.open(cfg_.spool, cfg_.spool_max_mb << 20)) return false;
+        // A broker that is down at start-up is not fatal: messages spool
+        // until it can be reached
+        if (connect()) {
+            std::cout << "  📡 MQTT connected to " << cfg_.host << ":" << cfg_.port << ", topic " << topic_
+                      << std::endl;
+        }
+        return true;
+    }
+
+    bool write(const SampleBatch &batch) override {
+        if (batch.samples.empty()) return true;
+        if (pending_samples_ == 0) {
+            window_start_ms_ = mqtt_now_ms();
+            if (cfg_.binary) mqtt_binary_begin(payload_);
+            else payload_.clear();
+        }
+        if (cfg_.binary) {
+            for (const LiveSample &s : batch.samples) mqtt_binary_append(payload_, s.rec);
+        } else {
+            payload_ += batch.json_lines();
+        }
+        pending_samples_ += batch.samples.size();
+        return pending_samples_ < MQTT_MAX_SAMPLES_PER_MESSAGE || flush();
+    }
+
+    void poll() override {
+        if (pending_samples_ > 0 && mqtt_now_ms() - window_start_ms_ >= cfg_.window_ms) flush();
+        if (!client_.connected()) {
+            if (mqtt_now_ms() < retry_at_ms_ || !connect()) return;
+            std::cerr << "  📡 MQTT reconnected to " << cfg_.host << ":" << cfg_.port << std::endl;
+        }
+        if (!replay() || !client_.keepalive()) lost();
+    }
+
+    void close() override {
+        if (pending_samples_ > 0) flush();
+        if (client_.connected()) {
+            replay();
+            client_.disconnect();
+        }
+        spool_.close();
+    }
+
+    uint64_t backlog_bytes() const override { return spool_.bytes(); }
+
+private:
+    MqttSinkConfig cfg_;
+    std::string topic_;
+    MqttClient client_;
+    MqttSpool spool_;
+    std::string payload_;
+    size_t pending_samples_ = 0;
+    int64_t window_start_ms_ = 0;
+    int64_t retry_at_ms_ = 0;
+    int retry_ms_ = MQTT_RETRY_MIN_MS;
+
+    // Reports only the first failure of an outage
+    bool connect() {
+        if (client_.connect(cfg_.host, cfg_.port, cfg_.client_id, retry_ms_ == MQTT_RETRY_MIN_MS)) {
+            retry_ms_ = MQTT_RETRY_MIN_MS;
+            return true;
+        }
+        retry_at_ms_ = mqtt_now_ms() + retry_ms_;
+        retry_ms_ = std::min(retry_ms_ * 2, MQTT_RETRY_MAX_MS);
+        return false;
+    }
+
+    void lost() {
+        if (client_.connected()) return;
+        std::cerr << "⚠️  MQTT connection to " << cfg_.host << ":" << cfg_.port << " lost; spooling to "
+                  << cfg_.spool << std::endl;
+        retry_at_ms_ = mqtt_now_ms() + retry_ms_;
+    }
+
+    // Publish the pending message, behind anything already spooled
+    bool flush() {
+        pending_samples_ = 0;
+        if (client_.connected() && spool_.empty()) {
+            if (client_.publish(topic_, payload_.data(), payload_.size(), cfg_.qos)) return true;
+            lost();
+        }
+        return spool_.append(cfg_.qos, topic_, payload_.data(), payload_.size());
+    }
+
+    // Deliver the spool, oldest first; false if the connection dropped
+    bool replay() {
+        uint8_t qos;
+        std::string topic, payload;
+        while (client_.connected() && spool_.front(qos, topic, payload)) {
+            if (!client_.publish(topic, payload.data(), payload.size(), qos)) return false;
+            spool_.pop();
+        }
+        return client_.connected();
+    }
+};
+
+// ===========================
+// SINK SPECIFICATION
+// ===========================
+struct SinkSpec {
+    std::string name;        // As given, without the policy suffix (metrics label)
+    std::string kind;        // csv, bin, jsonl, udp, modbus-tcp, mqtt
+    std::string target;      // Everything after "kind:"
+    SinkPolicy policy = SINK_POLICY_DROP;
+};
+
+// KIND[:TARGET][@drop|@block]
+inline bool parse_sink_spec(const std::string &text, SinkSpec &spec) {
+    spec = SinkSpec();
+    spec.name = text;
+    size_t at = text.rfind('@');
+    if (at != std::string::npos) {
+        std::string policy = text.substr(at + 1);
+        if (policy == "drop") {
+            spec.policy = SINK_POLICY_DROP;
+        } else if (policy == "block") {
+            spec.policy = SINK_POLICY_BLOCK;
+        } else {
+            std::cerr << "⚠️  Unknown sink policy '" << policy << "' in " << text << std::endl;
+            return false;
+        }
+        spec.name = text.substr(0, at);
+    }
+    size_t colon = spec.name.find(':');
+    spec.kind = spec.name.substr(0, colon);
+    if (colon != std::string::npos) spec.target = spec.name.substr(colon + 1);
+
+    bool needs_target = spec.kind != "jsonl";
+    if (spec.kind != "csv" && spec.kind != "bin" && spec.kind != "jsonl" && spec.kind != "udp" &&
+        spec.kind != "modbus-tcp" && spec.kind != "mqtt") {
+        std::cerr << "⚠️  Unknown sink '" << spec.kind << "' (csv, bin, jsonl, udp, modbus-tcp, mqtt)" << std::endl;
+        return false;
+    }
+    if (needs_target && spec.target.empty()) {
+        std::cerr << "⚠️  Sink " << text << " needs a target, e.g. " << spec.kind
+                  << (spec.kind == "udp" ? ":HOST:PORT" : spec.kind == "modbus-tcp" ? ":PORT"
+                      : spec.kind == "mqtt" ? ":HOST" : ":PATH")
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// HOST:PORT, [V6ADDR]:PORT, or PORT alone (empty host)
+inline bool split_host_port(const std::string &text, std::string &host, std::string &port) {
+    size_t colon = text.rfind(':');
+    if (colon == std::string::npos) {
+        host.clear();
+        port = text;
+    } else {
+        host = text.substr(0, colon);
+        port = text.substr(colon + 1);
+        if (host.size() >= 2 && host.front() == '[' && host.back() == ']') host = host.substr(1, host.size() - 2);
+    }
+    return !port.empty() && port.find_first_not_of("0123456789") == std::string::npos;
+}
+
+// nullptr (with a message) if the target does not parse
+inline std::unique_ptr<SampleSink> make_sample_sink(const SinkSpec &spec, TimestampPrecision precision) {
+    std::string host, port;
+    if (spec.kind == "csv") return std::unique_ptr<SampleSink>(new CsvFileSink(spec.target, precision));
+    if (spec.kind == "bin") return std::unique_ptr<SampleSink>(new BinaryFileSink(spec.target));
+    if (spec.kind == "jsonl") {
+        if (!spec.target.empty() && spec.target != "-") {
+            std::cerr << "⚠️  jsonl sink writes to stdout only ('jsonl' or 'jsonl:-')" << std::endl;
+            return nullptr;
+        }
+        return std::unique_ptr<SampleSink>(new JsonLinesSink());
+    }
+    if (spec.kind == "mqtt") {
+        MqttSinkConfig cfg;
+        if (!parse_mqtt_target(spec.target, cfg)) {
+            std::cerr << "⚠️  Sink " << spec.name << ": expected mqtt:HOST[:PORT][,key=value...]" << std::endl;
+            return nullptr;
+        }
+        return std::unique_ptr<SampleSink>(new MqttSink(cfg));
+    }
+    if (!split_host_port(spec.target, host, port)) {
+        std::cerr << "⚠️  Sink " << spec.name << ": bad address, expected "
+                  << (spec.kind == "udp" ? "HOST:PORT" : "[ADDR:]PORT") << std::endl;
+        return nullptr;
+    }
+    if (spec.kind == "udp") {
+        if (host.empty()) host = "127.0.0.1";
+        return std::unique_ptr<SampleSink>(new UdpSink(host, port));
+    }
+    return std::unique_ptr<SampleSink>(new ModbusTcpSink(host, std::atoi(port.c_str())));
+}
+
+// ===========================
+// SINK CHANNEL
+// ===========================
+// One sink's queue and thread. The fan-out (single producer) pushes batch
+// pointers; the channel thread drains them in order, writes each and
+// closes the sink once stopped and drained. When the queue is full, DROP
+// discards the batch and counts its samples; BLOCK waits for room, which
+// stalls the pipeline's sink stage and, once its queues fill, makes
+// acquisition drop instead.
+struct SinkStats {
+    std::string name;
+    SinkPolicy policy = SINK_POLICY_DROP;
+    uint64_t batches = 0;        // Batches written
+    uint64_t records = 0;        // Samples written
+    uint64_t dropped = 0;        // Samples dropped (queue full, DROP policy)
+    uint64_t errors = 0;         // Batches whose write() failed
+    uint64_t blocked_ns = 0;     // Time the fan-out waited (BLOCK policy)
+    uint64_t backlog_bytes = 0;  // Held for later delivery (MQTT spool)
+    size_t depth = 0;            // Batches queued
+    size_t max_depth = 0;
+};
+
+class SinkChannel {
+public:
+    SinkChannel(const SinkSpec &spec, std::unique_ptr<SampleSink> sink)
+        : spec_(spec), sink_(std::move(sink)) {}
+    ~SinkChannel() { stop(); }
+    SinkChannel(const SinkChannel &) = delete;
+    SinkChannel &operator=(const SinkChannel &) = delete;
+
+    void start() {
+        running_ = true;
+        thread_ = std::thread(&SinkChannel::run, this);
+    }
+
+    // Fan-out thread only
+    void push(const SampleBatchRef &batch) {
+        if (!queue_.try_push(batch)) {
+            if (spec_.policy == SINK_POLICY_DROP) {
+                dropped_.fetch_add(batch->samples.size(), std::memory_order_relaxed);
+                return;
+            }
+            auto start = std::chrono::steady_clock::now();
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (!queue_.try_push(batch)) {
+                wake_.notify_one();
+                space_.wait_for(lock, std::chrono::milliseconds(1));
+            }
+            auto waited = std::chrono::steady_clock::now() - start;
+            blocked_ns_.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count(),
+                                  std::memory_order_relaxed);
+        }
+        size_t depth = queue_.size();
+        if (depth > max_depth_.load(std::memory_order_relaxed)) {
+            max_depth_.store(depth, std::memory_order_relaxed);
+        }
+        wake_.notify_one();
+    }
+
+    // Any thread, never waits: the channel drains what is queued, closes
+    // the sink and ends its thread; stop() then only joins it
+    void request_stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+        }
+        wake_.notify_one();
+    }
+
+    void stop() {
+        if (!thread_.joinable()) return;
+        request_stop();
+        thread_.join();
+    }
+
+    const SinkSpec &spec() const { return spec_; }
+
+    // Any thread: the sink reopens its files before its next write
+    void request_reopen() {
+        reopen_.store(true, std::memory_order_relaxed);
+        wake_.notify_one();
+    }
+
+    SinkStats stats() const {
+        SinkStats s;
+        s.name = spec_.name;
+        s.policy = spec_.policy;
+        s.batches = batches_.load(std::memory_order_relaxed);
+        s.records = records_.load(std::memory_order_relaxed);
+        s.dropped = dropped_.load(std::memory_order_relaxed);
+        s.errors = errors_.load(std::memory_order_relaxed);
+        s.blocked_ns = blocked_ns_.load(std::memory_order_relaxed);
+        s.backlog_bytes = sink_->backlog_bytes();
+        s.depth = queue_.size();
+        s.max_depth = max_depth_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    SinkSpec spec_;
+    std::unique_ptr<SampleSink> sink_;
+    SpscRing<SampleBatchRef, SINK_QUEUE_CAPACITY> queue_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable wake_, space_;
+    bool running_ = false;
+    std::atomic<bool> reopen_{false};
+    std::atomic<uint64_t> batches_{0}, records_{0}, dropped_{0}, errors_{0}, blocked_ns_{0};
+    std::atomic<size_t> max_depth_{0};
+
+    void run() {
+        SampleBatchRef batch[SINK_DRAIN_MAX];
+        while (true) {
+            if (reopen_.exchange(false, std::memory_order_relaxed)) sink_->reopen();
+            size_t n = queue_.pop_batch(batch, SINK_DRAIN_MAX);
+            if (n == 0) {
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (!running_ && queue_.size() == 0) break;
+                wake_.wait_for(lock, std::chrono::milliseconds(SINK_IDLE_MS));
+                lock.unlock();
+                sink_->poll();
+                continue;
+            }
+            space_.notify_one();
+            for (size_t i = 0; i < n; i++) {
+                if (!sink_->write(*batch[i])) errors_.fetch_add(1, std::memory_order_relaxed);
+                batches_.fetch_add(1, std::memory_order_relaxed);
+                records_.fetch_add(batch[i]->samples.size(), std::memory_order_relaxed);
+                batch[i].reset();
+            }
+            sink_->poll();
+        }
+        sink_->close();
+    }
+};
+
+// ===========================
+// SINK FAN-OUT
+// ===========================
+// add() and publish() belong to one thread (the pipeline's sink stage);
+// stats() may be called from any thread once start() has run.
+//
+// Sinks from the config file (ec_config.h) can change while running.
+// set_config_sinks() runs on the reloading thread and does the slow part
+// there (opening new sinks, e.g. an MQTT connect); it only queues the new
+// list. The fan-out thread switches to it at its next add() or publish(),
+// under the mutex that stats() and reopen() take, and asks the removed
+// channels to stop without waiting for them. They drain and close on
+// their own threads and are joined later by set_config_sinks() or stop().
+// add() and publish() themselves never lock.
+class SinkFanout {
+public:
+    ~SinkFanout() { stop(); }
+
+    // Timestamps in the JSON lines and CSV sinks. Call before add_sink().
+    void set_timestamp_precision(TimestampPrecision precision) { precision_ = precision; }
+
+    // Opens the sink now; false (already reported) if it cannot be used.
+    // Call before start().
+    bool add_sink(const SinkSpec &spec) {
+        std::unique_ptr<SampleSink> sink = make_sample_sink(spec, precision_);
+        if (!sink || !sink->open()) return false;
+        channels_.emplace_back(new SinkChannel(spec, std::move(sink)));
+        fixed_ = channels_.size();
+        return true;
+    }
+
+    void start() {
+        for (auto &ch : channels_) ch->start();
+    }
+
+    // After start(), from one thread at a time, never the fan-out thread.
+    // Makes the config-file sinks match specs from the next batch on:
+    // unchanged ones keep running, new ones are opened and started here,
+    // removed ones stop once the fan-out has switched. The add_sink() ones
+    // are never touched.
+    void set_config_sinks(const std::vector<SinkSpec> &specs) {
+        join_retired();
+
+        std::vector<ChannelRef> candidates;   // Running or already prepared
+        {
+            std::lock_guard<std::mutex> lock(channels_mutex_);
+            candidates.assign(channels_.begin() + fixed_, channels_.end());
+            for (auto &ch : next_) {
+                if (std::find(candidates.begin(), candidates.end(), ch) == candidates.end()) {
+                    candidates.push_back(ch);
+                }
+            }
+        }
+        std::vector<ChannelRef> next;
+        for (const SinkSpec &spec : specs) {
+            auto same = std::find_if(candidates.begin(), candidates.end(), [&](const ChannelRef &ch) {
+                return ch && ch->spec().name == spec.name && ch->spec().policy == spec.policy;
+            });
+            if (same != candidates.end()) {
+                next.push_back(*same);
+                same->reset();
+                continue;
+            }
+            std::unique_ptr<SampleSink> sink = make_sample_sink(spec, precision_);
+            if (!sink || !sink->open()) continue;
+            next.emplace_back(new SinkChannel(spec, std::move(sink)));
+            next.back()->start();
+            std::cout << "  ➜ Sink " << spec.name << " added from config" << std::endl;
+        }
+
+        std::lock_guard<std::mutex> lock(channels_mutex_);
+        // A list prepared earlier but not switched to yet: its new
+        // channels that are not reused never got a batch
+        for (auto &ch : next_) {
+            bool kept = std::find(next.begin(), next.end(), ch) != next.end();
+            bool live = std::find(channels_.begin() + fixed_, channels_.end(), ch) != channels_.end();
+            if (!kept && !live) {
+                ch->request_stop();
+                retired_.push_back(ch);
+            }
+        }
+        next_ = std::move(next);
+        switch_pending_.store(true, std::memory_order_release);
+    }
+
+    bool empty() const { return channels_.empty(); }
+    size_t size() const { return channels_.size(); }
+
+    // Collects into the pending batch; full batches go out at once
+    void add(const LiveSample &sample) {
+        if (switch_pending_.load(std::memory_order_acquire)) switch_channels();
+        if (channels_.empty()) return;
+        if (!pending_) {
+            pending_ = std::make_shared<SampleBatch>(precision_);
+            pending_->samples.reserve(SINK_BATCH_MAX);
+        }
+        pending_->samples.push_back(sample);
+        if (pending_->samples.size() >= SINK_BATCH_MAX) publish();
+    }
+
+    // Hands the pending batch to every sink
+    void publish() {
+        if (switch_pending_.load(std::memory_order_acquire)) switch_channels();
+        if (!pending_) return;
+        SampleBatchRef batch(std::move(pending_));
+        pending_.reset();
+        for (auto &ch : channels_) ch->push(batch);
+    }
+
+    // Any thread: every sink reopens its files (SIGHUP)
+    void reopen() {
+        std::lock_guard<std::mutex> lock(channels_mutex_);
+        for (auto &ch : channels_) ch->request_reopen();
+    }
+
+    // Publishes what is pending, then drains and closes every sink. Once
+    // the fan-out thread has finished.
+    void stop() {
+        publish();
+        for (auto &ch : channels_) ch->stop();
+        join_retired();
+    }
+
+    std::vector<SinkStats> stats() const {
+        std::lock_guard<std::mutex> lock(channels_mutex_);
+        std::vector<SinkStats> out;
+        out.reserve(channels_.size());
+        for (const auto &ch : channels_) out.push_back(ch->stats());
+        return out;
+    }
+
+private:
+    typedef std::shared_ptr<SinkChannel> ChannelRef;
+
+    TimestampPrecision precision_ = TIMESTAMP_SECONDS;
+    std::vector<ChannelRef> channels_;   // add_sink() ones first...
+    size_t fixed_ = 0;                   // ...this many
+    mutable std::mutex channels_mutex_;  // Guards channels_ changes, next_ and retired_
+    std::vector<ChannelRef> next_;       // Config sinks to switch to
+    std::atomic<bool> switch_pending_{false};
+    std::vector<ChannelRef> retired_;    // Stopping; joined outside the fan-out thread
+    std::shared_ptr<SampleBatch> pending_;
+
+    // Fan-out thread
+    void switch_channels() {
+        std::lock_guard<std::mutex> lock(channels_mutex_);
+        switch_pending_.store(false, std::memory_order_relaxed);
+        for (auto it = channels_.begin() + fixed_; it != channels_.end(); ++it) {
+            if (std::find(next_.begin(), next_.end(), *it) != next_.end()) continue;
+            (*it)->request_stop();
+            std::cout << "  ➜ Sink " << (*it)->spec().name << " removed by config" << std::endl;
+            retired_.push_back(std::move(*it));
+        }
+        channels_.resize(fixed_);
+        channels_.insert(channels_.end(), next_.begin(), next_.end());
+        next_.clear();
+    }
+
+    void join_retired() {
+        std::vector<ChannelRef> done;
+        {
+            std::lock_guard<std::mutex> lock(channels_mutex_);
+            done.swap(retired_);
+        }
+        for (auto &ch : done) ch->stop();
+    }
+};
+
+#endif // EC_SINKS_H
@@ -0,0 +1,85 @@
+#ifndef EC_SPSC_RING_H
+#define EC_SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// ===========================
+// LOCK-FREE SPSC RING BUFFER
+// ===========================
+// Bounded single-producer / single-consumer queue. Exactly one thread may
+// call try_push() and exactly one other thread may call try_pop()/
+// pop_batch(). Neither side ever blocks or allocates; a full ring makes
+// try_push() return false so the producer can count the drop and move on.
+// Items are normally trivially copyable; popping moves an item out of its
+// slot, so a ring of shared_ptrs releases each one once it is consumed.
+//
+// Capacity must be a power of two. Head and tail live on separate cache
+// lines, and each side caches the other's index to avoid bouncing the
+// line on every operation.
+
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscRing capacity must be a power of two");
+
+public:
+    SpscRing() : head_(0), tail_(0), cached_head_(0), cached_tail_(0) {}
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    // Producer side
+    bool try_push(const T &item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ == Capacity) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ == Capacity) return false;
+        }
+        slots_[tail & (Capacity - 1)] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool try_pop(T &item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) return false;
+        }
+        item = std::move(slots_[head & (Capacity - 1)]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: pop up to max_items in one go, returns how many
+    size_t pop_batch(T *out, size_t max_items) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        cached_tail_ = tail_.load(std::memory_order_acquire);
+        size_t available = cached_tail_ - head;
+        size_t n = available < max_items ? available : max_items;
+        for (size_t i = 0; i < n; i++) {
+            out[i] = std::move(slots_[(head + i) & (Capacity - 1)]);
+        }
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    // Approximate depth; exact only when called from one of the two sides
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    alignas(64) std::atomic<size_t> head_;   // Next slot to read (consumer)
+    alignas(64) std::atomic<size_t> tail_;   // Next slot to write (producer)
+    alignas(64) size_t cached_head_;         // Producer's view of head_
+    alignas(64) size_t cached_tail_;         // Consumer's view of tail_
+    alignas(64) T slots_[Capacity];
+};
+
+#endif // EC_SPSC_RING_H
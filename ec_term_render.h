@@ -0,0 +1,145 @@
+#ifndef EC_TERM_RENDER_H
+#define EC_TERM_RENDER_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+// ===========================
+// DIFFERENTIAL TERMINAL RENDERER
+// ===========================
+// Full-screen text (the dashboards) is printed into a back buffer, which
+// end_frame() compares line by line with the frame currently on screen.
+// Only changed lines are sent, each as a cursor move plus its new text,
+// and the whole update goes out in a single write(): no shell spawned to
+// clear the screen, no flicker, and only a few hundred bytes per second on
+// a slow SSH link.
+//
+// Within a changed line the unchanged leading ASCII is skipped as well.
+// Past the first multi-byte character the column of a byte is not known
+// (emoji are one or two cells depending on the terminal), so the rest of
+// the line is rewritten from there. The same goes for the first control
+// byte: an escape sequence (colour, highlight) takes no column, and the
+// rewritten part has to repeat it to keep its attributes.
+//
+// Anything else writing to the terminal (warnings on stderr) puts the
+// screen out of step with the previous frame; invalidate() makes the next
+// frame a full repaint, which also happens every RENDER_FULL_REDRAW_FRAMES
+// frames and whenever the window size changes. A frame taller than the
+// window loses its top lines, as it did when the terminal scrolled.
+
+const unsigned RENDER_FULL_REDRAW_FRAMES = 60;
+
+class TerminalRenderer {
+public:
+    explicit TerminalRenderer(int fd = STDOUT_FILENO) : fd_(fd) {}
+
+    // Stream to print the next frame into ('\n' separates lines)
+    std::ostream &begin_frame() {
+        frame_.str(std::string());
+        frame_.clear();
+        frame_.flags(std::ios_base::dec | std::ios_base::skipws);
+        frame_.precision(6);
+        frame_.fill(' ');
+        return frame_;
+    }
+
+    // Send the difference to the previous frame. Returns false if the
+    // terminal write failed.
+    bool end_frame() {
+        split_lines(frame_.str(), next_);
+        bool full = resized() || !drawn_ || ++frames_since_full_ >= RENDER_FULL_REDRAW_FRAMES;
+        if (rows_ > 1 && next_.size() > rows_ - 1u) {
+            next_.erase(next_.begin(), next_.end() - (rows_ - 1));
+        }
+
+        out_.clear();
+        if (full) frames_since_full_ = 0;
+        for (size_t row = 0; row < next_.size(); row++) {
+            const std::string &line = next_[row];
+            size_t from = 0;
+            if (!full && row < lines_.size()) {
+                if (lines_[row] == line) continue;
+                from = ascii_prefix(lines_[row], line);
+            }
+            move_to(row, from);
+            out_.append(line, from, std::string::npos);
+            out_ += "\033[K";
+        }
+        // Park the cursor below the frame, clearing what is left of a
+        // longer previous frame
+        move_to(next_.size(), 0);
+        if (full || next_.size() < lines_.size()) out_ += "\033[J";
+
+        lines_.swap(next_);
+        drawn_ = true;
+        return write_all(out_);
+    }
+
+    // Repaint everything next frame (the screen was written to by others)
+    void invalidate() { drawn_ = false; }
+
+private:
+    int fd_;
+    std::ostringstream frame_;
+    std::vector<std::string> lines_;     // On screen
+    std::vector<std::string> next_;
+    std::string out_;                    // Escape sequences + text, one write()
+    bool drawn_ = false;
+    unsigned frames_since_full_ = 0;
+    unsigned short rows_ = 0, cols_ = 0;
+
+    static void split_lines(const std::string &text, std::vector<std::string> &out) {
+        size_t n = 0, start = 0;
+        while (start < text.size()) {
+            size_t end = text.find('\n', start);
+            if (end == std::string::npos) end = text.size();
+            if (n == out.size()) out.emplace_back();
+            out[n++].assign(text, start, end - start);
+            start = end + 1;
+        }
+        out.resize(n);
+    }
+
+    // Leading bytes both lines share that are printable ASCII (1 byte = 1 column)
+    static size_t ascii_prefix(const std::string &a, const std::string &b) {
+        size_t n = 0, max = a.size() < b.size() ? a.size() : b.size();
+        while (n < max && a[n] == b[n] && a[n] >= 0x20 && a[n] < 0x7F) n++;
+        return n;
+    }
+
+    void move_to(size_t row, size_t col) {
+        char buf[32];
+        int len = snprintf(buf, sizeof(buf), "\033[%zu;%zuH", row + 1, col + 1);
+        out_.append(buf, len);
+    }
+
+    bool resized() {
+        struct winsize ws;
+        if (ioctl(fd_, TIOCGWINSZ, &ws) != 0) return false;
+        bool changed = ws.ws_row != rows_ || ws.ws_col != cols_;
+        rows_ = ws.ws_row;
+        cols_ = ws.ws_col;
+        return changed;
+    }
+
+    bool write_all(const std::string &s) {
+        size_t done = 0;
+        while (done < s.size()) {
+            ssize_t n = ::write(fd_, s.data() + done, s.size() - done);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            done += static_cast<size_t>(n);
+        }
+        return true;
+    }
+};
+
+#endif // EC_TERM_RENDER_H
@@ -0,0 +1,139 @@
+#ifndef EC_TIMESTAMP_H
+#define EC_TIMESTAMP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+// ===========================
+// SAMPLE CLOCK
+// ===========================
+// Each acquisition cycle reads the clocks exactly once. The wall-clock
+// time is what every output (dashboard, CSV, binary logs) prints for that
+// sample, so they can never disagree across a second boundary; the
+// monotonic time paces the loop and is immune to NTP steps.
+
+struct SampleClock {
+    int64_t realtime_ns;    // CLOCK_REALTIME, nanoseconds since epoch
+    int64_t monotonic_ns;   // CLOCK_MONOTONIC
+};
+
+inline int64_t timespec_to_ns(const struct timespec &ts) {
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+inline SampleClock sample_clock_now() {
+    struct timespec rt, mono;
+    clock_gettime(CLOCK_REALTIME, &rt);
+    clock_gettime(CLOCK_MONOTONIC, &mono);
+    SampleClock c;
+    c.realtime_ns = timespec_to_ns(rt);
+    c.monotonic_ns = timespec_to_ns(mono);
+    return c;
+}
+
+// ===========================
+// TIMESTAMP FORMATTER
+// ===========================
+// "YYYY-MM-DD HH:MM:SS[.mmm|.nnnnnnnnn]" in local time, without calling
+// localtime_r()/strftime() per sample. localtime_r() runs at most once per
+// TIMESTAMP_WINDOW_S: it yields the date text and the UTC offset, which
+// stay valid until the next local midnight or the next UTC quarter hour
+// (DST transitions fall on those, including the half-hour zones),
+// whichever comes first. Within that window HH:MM:SS is plain arithmetic,
+// and is itself reused while the second does not change.
+//
+// Not thread-safe: use one formatter per thread.
+
+enum TimestampPrecision {
+    TIMESTAMP_SECONDS = 0,   // 2025-01-31 14:05:09 (the historical CSV format)
+    TIMESTAMP_MILLIS = 1,    // 2025-01-31 14:05:09.123
+    TIMESTAMP_NANOS = 2      // 2025-01-31 14:05:09.123456789
+};
+
+const size_t TIMESTAMP_MAX_CHARS = 30;   // Longest form plus NUL
+const int64_t TIMESTAMP_WINDOW_S = 900;
+
+class TimestampFormatter {
+public:
+    explicit TimestampFormatter(TimestampPrecision precision = TIMESTAMP_SECONDS)
+        : precision_(precision) {}
+
+    void set_precision(TimestampPrecision precision) { precision_ = precision; }
+    TimestampPrecision precision() const { return precision_; }
+
+    // Writes a NUL-terminated timestamp into buf (TIMESTAMP_MAX_CHARS bytes)
+    // and returns its length
+    size_t format(int64_t timestamp_ns, char *buf) {
+        int64_t secs = floor_div(timestamp_ns, 1000000000LL);
+        int64_t frac = timestamp_ns - secs * 1000000000LL;
+
+        if (secs != cached_sec_) {
+            if (secs < window_start_ || secs >= window_end_) load_window(secs);
+            int64_t sod = secs - local_midnight_;
+            put_digits(text_ + 11, static_cast<uint32_t>(sod / 3600), 2);
+            put_digits(text_ + 14, static_cast<uint32_t>(sod / 60 % 60), 2);
+            put_digits(text_ + 17, static_cast<uint32_t>(sod % 60), 2);
+            cached_sec_ = secs;
+        }
+
+        memcpy(buf, text_, 19);
+        size_t len = 19;
+        if (precision_ == TIMESTAMP_MILLIS) {
+            buf[len++] = '.';
+            put_digits(buf + len, static_cast<uint32_t>(frac / 1000000), 3);
+            len += 3;
+        } else if (precision_ == TIMESTAMP_NANOS) {
+            buf[len++] = '.';
+            put_digits(buf + len, static_cast<uint32_t>(frac), 9);
+            len += 9;
+        }
+        buf[len] = '\0';
+        return len;
+    }
+
+    std::string format(int64_t timestamp_ns) {
+        char buf[TIMESTAMP_MAX_CHARS];
+        size_t len = format(timestamp_ns, buf);
+        return std::string(buf, len);
+    }
+
+private:
+    TimestampPrecision precision_;
+    char text_[20] = "0000-00-00 00:00:00";
+    int64_t cached_sec_ = INT64_MIN;      // Second currently in text_
+    int64_t window_start_ = 0;            // [start, end): date and offset valid
+    int64_t window_end_ = 0;
+    int64_t local_midnight_ = 0;          // Epoch second of 00:00:00 local, this window
+
+    static int64_t floor_div(int64_t a, int64_t b) {
+        int64_t q = a / b;
+        return (a % b < 0) ? q - 1 : q;
+    }
+
+    static void put_digits(char *p, uint32_t value, int width) {
+        for (int i = width - 1; i >= 0; i--) {
+            p[i] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        }
+    }
+
+    void load_window(int64_t secs) {
+        time_t t = static_cast<time_t>(secs);
+        struct tm tm;
+        localtime_r(&t, &tm);
+        put_digits(text_, static_cast<uint32_t>(tm.tm_year + 1900), 4);
+        put_digits(text_ + 5, static_cast<uint32_t>(tm.tm_mon + 1), 2);
+        put_digits(text_ + 8, static_cast<uint32_t>(tm.tm_mday), 2);
+
+        local_midnight_ = secs - (tm.tm_hour * 3600 + tm.tm_min * 60 + tm.tm_sec);
+        int64_t start = floor_div(secs, TIMESTAMP_WINDOW_S) * TIMESTAMP_WINDOW_S;
+        int64_t end = start + TIMESTAMP_WINDOW_S;
+        window_start_ = start > local_midnight_ ? start : local_midnight_;
+        window_end_ = end < local_midnight_ + 86400 ? end : local_midnight_ + 86400;
+    }
+};
+
+#endif // EC_TIMESTAMP_H
@@ -0,0 +1,450 @@
+#ifndef EC_WAL_H
+#define EC_WAL_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/random.h>
+#include <sys/stat.h>
+
+#include "ec_sample.h"
+#include "ec_crc32.h"
+#include "ec_log_segment.h"
+
+// ===========================
+// WRITE-AHEAD LOG FORMAT (.ecw)
+// ===========================
+// Row-oriented append log built for crash safety rather than size:
+//
+//   [File header: 64 bytes][record][record] ...
+//
+//   record = [magic u32][type u16][length u16][crc32 u32][payload: length bytes]
+//
+// The CRC covers type, length and payload. Every run of the logger starts
+// with a SESSION record (session ID, start time), followed by one SAMPLE
+// record per sample. The file header carries the format version, the
+// sample payload schema version and the ID of the session that created
+// the segment.
+//
+// Recovery on open is O(tail): only the last WAL_TAIL_SCAN_BYTES are read.
+// The file is cut after the last intact record found there, so a torn
+// write never sits in front of new appends. A header that is unreadable
+// or from another schema version is never appended to; the file is moved
+// aside (ec_log_segment.h) and a new segment begins.
+//
+// Readers walk records from the header onwards; a record whose magic or
+// CRC does not check out is skipped byte by byte until the next intact
+// record (resync), so a damaged region costs only the records inside it.
+
+const char WAL_MAGIC[8] = {'E', 'C', 'W', 'A', 'L', '\r', '\n', '\x1a'};
+const uint32_t WAL_VERSION = 1;             // Record framing
+const uint32_t WAL_SCHEMA_VERSION = 1;      // SAMPLE payload layout
+const uint32_t WAL_RECORD_MAGIC = 0x52574345;   // "ECWR"
+const size_t WAL_TAIL_SCAN_BYTES = 64 * 1024;
+
+enum WalRecordType : uint16_t {
+    WAL_RECORD_SAMPLE = 1,
+    WAL_RECORD_SESSION = 2
+};
+
+struct WalFileHeader {
+    char     magic[8];
+    uint32_t version;           // WAL_VERSION
+    uint32_t schema_version;    // WAL_SCHEMA_VERSION
+    uint64_t session_id;        // Session that created the segment
+    int64_t  created_ns;
+    uint32_t header_size;       // Bytes before the first record
+    uint32_t header_crc;        // CRC-32 of the bytes above
+    uint8_t  reserved[24];
+};
+static_assert(sizeof(WalFileHeader) == 64, "WalFileHeader must be 64 bytes");
+
+struct WalRecordHeader {
+    uint32_t magic;
+    uint16_t type;
+    uint16_t length;            // Payload bytes
+    uint32_t crc32;
+};
+static_assert(sizeof(WalRecordHeader) == 12, "WalRecordHeader must be 12 bytes");
+
+// SAMPLE payload, schema version 1 (44 bytes, native little-endian)
+const uint16_t WAL_SAMPLE_PAYLOAD = 44;
+
+// SESSION payload: session_id u64, start_ns i64, schema_version u32
+const uint16_t WAL_SESSION_PAYLOAD = 20;
+
+inline uint32_t wal_header_crc(const WalFileHeader &hdr) {
+    return crc32_compute(&hdr, offsetof(WalFileHeader, header_crc));
+}
+
+inline uint32_t wal_record_crc(uint16_t type, uint16_t length, const uint8_t *payload) {
+    uint8_t tl[4];
+    memcpy(tl, &type, 2);
+    memcpy(tl + 2, &length, 2);
+    return crc32_update(crc32_update(0, tl, sizeof(tl)), payload, length);
+}
+
+inline void wal_encode_sample(const SampleRecord &rec, uint8_t *p) {
+    memcpy(p, &rec.timestamp_ns, 8);
+    memcpy(p + 8, rec.reg_temp, 4);
+    memcpy(p + 12, rec.reg_raw_ec, 4);
+    memcpy(p + 16, rec.reg_sensor_ec, 4);
+    memcpy(p + 20, &rec.temp, 4);
+    memcpy(p + 24, &rec.raw_ec, 4);
+    memcpy(p + 28, &rec.sensor_ec, 4);
+    memcpy(p + 32, &rec.smart_ec, 4);
+    memcpy(p + 36, &rec.k, 4);
+    memcpy(p + 40, &rec.flags, 4);
+}
+
+inline void wal_decode_sample(const uint8_t *p, SampleRecord *rec) {
+    memcpy(&rec->timestamp_ns, p, 8);
+    memcpy(rec->reg_temp, p + 8, 4);
+    memcpy(rec->reg_raw_ec, p + 12, 4);
+    memcpy(rec->reg_sensor_ec, p + 16, 4);
+    memcpy(&rec->temp, p + 20, 4);
+    memcpy(&rec->raw_ec, p + 24, 4);
+    memcpy(&rec->sensor_ec, p + 28, 4);
+    memcpy(&rec->smart_ec, p + 32, 4);
+    memcpy(&rec->k, p + 36, 4);
+    memcpy(&rec->flags, p + 40, 4);
+}
+
+// Size of the intact record at p (at most avail bytes), or 0
+inline size_t wal_record_at(const uint8_t *p, size_t avail, WalRecordHeader *out) {
+    if (avail < sizeof(WalRecordHeader)) return 0;
+    WalRecordHeader rh;
+    memcpy(&rh, p, sizeof(rh));
+    if (rh.magic != WAL_RECORD_MAGIC || avail - sizeof(rh) < rh.length) return 0;
+    if (rh.crc32 != wal_record_crc(rh.type, rh.length, p + sizeof(rh))) return 0;
+    *out = rh;
+    return sizeof(rh) + rh.length;
+}
+
+inline uint64_t wal_new_session_id() {
+    uint64_t id;
+    if (getrandom(&id, sizeof(id), 0) == static_cast<ssize_t>(sizeof(id))) return id;
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (static_cast<uint64_t>(ts.tv_sec) << 32) ^ static_cast<uint64_t>(ts.tv_nsec) ^
+           (static_cast<uint64_t>(getpid()) << 16);
+}
+
+// ===========================
+// WAL WRITER
+// ===========================
+// Same contract as the other sinks: append() buffers, flush() is one
+// write(), sync() is fdatasync(). Positions for the time index are the
+// byte offsets of SAMPLE records (skip is always 0).
+class WalLogWriter {
+public:
+    WalLogWriter() {}
+    ~WalLogWriter() { close(); }
+    WalLogWriter(const WalLogWriter &) = delete;
+    WalLogWriter &operator=(const WalLogWriter &) = delete;
+
+    bool open(const std::string &path) {
+        close();
+        session_id_ = wal_new_session_id();
+        if (!open_fd(path)) return false;
+
+        struct stat st;
+        fstat(fd_, &st);
+        if (st.st_size > 0 && st.st_size < static_cast<off_t>(sizeof(WalFileHeader))) {
+            // Crashed while creating the segment: nothing to keep
+            if (ftruncate(fd_, 0) == -1) return false;
+            st.st_size = 0;
+        }
+        if (st.st_size > 0 && !header_usable(st.st_size)) {
+            ::close(fd_);
+            fd_ = -1;
+            if (log_archive_segment(path, "incompatible or damaged WAL header").empty()) return false;
+            if (!open_fd(path)) return false;
+            st.st_size = 0;
+        }
+
+        pending_.clear();
+        if (st.st_size == 0) {
+            WalFileHeader hdr;
+            memset(&hdr, 0, sizeof(hdr));
+            memcpy(hdr.magic, WAL_MAGIC, sizeof(hdr.magic));
+            hdr.version = WAL_VERSION;
+            hdr.schema_version = WAL_SCHEMA_VERSION;
+            hdr.session_id = session_id_;
+            hdr.created_ns = now_ns();
+            hdr.header_size = sizeof(WalFileHeader);
+            hdr.header_crc = wal_header_crc(hdr);
+            pending_.append(reinterpret_cast<const char *>(&hdr), sizeof(hdr));
+            file_size_ = 0;
+            has_samples_ = false;
+        } else {
+            file_size_ = recover_tail(path, st.st_size);
+        }
+
+        uint8_t session[WAL_SESSION_PAYLOAD];
+        int64_t start_ns = now_ns();
+        memcpy(session, &session_id_, 8);
+        memcpy(session + 8, &start_ns, 8);
+        memcpy(session + 16, &WAL_SCHEMA_VERSION, 4);
+        append_record(WAL_RECORD_SESSION, session, sizeof(session));
+        return flush();
+    }
+
+    void append(const SampleRecord &rec) {
+        uint8_t payload[WAL_SAMPLE_PAYLOAD];
+        wal_encode_sample(rec, payload);
+        append_record(WAL_RECORD_SAMPLE, payload, sizeof(payload));
+        has_samples_ = true;
+    }
+
+    bool flush() {
+        if (fd_ == -1) return false;
+        const char *data = pending_.data();
+        size_t len = pending_.size();
+        bool ok = true;
+        while (len > 0) {
+            ssize_t n = ::write(fd_, data, len);
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                std::cerr << "❌ WAL write failed: " << strerror(errno) << std::endl;
+                ok = false;
+                break;
+            }
+            data += n;
+            len -= n;
+            file_size_ += n;
+        }
+        pending_.clear();
+        return ok;
+    }
+
+    bool sync() {
+        if (fd_ == -1) return false;
+        if (fdatasync(fd_) == -1) {
+            std::cerr << "❌ WAL fdatasync failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (fd_ == -1) return;
+        flush();
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+    bool is_open() const { return fd_ != -1; }
+    bool has_records() const { return has_samples_; }
+    uint64_t torn_bytes() const { return torn_bytes_; }
+    uint64_t session_id() const { return session_id_; }
+
+    void next_position(uint64_t *offset, uint32_t *skip) const {
+        *offset = file_size_ + pending_.size();
+        *skip = 0;
+    }
+
+private:
+    int fd_ = -1;
+    uint64_t file_size_ = 0;        // Bytes already handed to the OS
+    uint64_t torn_bytes_ = 0;       // Bytes cut by tail recovery on open
+    uint64_t session_id_ = 0;
+    bool has_samples_ = false;
+    std::string pending_;           // Records not yet handed to the OS
+
+    static int64_t now_ns() {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+    }
+
+    bool open_fd(const std::string &path) {
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+        if (fd_ == -1) {
+            std::cerr << "❌ Cannot open WAL " << path << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool header_usable(off_t size) {
+        WalFileHeader hdr;
+        return size >= static_cast<off_t>(sizeof(hdr)) &&
+               pread(fd_, &hdr, sizeof(hdr), 0) == static_cast<ssize_t>(sizeof(hdr)) &&
+               memcmp(hdr.magic, WAL_MAGIC, sizeof(hdr.magic)) == 0 &&
+               hdr.header_crc == wal_header_crc(hdr) &&
+               hdr.version == WAL_VERSION && hdr.schema_version == WAL_SCHEMA_VERSION &&
+               hdr.header_size == sizeof(WalFileHeader);
+    }
+
+    void append_record(uint16_t type, const uint8_t *payload, uint16_t length) {
+        WalRecordHeader rh;
+        rh.magic = WAL_RECORD_MAGIC;
+        rh.type = type;
+        rh.length = length;
+        rh.crc32 = wal_record_crc(type, length, payload);
+        pending_.append(reinterpret_cast<const char *>(&rh), sizeof(rh));
+        pending_.append(reinterpret_cast<const char *>(payload), length);
+    }
+
+    // Cut everything after the last intact record in the tail window.
+    // Returns the file size after recovery.
+    uint64_t recover_tail(const std::string &path, uint64_t size) {
+        uint64_t data_start = sizeof(WalFileHeader);
+        uint64_t start = size - data_start > WAL_TAIL_SCAN_BYTES ? size - WAL_TAIL_SCAN_BYTES : data_start;
+        std::vector<uint8_t> tail(size - start);
+        if (!tail.empty() &&
+            pread(fd_, tail.data(), tail.size(), start) != static_cast<ssize_t>(tail.size())) {
+            has_samples_ = true;
+            return size;
+        }
+
+        // Anything before the window holds samples or the window would
+        // start at the header
+        has_samples_ = start > data_start;
+        size_t keep = 0;
+        bool found = false;
+        for (size_t p = 0; p < tail.size();) {
+            WalRecordHeader rh;
+            size_t n = wal_record_at(tail.data() + p, tail.size() - p, &rh);
+            if (n == 0) {
+                p++;
+                continue;
+            }
+            if (rh.type == WAL_RECORD_SAMPLE) has_samples_ = true;
+            found = true;
+            p += n;
+            keep = p;
+        }
+
+        if (!found && start > data_start) {
+            std::cerr << "⚠️  " << path << ": no intact record in the last "
+                      << tail.size() << " bytes, not truncating" << std::endl;
+            has_samples_ = true;
+            return size;
+        }
+        uint64_t new_size = start + keep;
+        if (new_size == size) return size;
+
+        if (ftruncate(fd_, new_size) == -1) {
+            std::cerr << "⚠️  " << path << ": could not truncate torn tail: "
+                      << strerror(errno) << std::endl;
+            return size;
+        }
+        torn_bytes_ = size - new_size;
+        std::cerr << "⚠️  " << path << ": removed " << torn_bytes_
+                  << " byte(s) of a torn record at the tail" << std::endl;
+        return new_size;
+    }
+};
+
+// ===========================
+// WAL READER
+// ===========================
+// mmap's the whole file. visit() walks the records between two byte
+// offsets with resync, reporting samples with their offsets.
+struct WalScanStats {
+    uint64_t samples = 0;
+    uint64_t sessions = 0;
+    uint64_t skipped_bytes = 0;     // Bytes not covered by an intact record
+};
+
+class WalLogReader {
+public:
+    WalLogReader() {}
+    ~WalLogReader() { close(); }
+    WalLogReader(const WalLogReader &) = delete;
+    WalLogReader &operator=(const WalLogReader &) = delete;
+
+    bool open(const std::string &path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd == -1) {
+            std::cerr << "❌ Cannot open " << path << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        struct stat st;
+        fstat(fd, &st);
+        size_ = st.st_size;
+        if (size_ < sizeof(WalFileHeader)) {
+            std::cerr << "❌ " << path << ": too small to be a WAL" << std::endl;
+            ::close(fd);
+            return false;
+        }
+        void *map = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (map == MAP_FAILED) {
+            std::cerr << "❌ mmap failed for " << path << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        data_ = static_cast<const uint8_t *>(map);
+        madvise(map, size_, MADV_SEQUENTIAL);
+
+        memcpy(&header_, data_, sizeof(header_));
+        if (memcmp(header_.magic, WAL_MAGIC, sizeof(header_.magic)) != 0 ||
+            header_.header_crc != wal_header_crc(header_) || header_.version != WAL_VERSION ||
+            header_.header_size < sizeof(WalFileHeader) || header_.header_size > size_) {
+            std::cerr << "❌ " << path << ": not a WAL this tool can read" << std::endl;
+            close();
+            return false;
+        }
+        if (header_.schema_version != WAL_SCHEMA_VERSION) {
+            std::cerr << "❌ " << path << ": WAL schema version " << header_.schema_version
+                      << " (this tool reads " << WAL_SCHEMA_VERSION << ")" << std::endl;
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (data_) munmap(const_cast<uint8_t *>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    const WalFileHeader &header() const { return header_; }
+    size_t file_size() const { return size_; }
+
+    // fn(rec, offset) for every intact SAMPLE record starting in [begin, end)
+    template <typename Fn>
+    WalScanStats visit(uint64_t begin, uint64_t end, Fn &&fn) const {
+        WalScanStats stats;
+        size_t p = begin > header_.header_size ? begin : header_.header_size;
+        size_t stop = end < size_ ? end : size_;
+        SampleRecord rec;
+        while (p < stop) {
+            WalRecordHeader rh;
+            size_t n = wal_record_at(data_ + p, size_ - p, &rh);
+            if (n == 0) {
+                stats.skipped_bytes++;
+                p++;
+                continue;
+            }
+            if (rh.type == WAL_RECORD_SAMPLE && rh.length >= WAL_SAMPLE_PAYLOAD) {
+                wal_decode_sample(data_ + p + sizeof(rh), &rec);
+                fn(rec, static_cast<uint64_t>(p));
+                stats.samples++;
+            } else if (rh.type == WAL_RECORD_SESSION) {
+                stats.sessions++;
+            }
+            p += n;
+        }
+        return stats;
+    }
+
+private:
+    const uint8_t *data_ = nullptr;
+    size_t size_ = 0;
+    WalFileHeader header_;
+};
+
+#endif // EC_WAL_H
@@ -12,6 +12,27 @@
 #include <cerrno>
 #include <cstdlib>
 #include <termios.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "ec_sample.h"
+#include "ec_binlog.h"
+#include "ec_async_log.h"
+#include "ec_timestamp.h"
+#include "ec_flight_recorder.h"
+#include "ec_term_render.h"
+#include "ec_seqlock.h"
+#include "ec_pipeline.h"
+#include "ec_sinks.h"
+#include "ec_config.h"
+#include "ec_daemon.h"
+#include "ec_http_live.h"
+#include "ec_metrics.h"
+#include "ec_register_cache.h"
+#include "ec_register_watch.h"
 
 // ===========================
 // CALIBRATION CONSTANTS
@@ -26,33 +47,24 @@ enum CalibrationMode {
     CAL_MODE_NONE = 0,    // Skip calibration
     CAL_MODE_1 = 1,       // Mode 1: Register 13 = 2
     CAL_MODE_2 = 2,       // Mode 2: Register 28 = 12.880, Register 13 = 3
-    CAL_MODE_3 = 3        // Mode 3: TEST - Write K=190 to Register 16
+    CAL_MODE_3 = 3,       // Mode 3: TEST - Write K=190 to Register 16
+    CAL_MODE_STOP = -1    // Stop requested at the prompt (SIGINT/SIGTERM)
 };
 
 // ===========================
 // DYNAMIC COEFFICIENT LOOKUP
 // ===========================
-double get_dynamic_k(double temp) {
-    if (temp <= 5.0) {
-        return 0.0180;  // 1.80%
-    } else if (temp <= 10.0) {
-        return 0.0184;  // 1.84%
-    } else if (temp <= 15.0) {
-        return 0.0190;  // 1.90%
-    } else if (temp <= 25.0) {
-        return 0.0190;  // 1.90% (flat range)
-    } else if (temp <= 30.0) {
-        return 0.0192;  // 1.92%
-    } else {
-        return 0.0194;  // 1.94%
-    }
+// Tiers from the active configuration (ec_config.h); the built-in table is
+// 1.80% up to 5°C, 1.84% to 10°C, 1.90% to 25°C, 1.92% to 30°C, 1.94% above
+double get_dynamic_k(const LoggerConfig &config, double temp) {
+    return config.dynamic_k(temp);
 }
 
 // ===========================
 // SMART ALGORITHM
 // ===========================
-double calculate_smart_ec(double raw_ec, double temp) {
-    double k = get_dynamic_k(temp);
+double calculate_smart_ec(const LoggerConfig &config, double raw_ec, double temp) {
+    double k = get_dynamic_k(config, temp);
     // C25 = raw_ec / (1 + k * (temp - 25))
     return raw_ec / (1.0 + k * (temp - 25.0));
 }
@@ -128,16 +140,38 @@ float modbus_get_float_abcd(const uint16_t *src) {
 // This allows validation of IEEE 754 float conversion by logging the raw bytes.
 // Example: reg_high=0x4135 (16693), reg_low=0x1A86 (6790) → "41351A86"
 // You can verify this at: https://www.h-schmidt.net/FloatConverter/IEEE754.html
+// Each 4-bit nibble indexes the uppercase digit table (leading zeros kept,
+// exactly 4 hex characters per 16-bit value); the same helper writes the
+// CSV hex columns.
 std::string to_hex_string(uint16_t reg_high, uint16_t reg_low) {
-    std::stringstream ss;
-    // Use std::hex to switch to hexadecimal mode
-    // std::uppercase for capital letters (A-F)
-    // std::setfill('0') ensures leading zeros are preserved
-    // std::setw(4) ensures each 16-bit value outputs exactly 4 hex characters
-    ss << std::uppercase << std::hex << std::setfill('0')
-       << std::setw(4) << reg_high
-       << std::setw(4) << reg_low;
-    return ss.str();
+    const uint16_t regs[2] = {reg_high, reg_low};
+    return regs_to_hex(regs);
+}
+
+// ===========================
+// REGISTER CACHE
+// ===========================
+// Configuration registers served from memory (ec_register_cache.h); the
+// write functions below drop what they overwrite
+RegisterCache register_cache;
+
+// ===========================
+// METRICS
+// ===========================
+// Counters and gauges for /metrics and --metrics-file (ec_metrics.h),
+// updated with relaxed atomics from the acquisition loop (bus reads) and
+// the pipeline's sink stage (samples)
+LoggerMetrics logger_metrics;
+
+// modbus_read_registers, timed and counted
+int metered_read_registers(modbus_t *ctx, int addr, int nb, uint16_t *dest) {
+    auto start = std::chrono::steady_clock::now();
+    int rc = modbus_read_registers(ctx, addr, nb, dest);
+    int err = errno;
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    logger_metrics.record_read(rc, err, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    errno = err;
+    return rc;
 }
 
 // ===========================
@@ -149,7 +183,8 @@ bool write_integer_register(modbus_t *ctx, int reg_addr, uint16_t value) {
               << ": Value=" << value
               << " (0x" << std::hex << std::uppercase << value << std::dec << ")\n";
 
-    // Write the register
+    // Write the register (even a failed write may have reached the device)
+    register_cache.invalidate(reg_addr, 1);
     int rc = modbus_write_register(ctx, reg_addr, value);
     if (rc == -1) {
         std::cerr << "  [ERROR] Failed to write register " << reg_addr
@@ -197,6 +232,7 @@ bool write_float_register(modbus_t *ctx, int reg_addr, float value) {
               << ", Reg" << (reg_addr + 1) << "=0x" << reg_data[1] << std::dec << ")\n";
 
     // Write 2 consecutive registers (starting at reg_addr)
+    register_cache.invalidate(reg_addr, 2);
     int rc = modbus_write_registers(ctx, reg_addr, 2, reg_data);
     if (rc == -1) {
         std::cerr << "  [ERROR] Failed to write float to register " << reg_addr
@@ -289,7 +325,9 @@ bool execute_calibration(modbus_t *ctx, CalibrationMode mode) {
 // ===========================
 // GET CALIBRATION MODE FROM USER/ARGS
 // ===========================
-CalibrationMode get_calibration_mode(int argc, char* argv[]) {
+// Without --mode, asks on the terminal unless interactive is false
+// (--daemon), which means mode 0
+CalibrationMode get_calibration_mode(int argc, char* argv[], bool interactive, SignalChannel &signals) {
     // Check for command-line argument
     for (int i = 1; i < argc; i++) {
         std::string arg = argv[i];
@@ -309,11 +347,69 @@ CalibrationMode get_calibration_mode(int argc, char* argv[]) {
             std::cout << "  --mode 1    Calibration Mode 1: Register 13 = 2\n";
             std::cout << "  --mode 2    Calibration Mode 2: Register 28 = 12.880, Register 13 = 3\n";
             std::cout << "  --mode 3    TEST Mode: Write K=190 to Register 16 (test x10000 format)\n";
+            std::cout << "  --log-format csv|binary|gorilla|wal\n";
+            std::cout << "              Log sink format (default: csv)\n";
+            std::cout << "  --log-file PATH\n";
+            std::cout << "              Log file (default: ec_data_log.csv / .ecb / .ecg / .ecw)\n";
+            std::cout << "  --flush-every N   Write to the OS every N records (default: 1)\n";
+            std::cout << "  --flush-ms T      ...or at least every T ms (default: off)\n";
+            std::cout << "  --fsync-every N   fdatasync every N records (default: off)\n";
+            std::cout << "  --fsync-ms T      ...or at least every T ms (default: off)\n";
+            std::cout << "  --no-index        Do not maintain the LOG.idx time index\n";
+            std::cout << "  --no-rollups      Do not maintain the 1 min / 1 h rollup files\n";
+            std::cout << "  --rotate hourly|daily\n";
+            std::cout << "              Start a new log segment every local hour / day (default: off)\n";
+            std::cout << "  --rotate-size MB  ...or when the segment reaches MB megabytes (default: off)\n";
+            std::cout << "  --no-rotate-compress\n";
+            std::cout << "              Keep closed segments uncompressed (default: gzip)\n";
+            std::cout << "  --flight-recorder MIN\n";
+            std::cout << "              Keep the last MIN minutes of samples in a ring file (default: off)\n";
+            std::cout << "  --flight-file PATH  Ring file (default: ec_flight.ring)\n";
+            std::cout << "  --flight-snapshot MIN\n";
+            std::cout << "              Minutes saved to ec_flight.*.ecb on an anomaly (default: 10)\n";
+            std::cout << "  --no-ui           Headless: no dashboard (for daemon / service runs)\n";
+            std::cout << "  --config PATH     k tiers, reference standard, tolerance, poll_ms and sinks from\n";
+            std::cout << "                    a file; edits apply while running (see README)\n";
+            std::cout << "  --daemon          Service mode: --no-ui, no diagnostics monitor, no prompt\n";
+            std::cout << "                    (calibration only with --mode), SIGHUP reopens the logs\n";
+            std::cout << "  --ui-hz N         Dashboard refreshes per second (default: 2)\n";
+            std::cout << "  --http PORT       Serve live JSON / Server-Sent Events on PORT (default: off)\n";
+            std::cout << "  --http-bind ADDR  Address to listen on (default: 127.0.0.1)\n";
+            std::cout << "              Prometheus metrics are served at /metrics\n";
+            std::cout << "  --metrics-file PATH\n";
+            std::cout << "              Write metrics for node_exporter's textfile collector (*.prom)\n";
+            std::cout << "  --metrics-ms T    Metrics file refresh period in ms (default: 15000)\n";
+            std::cout << "  --watch LIST      Registers for the diagnostics view, ADDR[:TYPE[:LABEL]],...\n";
+            std::cout << "              TYPE: u16 (default), i16, hex, u32, float (default: 1,2,16,13,28:float)\n";
+            std::cout << "  --watch-file PATH ...or one entry per line from a file\n";
+            std::cout << "  --watch-ms T      Diagnostics refresh period in ms (default: 1000)\n";
+            std::cout << "  --watch-gap N     Unused registers a block read may span (default: 4)\n";
+            std::cout << "  --reg-ttl LIST    Cache registers for SECONDS, ADDR[-ADDR]=SECONDS,...\n";
+            std::cout << "              (default: 8,13,16,28-29=300; 0 = always read)\n";
+            std::cout << "  --no-reg-cache    Read every register from the device every time\n";
+            std::cout << "  --ts-precision s|ms|ns\n";
+            std::cout << "              Fractional seconds in CSV and on screen (default: s)\n";
+            std::cout << "  --compress off|deadband|sdt\n";
+            std::cout << "              Drop samples reconstructible within tolerance (default: off)\n";
+            std::cout << "  --compress-temp E Temperature tolerance in °C (default: 0.02)\n";
+            std::cout << "  --compress-ec E   EC tolerance in mS/cm (default: 0.005)\n";
+            std::cout << "  --compress-max-gap S\n";
+            std::cout << "              Keep at least one sample every S seconds (default: 300)\n";
+            std::cout << "  --sink SPEC       Extra output, repeatable: csv:PATH, bin:PATH, jsonl (stdout),\n";
+            std::cout << "              udp:HOST:PORT, modbus-tcp:[ADDR:]PORT, mqtt:HOST[:PORT][,key=value...]\n";
+            std::cout << "              (mqtt keys: topic, sensor, qos, window, payload=json|binary, spool,\n";
+            std::cout << "              spool-mb, client); append @block to wait instead of dropping\n";
+            std::cout << "              when that output falls behind\n";
             std::cout << "  --help      Show this help message\n\n";
             exit(0);
         }
     }
 
+    if (!interactive) {
+        std::cout << "  No --mode given: skipping calibration.\n";
+        return CAL_MODE_NONE;
+    }
+
     // Interactive mode selection
     std::cout << "\n";
     std::cout << "╔═══════════════════════════════════════════════════════════════════════╗\n";
@@ -324,9 +420,13 @@ CalibrationMode get_calibration_mode(int argc, char* argv[]) {
     std::cout << "║  [2] Mode 2: Write Register 28 = 12.880 (float) + Register 13 = 3     ║\n";
     std::cout << "║  [3] Mode 3: TEST - Write K=190 to Register 16 (test x10000 format)   ║\n";
     std::cout << "╚═══════════════════════════════════════════════════════════════════════╝\n";
-    std::cout << "\n  Enter mode (0/1/2/3): ";
+    std::cout << "\n  Enter mode (0/1/2/3): " << std::flush;
 
-    int choice;
+    int sig;
+    while ((sig = signals.wait_readable(STDIN_FILENO)) != 0) {
+        if (is_stop_signal(sig)) return CAL_MODE_STOP;
+    }
+    int choice = -1;
     std::cin >> choice;
 
     if (choice >= 0 && choice <= 3) {
@@ -338,37 +438,189 @@ CalibrationMode get_calibration_mode(int argc, char* argv[]) {
 }
 
 // ===========================
-// CLEAR SCREEN (Cross-platform)
+// LOGGER OPTIONS FROM ARGS
 // ===========================
-void clear_screen() {
-    #ifdef _WIN32
-        system("cls");
-    #else
-        system("clear");
-    #endif
-}
+struct LoggerOptions {
+    LogFormat log_format = LOG_FORMAT_CSV;
+    std::string log_file;     // Empty = default for the format
+    DurabilityPolicy durability;
+    IngestCompressionConfig compression;
+    bool time_index = true;   // Maintain LOG.idx for ec_log_tool query
+    bool rollups = true;      // Maintain the LOG.1m/.1h.ecr rollup tiers
+    TimestampPrecision ts_precision = TIMESTAMP_SECONDS;
+    RotationPolicy rotation;
+    double flight_minutes = 0;               // Flight recorder ring length (0 = off)
+    double flight_snapshot_minutes = 10;     // Saved on each trigger
+    std::string flight_file = "ec_flight.ring";
+    bool ui = true;                          // Live dashboard on its own thread
+    bool daemon = false;                     // No prompts, no dashboard, line-buffered output
+    double ui_hz = 2;
+    int http_port = 0;                       // Live HTTP/SSE endpoint (0 = off)
+    std::string http_bind = "127.0.0.1";
+    std::string metrics_file;                // Textfile-collector output (empty = off)
+    int metrics_ms = METRICS_TEXTFILE_DEFAULT_MS;
+    std::vector<WatchEntry> watch;           // Diagnostics registers (empty = default list)
+    int watch_ms = 1000;
+    int watch_gap = WATCH_DEFAULT_GAP;
+    bool reg_cache = true;                   // Serve configuration registers from memory
+    std::string reg_ttl;                     // --reg-ttl overrides of the default TTLs
+    std::vector<SinkSpec> sinks;             // Extra outputs besides the main log
+    std::string config_file;                 // Hot-reloaded settings (empty = built-in)
+};
 
-// ===========================
-// GET TIMESTAMP
-// ===========================
-std::string get_timestamp() {
-    time_t now = time(0);
-    struct tm tstruct;
-    char buf[80];
-    tstruct = *localtime(&now);
-    strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tstruct);
-    return buf;
+LoggerOptions get_logger_options(int argc, char* argv[]) {
+    LoggerOptions opts;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--log-format" && i + 1 < argc) {
+            std::string fmt = argv[++i];
+            if (fmt == "csv") {
+                opts.log_format = LOG_FORMAT_CSV;
+            } else if (fmt == "binary") {
+                opts.log_format = LOG_FORMAT_BINARY;
+            } else if (fmt == "gorilla") {
+                opts.log_format = LOG_FORMAT_GORILLA;
+            } else if (fmt == "wal") {
+                opts.log_format = LOG_FORMAT_WAL;
+            } else {
+                std::cerr << "  Unknown log format '" << fmt << "'. Using csv.\n";
+            }
+        } else if (arg == "--log-file" && i + 1 < argc) {
+            opts.log_file = argv[++i];
+        } else if (arg == "--flush-every" && i + 1 < argc) {
+            opts.durability.flush_every_records = std::atoi(argv[++i]);
+        } else if (arg == "--flush-ms" && i + 1 < argc) {
+            opts.durability.flush_interval_ms = std::atoi(argv[++i]);
+        } else if (arg == "--fsync-every" && i + 1 < argc) {
+            opts.durability.sync_every_records = std::atoi(argv[++i]);
+        } else if (arg == "--fsync-ms" && i + 1 < argc) {
+            opts.durability.sync_interval_ms = std::atoi(argv[++i]);
+        } else if (arg == "--no-index") {
+            opts.time_index = false;
+        } else if (arg == "--no-rollups") {
+            opts.rollups = false;
+        } else if (arg == "--rotate" && i + 1 < argc) {
+            std::string every = argv[++i];
+            if (every == "hourly") {
+                opts.rotation.interval = ROTATE_HOURLY;
+            } else if (every == "daily") {
+                opts.rotation.interval = ROTATE_DAILY;
+            } else if (every == "off") {
+                opts.rotation.interval = ROTATE_NEVER;
+            } else {
+                std::cerr << "  Unknown rotation interval '" << every << "'. Not rotating by time.\n";
+            }
+        } else if (arg == "--rotate-size" && i + 1 < argc) {
+            opts.rotation.max_bytes = static_cast<uint64_t>(std::atof(argv[++i]) * 1024 * 1024);
+        } else if (arg == "--no-rotate-compress") {
+            opts.rotation.compress = false;
+        } else if (arg == "--flight-recorder" && i + 1 < argc) {
+            opts.flight_minutes = std::atof(argv[++i]);
+        } else if (arg == "--flight-file" && i + 1 < argc) {
+            opts.flight_file = argv[++i];
+        } else if (arg == "--flight-snapshot" && i + 1 < argc) {
+            opts.flight_snapshot_minutes = std::atof(argv[++i]);
+        } else if (arg == "--watch" && i + 1 < argc) {
+            parse_watch_list(argv[++i], opts.watch);
+        } else if (arg == "--watch-file" && i + 1 < argc) {
+            load_watch_file(argv[++i], opts.watch);
+        } else if (arg == "--watch-ms" && i + 1 < argc) {
+            opts.watch_ms = std::max(50, std::atoi(argv[++i]));
+        } else if (arg == "--watch-gap" && i + 1 < argc) {
+            opts.watch_gap = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--reg-ttl" && i + 1 < argc) {
+            if (!opts.reg_ttl.empty()) opts.reg_ttl += ",";
+            opts.reg_ttl += argv[++i];
+        } else if (arg == "--no-reg-cache") {
+            opts.reg_cache = false;
+        } else if (arg == "--no-ui") {
+            opts.ui = false;
+        } else if (arg == "--config" && i + 1 < argc) {
+            opts.config_file = argv[++i];
+        } else if (arg == "--daemon") {
+            opts.daemon = true;
+            opts.ui = false;
+        } else if (arg == "--ui-hz" && i + 1 < argc) {
+            opts.ui_hz = std::atof(argv[++i]);
+        } else if (arg == "--http" && i + 1 < argc) {
+            opts.http_port = std::atoi(argv[++i]);
+        } else if (arg == "--http-bind" && i + 1 < argc) {
+            opts.http_bind = argv[++i];
+        } else if (arg == "--metrics-file" && i + 1 < argc) {
+            opts.metrics_file = argv[++i];
+        } else if (arg == "--metrics-ms" && i + 1 < argc) {
+            opts.metrics_ms = std::max(1000, std::atoi(argv[++i]));
+        } else if (arg == "--ts-precision" && i + 1 < argc) {
+            std::string prec = argv[++i];
+            if (prec == "s") {
+                opts.ts_precision = TIMESTAMP_SECONDS;
+            } else if (prec == "ms") {
+                opts.ts_precision = TIMESTAMP_MILLIS;
+            } else if (prec == "ns") {
+                opts.ts_precision = TIMESTAMP_NANOS;
+            } else {
+                std::cerr << "  Unknown timestamp precision '" << prec << "'. Using s.\n";
+            }
+        } else if (arg == "--compress" && i + 1 < argc) {
+            std::string mode = argv[++i];
+            if (mode == "off") {
+                opts.compression.mode = INGEST_COMPRESS_OFF;
+            } else if (mode == "deadband") {
+                opts.compression.mode = INGEST_COMPRESS_DEADBAND;
+            } else if (mode == "sdt") {
+                opts.compression.mode = INGEST_COMPRESS_SWINGING_DOOR;
+            } else {
+                std::cerr << "  Unknown compression mode '" << mode << "'. Using off.\n";
+            }
+        } else if (arg == "--compress-temp" && i + 1 < argc) {
+            opts.compression.temp_tolerance = std::atof(argv[++i]);
+        } else if (arg == "--compress-ec" && i + 1 < argc) {
+            opts.compression.ec_tolerance = std::atof(argv[++i]);
+        } else if (arg == "--compress-max-gap" && i + 1 < argc) {
+            opts.compression.max_gap_s = std::atof(argv[++i]);
+        } else if (arg == "--sink" && i + 1 < argc) {
+            SinkSpec spec;
+            if (parse_sink_spec(argv[++i], spec)) {
+                opts.sinks.push_back(spec);
+            } else {
+                std::cerr << "  Ignoring --sink " << argv[i] << "\n";
+            }
+        }
+    }
+
+    if (opts.watch.empty()) opts.watch = default_watch_list();
+
+    if (opts.log_file.empty()) {
+        switch (opts.log_format) {
+            case LOG_FORMAT_BINARY:  opts.log_file = "ec_data_log.ecb"; break;
+            case LOG_FORMAT_GORILLA: opts.log_file = "ec_data_log.ecg"; break;
+            case LOG_FORMAT_WAL:     opts.log_file = "ec_data_log.ecw"; break;
+            default:                 opts.log_file = "ec_data_log.csv"; break;
+        }
+    }
+    return opts;
 }
 
 // ===========================
 // DISPLAY SENSOR DIAGNOSTIC REGISTERS (REAL-TIME LOOP)
 // ===========================
-void display_sensor_diagnostics(modbus_t *ctx) {
+// Shows the register watch list (ec_register_watch.h), read in as few
+// block transactions as the list allows, every refresh_ms. Configuration
+// registers come from register_cache while their TTL lasts. Returns false
+// if SIGINT/SIGTERM arrived (the terminal is restored either way).
+bool display_sensor_diagnostics(modbus_t *ctx, const std::vector<WatchEntry> &watch_list,
+                                int refresh_ms, int max_gap, SignalChannel &signals) {
     int loop_count = 0;
+    TimestampFormatter ts_format;
+    char timestamp[TIMESTAMP_MAX_CHARS];
+    TerminalRenderer screen;
+    RegisterWatch watch;
+    watch.set(watch_list, max_gap);
 
     std::cout << "\n  Starting real-time diagnostic monitor...\n";
     std::cout << "  Press ENTER to stop monitoring and proceed to calibration.\n\n";
-    sleep(2);
+    bool stopped = is_stop_signal(signals.wait_until(sample_clock_now().monotonic_ns + 2000000000LL));
 
     // Set stdin to non-blocking mode
     struct termios oldt, newt;
@@ -379,73 +631,27 @@ void display_sensor_diagnostics(modbus_t *ctx) {
     newt.c_cc[VTIME] = 0;
     tcsetattr(STDIN_FILENO, TCSANOW, &newt);
 
-    while (true) {
+    while (!stopped) {
         loop_count++;
-        clear_screen();
-
-        std::cout << "┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓\n";
-        std::cout << "┃         SENSOR DIAGNOSTIC REGISTERS (REAL-TIME)                   ┃\n";
-        std::cout << "┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛\n\n";
-
-        std::cout << "  Time: " << get_timestamp() << "  |  Updates: " << loop_count << "\n\n";
-
-        uint16_t reg_value;
-        uint16_t reg_data[2];
-
-        // Read Register 1
-        if (modbus_read_registers(ctx, 1, 1, &reg_value) != -1) {
-            std::cout << "  Register  1 = " << std::setw(5) << reg_value
-                      << "  (0x" << std::hex << std::uppercase << std::setfill('0')
-                      << std::setw(4) << reg_value << std::dec << std::setfill(' ') << ")\n";
-        } else {
-            std::cout << "  Register  1 = [READ ERROR]\n";
-        }
-
-        // Read Register 2
-        if (modbus_read_registers(ctx, 2, 1, &reg_value) != -1) {
-            std::cout << "  Register  2 = " << std::setw(5) << reg_value
-                      << "  (0x" << std::hex << std::uppercase << std::setfill('0')
-                      << std::setw(4) << reg_value << std::dec << std::setfill(' ') << ")\n";
-        } else {
-            std::cout << "  Register  2 = [READ ERROR]\n";
-        }
-
-        // Read Register 16
-        if (modbus_read_registers(ctx, 16, 1, &reg_value) != -1) {
-            std::cout << "  Register 16 = " << std::setw(5) << reg_value
-                      << "  (0x" << std::hex << std::uppercase << std::setfill('0')
-                      << std::setw(4) << reg_value << std::dec << std::setfill(' ') << ")\n";
-        } else {
-            std::cout << "  Register 16 = [READ ERROR]\n";
-        }
+        SampleClock clock = sample_clock_now();
+        watch.poll(ctx, register_cache, clock.monotonic_ns);
 
-        std::cout << "\n  ─── Calibration Registers ───\n\n";
+        std::ostream &out = screen.begin_frame();
+        out << "┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓\n";
+        out << "┃         SENSOR DIAGNOSTIC REGISTERS (REAL-TIME)                   ┃\n";
+        out << "┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛\n\n";
 
-        // Register 13 (calibration mode)
-        if (modbus_read_registers(ctx, 13, 1, &reg_value) != -1) {
-            std::cout << "  Register 13 = " << std::setw(5) << reg_value
-                      << "  (0x" << std::hex << std::uppercase << std::setfill('0')
-                      << std::setw(4) << reg_value << std::dec << std::setfill(' ')
-                      << ")  <- Calibration Mode\n";
-        } else {
-            std::cout << "  Register 13 = [READ ERROR]  <- Calibration Mode\n";
-        }
+        ts_format.format(clock.realtime_ns, timestamp);
+        out << "  Time: " << timestamp << "  |  Updates: " << loop_count
+            << "  |  Reads: " << watch.transactions() << " (" << watch.cached() << " cached)\n\n";
 
-        // Register 28 as float (calibration coefficient)
-        if (modbus_read_registers(ctx, 28, 2, reg_data) != -1) {
-            float coeff = modbus_get_float_abcd(reg_data);
-            std::cout << "  Register 28 = " << std::fixed << std::setprecision(3) << coeff
-                      << "  (Hex: " << to_hex_string(reg_data[0], reg_data[1])
-                      << ")  <- Calibration Coefficient\n";
-        } else {
-            std::cout << "  Register 28 = [READ ERROR]  <- Calibration Coefficient\n";
-        }
+        watch.print(out);
 
-        std::cout << "\n┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄\n";
-        std::cout << "  Use these values to verify sensor state.\n";
-        std::cout << "  >>> Press ENTER to proceed to calibration mode selection <<<\n";
+        out << "\n┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄\n";
+        out << "  Use these values to verify sensor state. Changed values are highlighted.\n";
+        out << "  >>> Press ENTER to proceed to calibration mode selection <<<\n";
 
-        std::cout.flush();
+        screen.end_frame();
 
         // Check if user pressed a key
         char c;
@@ -455,13 +661,18 @@ void display_sensor_diagnostics(modbus_t *ctx) {
             }
         }
 
-        sleep(1);  // Update every 1 second
+        int64_t deadline = clock.monotonic_ns + static_cast<int64_t>(refresh_ms) * 1000000LL;
+        int sig;
+        while ((sig = signals.wait_until(deadline)) != 0) {
+            if (is_stop_signal(sig)) stopped = true;
+        }
     }
 
     // Restore terminal settings
     tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
 
     std::cout << "\n  Diagnostic monitoring stopped.\n\n";
+    return !stopped;
 }
 
 // ===========================
@@ -484,129 +695,264 @@ std::string get_temp_condition(double temp) {
 // ===========================
 // TEACHER MODE: DISPLAY EDUCATIONAL DASHBOARD
 // ===========================
-void display_teacher_dashboard(double temp, double raw_ec, double sensor_ec, double smart_ec, 
+void display_teacher_dashboard(TerminalRenderer &screen,
+                               double temp, double raw_ec, double sensor_ec, double smart_ec,
                                double k_used, int sample_count, const std::string &port,
-                               const std::string &hex_temp, const std::string &hex_raw_ec) {
-    clear_screen();
+                               const char *timestamp,
+                               const char *hex_temp, const char *hex_raw_ec,
+                               const std::string &log_file, const LogWriterStats &log_stats,
+                               bool show_compression, const LoggerConfig &config) {
+    std::ostream &out = screen.begin_frame();
     
     // Calculate validation metrics
-    const double STANDARD_VALUE = 12.88;
+    const double STANDARD_VALUE = config.standard_ec;
     double sensor_error = fabs(sensor_ec - STANDARD_VALUE);
     double smart_error = fabs(smart_ec - STANDARD_VALUE);
     double improvement = sensor_error - smart_error;
     
     // Determine pass/fail
-    const double TOLERANCE = 0.10;  // ±0.10 mS/cm tolerance
+    const double TOLERANCE = config.tolerance;  // ±0.10 mS/cm unless configured
     bool sensor_pass = sensor_error <= TOLERANCE;
     bool smart_pass = smart_error <= TOLERANCE;
     
-    std::cout << "╔═══════════════════════════════════════════════════════════════════════╗\n";
-    std::cout << "║           🎓 TEACHER MODE: LIVE ALGORITHM VALIDATION 🎓              ║\n";
-    std::cout << "╚═══════════════════════════════════════════════════════════════════════╝\n\n";
+    out << "╔═══════════════════════════════════════════════════════════════════════╗\n";
+    out << "║           🎓 TEACHER MODE: LIVE ALGORITHM VALIDATION 🎓              ║\n";
+    out << "╚═══════════════════════════════════════════════════════════════════════╝\n\n";
     
-    std::cout << "  📡 Port: " << port << " | Samples: " << sample_count 
-              << " | Time: " << get_timestamp() << "\n\n";
+    out << "  📡 Port: " << port << " | Samples: " << sample_count 
+        << " | Time: " << timestamp << "\n\n";
     
     // ========== SECTION A: THE "WHY" (LOGIC DISPLAY) ==========
-    std::cout << "┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓\n";
-    std::cout << "┃ 📚 SECTION A: THE \"WHY\" - Understanding the Logic                   ┃\n";
-    std::cout << "┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛\n\n";
+    out << "┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓\n";
+    out << "┃ 📚 SECTION A: THE \"WHY\" - Understanding the Logic                   ┃\n";
+    out << "┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛\n\n";
     
-    std::cout << "  Current Condition:\n";
-    std::cout << "    🌡️  Measured Temperature = " << std::fixed << std::setprecision(2) 
-              << temp << "°C  (0x" << hex_temp << ")  →  " << get_temp_condition(temp) << "\n\n";
+    out << "  Current Condition:\n";
+    out << "    🌡️  Measured Temperature = " << std::fixed << std::setprecision(2) 
+        << temp << "°C  (0x" << hex_temp << ")  →  " << get_temp_condition(temp) << "\n\n";
     
-    std::cout << "  Decision Logic:\n";
-    std::cout << "    🧠 Therefore, using Dynamic Coefficient k = " << std::setprecision(4) 
-              << k_used << " (" << (k_used * 100) << "%)\n";
-    std::cout << "    🔴 Sensor uses FIXED Coefficient k = 0.0200 (2.00%) ← WRONG!\n\n";
+    out << "  Decision Logic:\n";
+    out << "    🧠 Therefore, using Dynamic Coefficient k = " << std::setprecision(4) 
+        << k_used << " (" << (k_used * 100) << "%)\n";
+    out << "    🔴 Sensor uses FIXED Coefficient k = 0.0200 (2.00%) ← WRONG!\n\n";
     
-    std::cout << "  Why This Matters:\n";
-    std::cout << "    • At low temps, sensor OVER-compensates (k too high)\n";
-    std::cout << "    • Our algorithm adjusts k based on actual calibration data\n";
-    std::cout << "    • Result: More accurate readings across temperature range\n\n";
+    out << "  Why This Matters:\n";
+    out << "    • At low temps, sensor OVER-compensates (k too high)\n";
+    out << "    • Our algorithm adjusts k based on actual calibration data\n";
+    out << "    • Result: More accurate readings across temperature range\n\n";
     
     // ========== SECTION B: THE MATH (FORMULA VISUALIZATION) ==========
-    std::cout << "┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓\n";
-    std::cout << "┃ 🧮 SECTION B: THE MATH - Live Formula Calculation                   ┃\n";
-    std::cout << "┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛\n\n";
+    out << "┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓\n";
+    out << "┃ 🧮 SECTION B: THE MATH - Live Formula Calculation                   ┃\n";
+    out << "┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛\n\n";
     
-    std::cout << "  Temperature Compensation Formula:\n\n";
-    std::cout << "    C₂₅ = Raw_EC / (1 + k × (Temp - 25))\n\n";
+    out << "  Temperature Compensation Formula:\n\n";
+    out << "    C₂₅ = Raw_EC / (1 + k × (Temp - 25))\n\n";
     
-    std::cout << "  Sensor's Calculation (FIXED k=0.02):\n";
-    std::cout << "    " << std::setprecision(2) << sensor_ec << " = " << raw_ec 
-              << " / (1 + 0.0200 × (" << temp << " - 25.0))\n";
-    std::cout << "    " << sensor_ec << " = " << raw_ec << " / " 
-              << std::setprecision(4) << (1.0 + 0.02 * (temp - 25.0)) << "\n\n";
+    out << "  Sensor's Calculation (FIXED k=0.02):\n";
+    out << "    " << std::setprecision(2) << sensor_ec << " = " << raw_ec 
+        << " / (1 + 0.0200 × (" << temp << " - 25.0))\n";
+    out << "    " << sensor_ec << " = " << raw_ec << " / " 
+        << std::setprecision(4) << (1.0 + 0.02 * (temp - 25.0)) << "\n\n";
     
-    std::cout << "  Smart Algorithm (DYNAMIC k=" << std::setprecision(4) << k_used << "):\n";
-    std::cout << "    " << std::setprecision(2) << smart_ec << " = " << raw_ec 
-              << " / (1 + " << std::setprecision(4) << k_used << " × (" 
-              << std::setprecision(2) << temp << " - 25.0))\n";
-    std::cout << "    " << smart_ec << " = " << raw_ec << " / " 
-              << std::setprecision(4) << (1.0 + k_used * (temp - 25.0)) << "\n\n";
+    out << "  Smart Algorithm (DYNAMIC k=" << std::setprecision(4) << k_used << "):\n";
+    out << "    " << std::setprecision(2) << smart_ec << " = " << raw_ec 
+        << " / (1 + " << std::setprecision(4) << k_used << " × ("
+        << std::setprecision(2) << temp << " - 25.0))\n";
+    out << "    " << smart_ec << " = " << raw_ec << " / " 
+        << std::setprecision(4) << (1.0 + k_used * (temp - 25.0)) << "\n\n";
     
     // ========== SECTION C: THE VERDICT (VALIDATION) ==========
-    std::cout << "┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓\n";
-    std::cout << "┃ ⚖️  SECTION C: THE VERDICT - Validation Against Standard            ┃\n";
-    std::cout << "┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛\n\n";
+    out << "┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓\n";
+    out << "┃ ⚖️  SECTION C: THE VERDICT - Validation Against Standard            ┃\n";
+    out << "┗━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┛\n\n";
     
-    std::cout << "  Standard Reference: 12.88 mS/cm @ 25°C\n";
-    std::cout << "  Tolerance: ±" << TOLERANCE << " mS/cm\n\n";
+    out << "  Standard Reference: " << std::setprecision(2) << STANDARD_VALUE << " mS/cm @ 25°C\n";
+    out << "  Tolerance: ±" << std::setprecision(4) << TOLERANCE << " mS/cm\n\n";
     
-    std::cout << "  Distance from Standard:\n";
-    std::cout << "    🔴 Sensor Error:  " << std::setprecision(4) << std::setw(8) << sensor_error 
-              << " mS/cm  ";
+    out << "  Distance from Standard:\n";
+    out << "    🔴 Sensor Error:  " << std::setprecision(4) << std::setw(8) << sensor_error 
+        << " mS/cm  ";
     if (sensor_pass) {
-        std::cout << "✅ PASS\n";
+        out << "✅ PASS\n";
     } else {
-        std::cout << "❌ FAIL (exceeds tolerance)\n";
+        out << "❌ FAIL (exceeds tolerance)\n";
     }
     
-    std::cout << "    🟢 Smart Error:   " << std::setw(8) << smart_error << " mS/cm  ";
+    out << "    🟢 Smart Error:   " << std::setw(8) << smart_error << " mS/cm  ";
     if (smart_pass) {
-        std::cout << "✅ PASS\n";
+        out << "✅ PASS\n";
     } else {
-        std::cout << "❌ FAIL (exceeds tolerance)\n";
+        out << "❌ FAIL (exceeds tolerance)\n";
     }
     
-    std::cout << "\n  Improvement Score:\n";
-    std::cout << "    📈 Error Reduction: " << std::setprecision(4) << improvement << " mS/cm";
+    out << "\n  Improvement Score:\n";
+    out << "    📈 Error Reduction: " << std::setprecision(4) << improvement << " mS/cm";
     
     if (improvement > 0) {
-        std::cout << "  ✅ Smart Algorithm is BETTER!\n";
+        out << "  ✅ Smart Algorithm is BETTER!\n";
     } else if (improvement < 0) {
-        std::cout << "  ⚠️  Sensor Default is better (rare)\n";
+        out << "  ⚠️  Sensor Default is better (rare)\n";
     } else {
-        std::cout << "  ➡️  No difference\n";
+        out << "  ➡️  No difference\n";
     }
     
-    std::cout << "    📊 Improvement: " << std::setprecision(1) 
-              << (sensor_error > 0 ? (improvement / sensor_error * 100.0) : 0.0) << "%\n\n";
+    out << "    📊 Improvement: " << std::setprecision(1) 
+        << (sensor_error > 0 ? (improvement / sensor_error * 100.0) : 0.0) << "%\n\n";
     
     // ========== SUMMARY BOX ==========
-    std::cout << "┌───────────────────────────────────────────────────────────────────────┐\n";
-    std::cout << "│                         📊 QUICK SUMMARY                              │\n";
-    std::cout << "├───────────────────────────────────────────────────────────────────────┤\n";
-    std::cout << "│  🌡️  Temperature:     " << std::setprecision(2) << std::setw(10) << temp << " °C";
-    std::cout << "  [Hex: " << hex_temp << "]             │\n";
-    std::cout << "│  📊 Raw EC:           " << std::setw(10) << raw_ec << " mS/cm";
-    std::cout << "  [Hex: " << hex_raw_ec << "]             │\n";
-    std::cout << "│  🔴 Sensor Output:    " << std::setw(10) << sensor_ec << " mS/cm  ";
-    std::cout << (sensor_pass ? "✅ PASS" : "❌ FAIL") << "                    │\n";
-    std::cout << "│  🟢 Smart Output:     " << std::setw(10) << smart_ec << " mS/cm  ";
-    std::cout << (smart_pass ? "✅ PASS" : "❌ FAIL") << "                    │\n";
-    std::cout << "└───────────────────────────────────────────────────────────────────────┘\n\n";
-    
-    std::cout << "  💾 Logging to CSV: ec_data_log.csv\n";
-    std::cout << "  ⏹️  Press Ctrl+C to stop and analyze data\n\n";
+    out << "┌───────────────────────────────────────────────────────────────────────┐\n";
+    out << "│                         📊 QUICK SUMMARY                              │\n";
+    out << "├───────────────────────────────────────────────────────────────────────┤\n";
+    out << "│  🌡️  Temperature:     " << std::setprecision(2) << std::setw(10) << temp << " °C";
+    out << "  [Hex: " << hex_temp << "]             │\n";
+    out << "│  📊 Raw EC:           " << std::setw(10) << raw_ec << " mS/cm";
+    out << "  [Hex: " << hex_raw_ec << "]             │\n";
+    out << "│  🔴 Sensor Output:    " << std::setw(10) << sensor_ec << " mS/cm  ";
+    out << (sensor_pass ? "✅ PASS" : "❌ FAIL") << "                    │\n";
+    out << "│  🟢 Smart Output:     " << std::setw(10) << smart_ec << " mS/cm  ";
+    out << (smart_pass ? "✅ PASS" : "❌ FAIL") << "                    │\n";
+    out << "└───────────────────────────────────────────────────────────────────────┘\n\n";
+    
+    out << "  💾 Logging to: " << log_file << "  (queued: " << log_stats.depth
+        << ", dropped: " << log_stats.dropped << ")\n";
+    if (show_compression) {
+        out << "  🗜️  Ingest compression: kept " << log_stats.written << " of "
+            << log_stats.written + log_stats.compressed << " samples\n";
+    }
+    out << "  ⏹️  Press Ctrl+C to stop and analyze data\n\n";
+    screen.end_frame();
+}
+
+// ===========================
+// DASHBOARD THREAD
+// ===========================
+// The dashboard runs on its own thread at its own refresh rate, so a slow
+// terminal or SSH link can never stretch the sampling period. The
+// acquisition loop only publishes each sample into a seqlock (a memcpy,
+// never a wait); the UI thread takes the newest one whenever it redraws.
+// The HTTP endpoint (ec_http_live.h) reads the same seqlock.
+class DashboardThread {
+public:
+    ~DashboardThread() { stop(); }
+
+    void start(const Seqlock<LiveSample> *live, const std::string &port, const std::string &log_file,
+               TimestampPrecision ts_precision, bool show_compression,
+               const AsyncLogWriter *log_writer, const ConfigStore *config, double refresh_hz) {
+        live_ = live;
+        config_ = config;
+        port_ = port;
+        log_file_ = log_file;
+        ts_format_.set_precision(ts_precision);
+        show_compression_ = show_compression;
+        log_writer_ = log_writer;
+        period_ = std::chrono::microseconds(static_cast<int64_t>(1e6 / (refresh_hz > 0 ? refresh_hz : 1)));
+        running_ = true;
+        thread_ = std::thread(&DashboardThread::run, this);
+    }
+
+    // Something else wrote to the terminal: repaint fully next time
+    void invalidate() { invalidated_.store(true, std::memory_order_relaxed); }
+
+    void stop() {
+        if (!thread_.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+        }
+        wake_.notify_one();
+        thread_.join();
+    }
+
+private:
+    const Seqlock<LiveSample> *live_ = nullptr;
+    std::atomic<bool> invalidated_{false};
+    std::string port_, log_file_;
+    TimestampFormatter ts_format_;
+    bool show_compression_ = false;
+    const AsyncLogWriter *log_writer_ = nullptr;
+    const ConfigStore *config_ = nullptr;
+    std::chrono::microseconds period_{1000000};
+    TerminalRenderer screen_;
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool running_ = false;
+
+    void run() {
+        LiveSample s;
+        char timestamp[TIMESTAMP_MAX_CHARS];
+        char hex_temp[9], hex_raw_ec[9];
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (wake_.wait_for(lock, period_, [this] { return !running_; })) return;
+            }
+            if (live_->load(s) == 0) continue;   // No sample yet
+            if (invalidated_.exchange(false, std::memory_order_relaxed)) screen_.invalidate();
+
+            ts_format_.format(s.rec.timestamp_ns, timestamp);
+            *csv_put_hex_regs(hex_temp, s.rec.reg_temp) = '\0';
+            *csv_put_hex_regs(hex_raw_ec, s.rec.reg_raw_ec) = '\0';
+            display_teacher_dashboard(screen_, s.rec.temp, s.rec.raw_ec, s.rec.sensor_ec, s.rec.smart_ec,
+                                      s.rec.k, s.sample_count, port_, timestamp, hex_temp, hex_raw_ec,
+                                      log_file_, log_writer_->stats(), show_compression_, *config_->current());
+        }
+    }
+};
+
+// ===========================
+// FINAL SUMMARY
+// ===========================
+// Printed once everything is drained and closed, so the numbers are final
+void print_run_summary(int64_t run_ns, const PipelineStats &pipeline, const LogWriterStats &log,
+                       const std::vector<SinkStats> &sinks) {
+    uint64_t reads = logger_metrics.reads.load();
+    std::cout << "\n📋 Run summary\n";
+    std::cout << "  Run time:      " << std::fixed << std::setprecision(1) << run_ns / 1e9 << " s\n";
+    std::cout << "  Samples:       " << logger_metrics.samples.load() << " logged, "
+              << pipeline.dropped << " dropped at the pipeline\n";
+    std::cout << "  Modbus reads:  " << reads << " (" << logger_metrics.read_failures.load() << " failed, "
+              << logger_metrics.read_timeouts.load() << " timeouts), mean "
+              << std::setprecision(1) << (reads ? logger_metrics.modbus_latency.sum_ns() / 1e6 / reads : 0.0)
+              << " ms\n";
+    std::cout << "  Pipeline:      mean " << std::setprecision(3)
+              << (pipeline.e2e_count ? pipeline.e2e_sum_ns / 1e6 / pipeline.e2e_count : 0.0) << " ms, max "
+              << pipeline.e2e_max_ns / 1e6 << " ms bus read to sinks\n";
+    std::cout << "  Log:           " << log.written << " written, " << log.dropped << " dropped, "
+              << log.write_errors << " write errors, " << log.rotations << " rotations, "
+              << log.reopens << " reopens\n";
+    for (const SinkStats &sink : sinks) {
+        std::cout << "  Sink " << sink.name << ": " << sink.records << " written, " << sink.dropped
+                  << " dropped, " << sink.errors << " failed batches";
+        if (sink.backlog_bytes > 0) std::cout << ", " << sink.backlog_bytes << " bytes still spooled";
+        std::cout << "\n";
+    }
+    std::cout << std::endl;
 }
 
 // ===========================
 // MAIN PROGRAM
 // ===========================
 int main(int argc, char* argv[]) {
+    LoggerOptions opts = get_logger_options(argc, argv);
+    if (opts.daemon) {
+        setvbuf(stdout, NULL, _IOLBF, 0);   // One line per journal entry, even through a pipe
+    }
+
+    // Settings that may change during the run (ec_config.h). A bad file
+    // at startup is fatal; later edits that fail to parse are ignored.
+    ConfigStore config;
+    if (!opts.config_file.empty()) {
+        LoggerConfig loaded;
+        if (!load_logger_config(opts.config_file, loaded)) {
+            std::cerr << "❌ Invalid config file " << opts.config_file << std::endl;
+            return -1;
+        }
+        config.publish(loaded);
+    }
+
     // Step 1: Auto-discover the sensor
     std::string port = find_sensor_port();
     
@@ -632,16 +978,34 @@ int main(int argc, char* argv[]) {
         return -1;
     }
     
+    // SIGINT/SIGTERM/SIGHUP arrive on a descriptor from here on
+    // (ec_daemon.h); must happen before the first thread starts
+    SignalChannel signals;
+    signals.open();
+
     std::cout << "\n🚀 Connected to sensor on " << port << std::endl;
     std::cout << "📊 Starting Smart Logger..." << std::endl;
-    std::cout << "📝 Data will be logged to: ec_data_log.csv" << std::endl;
+    std::cout << "📝 Data will be logged to: " << opts.log_file << std::endl;
     std::cout << "   Press Ctrl+C to stop.\n" << std::endl;
 
     // Step 2.5: Display sensor diagnostic registers
-    display_sensor_diagnostics(ctx);
+    if (opts.reg_cache) {
+        register_cache_defaults(register_cache);
+        parse_register_ttls(opts.reg_ttl, register_cache);
+    }
+    bool stopping = false;
+    if (!opts.daemon) {
+        stopping = !display_sensor_diagnostics(ctx, opts.watch, opts.watch_ms, opts.watch_gap, signals);
+    }
 
     // Step 2.6: Get calibration mode
-    CalibrationMode cal_mode = get_calibration_mode(argc, argv);
+    CalibrationMode cal_mode = stopping ? CAL_MODE_STOP : get_calibration_mode(argc, argv, !opts.daemon, signals);
+    if (cal_mode == CAL_MODE_STOP) {
+        std::cout << "\n  Stopped before logging started.\n";
+        modbus_close(ctx);
+        modbus_free(ctx);
+        return 0;
+    }
 
     // Step 2.7: Execute calibration (after connection, before main loop)
     if (!execute_calibration(ctx, cal_mode)) {
@@ -650,93 +1014,220 @@ int main(int argc, char* argv[]) {
 
     sleep(1);
     
-    // Step 3: Create/Open CSV file
-    std::ofstream csv_file;
-    bool file_exists = (access("ec_data_log.csv", F_OK) != -1);
-    
-    csv_file.open("ec_data_log.csv", std::ios::app);
+    // Step 3: Create/Open log file and start the background writer
+    AsyncLogWriter log_writer;
+    if (!log_writer.open(opts.log_format, opts.log_file, opts.time_index, opts.rollups)) {
+        modbus_close(ctx);
+        modbus_free(ctx);
+        return -1;
+    }
+    log_writer.set_timestamp_precision(opts.ts_precision);
+    log_writer.set_rotation(opts.rotation);
+    log_writer.start(opts.durability, opts.compression);
+
+    // Optional flight recorder: every sample, last N minutes, in a ring file
+    // (sized for the poll rate at startup)
+    FlightRecorder flight;
+    if (opts.flight_minutes > 0) {
+        uint64_t slots = static_cast<uint64_t>(opts.flight_minutes * 60e9 / config.current()->period_ns);
+        if (slots == 0) slots = 1;
+        flight.open(opts.flight_file, slots, static_cast<int64_t>(opts.flight_snapshot_minutes * 60e9));
+    }
     
-    // Write header if new file (with hex validation columns)
-    if (!file_exists) {
-        csv_file << "Timestamp,Temperature,Hex_Temp,Raw_EC,Hex_Raw_EC,Sensor_Default_EC,Smart_Calc_EC,Deviation\n";
+    // Extra outputs (--sink), each on its own queue and thread
+    SinkFanout sinks;
+    sinks.set_timestamp_precision(opts.ts_precision);
+    for (const SinkSpec &spec : opts.sinks) {
+        if (sinks.add_sink(spec)) {
+            std::cout << "  ➜ Sink " << spec.name << (spec.policy == SINK_POLICY_BLOCK ? " (block)" : "")
+                      << std::endl;
+        }
+    }
+    sinks.start();
+    sinks.set_config_sinks(config.current()->sinks);
+
+    // Newest sample for the dashboard and the HTTP endpoint
+    Seqlock<LiveSample> live;
+    LiveSample live_sample;
+
+    // Live dashboard on its own thread, unless headless
+    DashboardThread ui;
+    if (opts.ui) {
+        ui.start(&live, port, opts.log_file, opts.ts_precision, opts.compression.mode != INGEST_COMPRESS_OFF,
+                 &log_writer, &config, opts.ui_hz);
+    } else {
+        std::cout << "  Running headless (--no-ui), logging to " << opts.log_file << std::endl;
+    }
+
+    // Optional browser view and metrics: never touch the bus, only read the
+    // snapshot and the atomic counters
+    AcquisitionPipeline pipeline;
+    LiveHttpServer http;
+    MetricsTextfileWriter metrics_file;
+    auto render_metrics = [&]() {
+        LogWriterStats log_stats = log_writer.stats();
+        HttpServerStats http_stats = http.stats();
+        PipelineStats pipeline_stats = pipeline.stats();
+        std::vector<SinkStats> sink_stats = sinks.stats();
+        return format_prometheus_metrics(logger_metrics, &log_stats, http.running() ? &http_stats : nullptr,
+                                         &pipeline_stats, &sink_stats);
+    };
+    if (opts.http_port > 0) {
+        http.add_route("/metrics", "text/plain; version=0.0.4; charset=utf-8", render_metrics);
+        if (http.start(opts.http_bind, opts.http_port, &live, opts.ts_precision)) {
+            std::cout << "  🌐 Live data on http://" << opts.http_bind << ":" << opts.http_port
+                      << "/  (/current, /events, /metrics)" << std::endl;
+            ui.invalidate();
+        }
+    }
+    if (!opts.metrics_file.empty()) {
+        metrics_file.start(opts.metrics_file, opts.metrics_ms, render_metrics);
     }
     
-    // Step 4: Main data acquisition loop
-    uint16_t reg_data[2];
+    // Step 4: Pipeline stages (ec_pipeline.h). Acquisition below only talks
+    // to the bus; each stage after it runs on its own thread
+
+    // Decode: register words to floats
+    auto decode_stage = [](PipelineItem &item) {
+        if (item.failed) return;
+        SampleRecord &rec = item.rec;
+        rec.temp = modbus_get_float_abcd(rec.reg_temp);
+        rec.raw_ec = modbus_get_float_abcd(rec.reg_raw_ec);
+        rec.sensor_ec = modbus_get_float_abcd(rec.reg_sensor_ec);
+    };
+
+    // Compensate: Smart EC, the k it used and the validation metrics, all
+    // from one configuration version (a reload lands between samples)
+    auto compensate_stage = [&](PipelineItem &item) {
+        if (item.failed) return;
+        SampleRecord &rec = item.rec;
+        const LoggerConfig &cfg = *config.current();
+        double smart_ec = calculate_smart_ec(cfg, rec.raw_ec, rec.temp);
+        double k_used = get_dynamic_k(cfg, rec.temp);
+        item.distance_sensor = fabs(rec.sensor_ec - cfg.standard_ec);
+        item.distance_smart = fabs(smart_ec - cfg.standard_ec);
+        rec.smart_ec = static_cast<float>(smart_ec);
+        rec.k = static_cast<float>(k_used);
+        rec.standard_ec = static_cast<float>(cfg.standard_ec);
+        if (item.distance_sensor <= cfg.tolerance) rec.flags |= SAMPLE_FLAG_SENSOR_PASS;
+        if (item.distance_smart <= cfg.tolerance) rec.flags |= SAMPLE_FLAG_SMART_PASS;
+    };
+
+    // Sinks: the dashboard snapshot, metrics, the flight recorder, the
+    // writer thread (rollups, compression, formatting and disk I/O happen
+    // there) and the --sink fan-out (one batch per drained pipeline batch)
+    bool smart_was_pass = true;
+    auto sink_stage = [&](PipelineItem &item) {
+        const SampleRecord &rec = item.rec;
+        if (item.failed) {
+            const char *what = item.failed == PIPELINE_FAILED_TEMP ? "temperature"
+                             : item.failed == PIPELINE_FAILED_RAW_EC ? "raw EC" : "sensor EC";
+            std::cerr << "⚠️  Failed to read " << what << std::endl;
+            flight.trigger(rec.timestamp_ns, "Modbus read failed");
+            ui.invalidate();
+            return;
+        }
+        double improvement_score = item.distance_sensor - item.distance_smart;
+        logger_metrics.record_sample(rec, item.distance_sensor, item.distance_smart, improvement_score);
+        flight.record(rec);
+        live_sample.rec = rec;
+        live_sample.sample_count = item.sample_count;
+        live.store(live_sample);
+        log_writer.push(rec);
+        sinks.add(live_sample);
+
+        // Anomaly: Smart EC just left the tolerance band
+        bool smart_pass = (rec.flags & SAMPLE_FLAG_SMART_PASS) != 0;
+        if (smart_was_pass && !smart_pass) flight.trigger(rec.timestamp_ns, "Smart EC out of tolerance");
+        smart_was_pass = smart_pass;
+    };
+    pipeline.start(decode_stage, compensate_stage, sink_stage, [&]() { sinks.publish(); });
+
+    // Reload --config whenever it is saved. New sinks are opened here, on
+    // the watcher thread; the sink stage just switches to them
+    ConfigWatcher config_watcher;
+    if (!opts.config_file.empty()) {
+        config_watcher.start(opts.config_file, &config, [&](const LoggerConfig *cfg) {
+            if (cfg) {
+                std::cout << "  🔄 Config reloaded from " << opts.config_file << " (version " << cfg->generation
+                          << ")" << std::endl;
+                sinks.set_config_sinks(cfg->sinks);
+            } else {
+                std::cerr << "⚠️  Config file rejected, keeping version " << config.current()->generation
+                          << std::endl;
+            }
+            ui.invalidate();
+        });
+    }
+    sd_notify_status("READY=1");
+
+    // Step 5: Acquisition loop (Modbus reads only, never waits on a stage).
+    // The wait between samples is also where signals are handled: SIGHUP
+    // reopens the log files (after logrotate moved them), SIGINT/SIGTERM
+    // end the loop after the current sample
+    PipelineItem item;
     int loop_count = 0;
-    std::string hex_temp, hex_raw_ec;  // Raw hex strings for data validation
-    
-    while (true) {
+    int64_t run_start_ns = sample_clock_now().monotonic_ns;
+
+    while (!stopping) {
         loop_count++;
         
-        // Read Temperature (Reg 60-61)
-        double temp = 0.0;
-        if (modbus_read_registers(ctx, 60, 2, reg_data) != -1) {
-            // Capture raw hex BEFORE float conversion for validation
-            hex_temp = to_hex_string(reg_data[0], reg_data[1]);
-            temp = modbus_get_float_abcd(reg_data);
-        } else {
-            std::cerr << "⚠️  Failed to read temperature" << std::endl;
-            sleep(1);
-            continue;
-        }
-        
-        // Read Raw EC (Reg 45-46)
-        double raw_ec = 0.0;
-        if (modbus_read_registers(ctx, 45, 2, reg_data) != -1) {
-            // Capture raw hex BEFORE float conversion for validation
-            hex_raw_ec = to_hex_string(reg_data[0], reg_data[1]);
-            raw_ec = modbus_get_float_abcd(reg_data);
-        } else {
-            std::cerr << "⚠️  Failed to read raw EC" << std::endl;
-            sleep(1);
-            continue;
+        // One clock reading per sample: the dashboard and every log show the
+        // same time, and the next cycle starts one period after this one
+        SampleClock clock = sample_clock_now();
+        memset(&item, 0, sizeof(item));
+        item.rec.timestamp_ns = clock.realtime_ns;
+        item.acquired_ns = clock.monotonic_ns;
+        item.sample_count = loop_count;
+
+        // Raw register words only; decoding happens in the next stage and
+        // the hex columns are validated against exactly these words
+        if (metered_read_registers(ctx, 60, 2, item.rec.reg_temp) == -1) {            // Temperature
+            item.failed = PIPELINE_FAILED_TEMP;
+        } else if (metered_read_registers(ctx, 45, 2, item.rec.reg_raw_ec) == -1) {   // Raw EC
+            item.failed = PIPELINE_FAILED_RAW_EC;
+        } else if (metered_read_registers(ctx, 41, 2, item.rec.reg_sensor_ec) == -1) {
+            item.failed = PIPELINE_FAILED_SENSOR_EC;   // Sensor's internal EC - "The Wrong Value"
         }
-        
-        // Read Sensor's Internal EC (Reg 41-42) - "The Wrong Value"
-        double sensor_ec = 0.0;
-        if (modbus_read_registers(ctx, 41, 2, reg_data) != -1) {
-            sensor_ec = modbus_get_float_abcd(reg_data);
-        } else {
-            std::cerr << "⚠️  Failed to read sensor EC" << std::endl;
-            sleep(1);
-            continue;
+        pipeline.submit(item);
+
+        // Wait for the next tick (absolute, so read time does not
+        // accumulate); after a failed read, one period from now. The
+        // period is read each time so a reloaded poll_ms applies at once
+        int64_t period_ns = config.current()->period_ns;
+        int64_t deadline = item.failed ? sample_clock_now().monotonic_ns + period_ns
+                                       : clock.monotonic_ns + period_ns;
+        int sig;
+        while ((sig = signals.wait_until(deadline)) != 0) {
+            if (sig == SIGHUP) {
+                log_writer.request_reopen();
+                sinks.reopen();
+                std::cout << "  🔄 SIGHUP: reopening log files" << std::endl;
+            } else if (is_stop_signal(sig)) {
+                stopping = true;
+                break;
+            }
         }
-        
-        // Calculate Smart EC
-        double smart_ec = calculate_smart_ec(raw_ec, temp);
-        double k_used = get_dynamic_k(temp);
-        double deviation = sensor_ec - smart_ec;
-        
-        // Calculate validation metrics
-        const double STANDARD_VALUE = 12.88;
-        double distance_sensor = fabs(sensor_ec - STANDARD_VALUE);
-        double distance_smart = fabs(smart_ec - STANDARD_VALUE);
-        double improvement_score = distance_sensor - distance_smart;
-        
-        // Display educational dashboard (with hex validation data)
-        display_teacher_dashboard(temp, raw_ec, sensor_ec, smart_ec, k_used, loop_count, port,
-                                  hex_temp, hex_raw_ec);
-        
-        // Log to CSV with hex validation columns
-        csv_file << get_timestamp() << ","
-                 << temp << ","
-                 << hex_temp << ","
-                 << raw_ec << ","
-                 << hex_raw_ec << ","
-                 << sensor_ec << ","
-                 << smart_ec << ","
-                 << deviation << "\n";
-        csv_file.flush();
-        
-        // Wait 1 second before next reading
-        sleep(1);
     }
-    
-    // Cleanup (unreachable, but good practice)
-    csv_file.close();
+
+    // Orderly shutdown, upstream first so every queue drains into the next:
+    // pipeline stages -> sink fan-out and log writer -> files. Metrics and
+    // HTTP go last so they report the final counters while it happens.
+    sd_notify_status("STOPPING=1");
+    int64_t run_ns = sample_clock_now().monotonic_ns - run_start_ns;
+    config_watcher.stop();
+    ui.stop();
+    std::cout << "\n🛑 Stopping: draining queues..." << std::endl;
+    pipeline.stop();
+    sinks.stop();
+    flight.close();
+    log_writer.stop();
+    metrics_file.stop();
+    http.stop();
     modbus_close(ctx);
     modbus_free(ctx);
-    
+
+    print_run_summary(run_ns, pipeline.stats(), log_writer.stats(), sinks.stats());
+    signals.close();
     return 0;
 }